@@ -1,4 +1,5 @@
 #include "BgAgent.h"
+#include "BgBoard.h"
 
 BgAgent::BgAgent(fs::path path)
 {
@@ -9,52 +10,69 @@ BgAgent::BgAgent(fs::path path)
 	m_curBoard = NULL;
 	m_isFixed = true;
 	m_needsInvertedEval = false;
+	m_incrementalEval = false;
+	m_sparseEval = false;
 
 	m_path = path /= "agents";
 }
 
-void BgAgent::evalOver(const BgBoard *board, BgReward& reward)
+void BgAgent::evalOver(const BgBoardView& board, BgReward& reward)
 {
 	BgEval::Instance()->EvalOver(board, reward, m_bgv);
 }
 
-void BgAgent::evalHypergammon1(const BgBoard *board, BgReward& reward)
+void BgAgent::evalHypergammon1(const BgBoardView& board, BgReward& reward)
 {
 	BgEval::Instance()->EvalHypergammon1(board, reward);
 }
 
-void BgAgent::evalHypergammon2(const BgBoard *board, BgReward& reward)
+void BgAgent::evalHypergammon2(const BgBoardView& board, BgReward& reward)
 {
 	BgEval::Instance()->EvalHypergammon2(board, reward);
 }
 
-void BgAgent::evalHypergammon3(const BgBoard *board, BgReward& reward)
+void BgAgent::evalHypergammon3(const BgBoardView& board, BgReward& reward)
 {
 	BgEval::Instance()->EvalHypergammon3(board, reward);
 }
 
-void BgAgent::evalBearoff2(const BgBoard *board, BgReward& reward)
+void BgAgent::evalBearoff2(const BgBoardView& board, BgReward& reward)
 {
 	BgEval::Instance()->EvalBearoff2(board, reward);
 }
 
-void BgAgent::evalBearoffTS(const BgBoard *board, BgReward& reward)
+void BgAgent::evalBearoffTS(const BgBoardView& board, BgReward& reward)
 {
 	BgEval::Instance()->EvalBearoffTS(board, reward);
 }
 
-void BgAgent::evalBearoff1(const BgBoard *board, BgReward& reward)
+void BgAgent::evalBearoff1(const BgBoardView& board, BgReward& reward)
 {
 	BgEval::Instance()->EvalBearoff1(board, reward);
 }
 
-void BgAgent::evalBearoffOS(const BgBoard *board, BgReward& reward)
+void BgAgent::evalBearoffOS(const BgBoardView& board, BgReward& reward)
 {
 	BgEval::Instance()->EvalBearoffOS(board, reward);
 }
 
-void BgAgent::evaluatePosition(const BgBoard *board, positionclass& pc, BgReward& reward)
+void BgAgent::evaluatePositions(const BgBoardView *aBoards, positionclass *apc, BgReward *arReward, int cPositions)
 {
+	for(int i = 0; i < cPositions; i++)
+		evaluatePosition(aBoards[i], apc[i], arReward[i]);
+}
+
+void BgAgent::evaluatePosition(const BgBoardView& board, positionclass& pc, BgReward& reward)
+{
+	AuchKey auch;
+	const bool fCached = m_evalCache.get() && isNetClass(pc);
+	if(fCached)
+	{
+		auch = board.PositionKey();
+		if(m_evalCache->Lookup(auch, evalVersion(), reward))
+			return;
+	}
+
 	switch(pc)
 	{
 	case CLASS_OVER:
@@ -93,4 +111,7 @@ void BgAgent::evaluatePosition(const BgBoard *board, positionclass& pc, BgReward
 	default:
 		throw std::exception("Unknown class. How did we get here?");
 	}
+
+	if(fCached)
+		m_evalCache->Store(auch, evalVersion(), reward);
 }
@@ -11,6 +11,7 @@ namespace fs = boost::filesystem;
 #include "BgReward.h"
 #include "BgEval.h"
 #include "BgMove.h"
+#include "BgEvalCache.h"
 
 class BgAgent
 {
@@ -27,19 +28,24 @@ public:
 	virtual void doMove(const bgmove& pm) {}
 	void setCurrentBoard(const BgBoard *board) {m_curBoard = board;}
 	
-	virtual void evaluatePosition(const BgBoard *board, positionclass& pc, BgReward& reward);
-	virtual void evalOver(const BgBoard *board, BgReward& reward);
-	virtual void evalHypergammon1(const BgBoard *board, BgReward& reward);
-	virtual void evalHypergammon2(const BgBoard *board, BgReward& reward);
-	virtual void evalHypergammon3(const BgBoard *board, BgReward& reward);
-	virtual void evalBearoff2(const BgBoard *board, BgReward& reward);
-	virtual void evalBearoffTS(const BgBoard *board, BgReward& reward);
-	virtual void evalBearoff1(const BgBoard *board, BgReward& reward);
-	virtual void evalBearoffOS(const BgBoard *board, BgReward& reward);
-	virtual void evalRace(const BgBoard *board, BgReward& reward) {throw std::exception("not implemented");}
-	virtual void evalCrashed(const BgBoard *board, BgReward& reward) {throw std::exception("not implemented");}
-	virtual void evalContact(const BgBoard *board, BgReward& reward) {throw std::exception("not implemented");}
+	virtual void evaluatePosition(const BgBoardView& board, positionclass& pc, BgReward& reward);
+	//evaluates cPositions boards at once, e.g. all candidates of a turn;
+	//the default falls back to evaluatePosition for each of them
+	virtual void evaluatePositions(const BgBoardView *aBoards, positionclass *apc, BgReward *arReward, int cPositions);
+	virtual void evalOver(const BgBoardView& board, BgReward& reward);
+	virtual void evalHypergammon1(const BgBoardView& board, BgReward& reward);
+	virtual void evalHypergammon2(const BgBoardView& board, BgReward& reward);
+	virtual void evalHypergammon3(const BgBoardView& board, BgReward& reward);
+	virtual void evalBearoff2(const BgBoardView& board, BgReward& reward);
+	virtual void evalBearoffTS(const BgBoardView& board, BgReward& reward);
+	virtual void evalBearoff1(const BgBoardView& board, BgReward& reward);
+	virtual void evalBearoffOS(const BgBoardView& board, BgReward& reward);
+	virtual void evalRace(const BgBoardView& board, BgReward& reward) {throw std::exception("not implemented");}
+	virtual void evalCrashed(const BgBoardView& board, BgReward& reward) {throw std::exception("not implemented");}
+	virtual void evalContact(const BgBoardView& board, BgReward& reward) {throw std::exception("not implemented");}
 	
+	static bool isNetClass(positionclass pc) {return pc == CLASS_RACE || pc == CLASS_CRASHED || pc == CLASS_CONTACT;}
+
 	bool isLearnMode() const {return m_learnMode;}
 	void setLearnMode(bool learn) {m_learnMode = learn;}
 	//fixed means it's unable to learn
@@ -47,20 +53,46 @@ public:
 	bool needsInvertedEval() const {return m_needsInvertedEval;}
 	bool supportsSanityCheck() const {return m_supportsSanityCheck;}
 	void setSanityCheck(bool sc) {m_supportsSanityCheck = sc;}
+	//evaluate the positions of a batch from the first one's hidden layer;
+	//off by default, the values then depend on which position heads the
+	//batch and so on the cache and the threads
+	bool isIncrementalEval() const {return m_incrementalEval;}
+	void setIncrementalEval(bool incremental) {m_incrementalEval = incremental;}
+	//evaluate from the non-zero inputs only where the inputs allow it
+	bool isSparseEval() const {return m_sparseEval;}
+	void setSparseEval(bool sparse) {m_sparseEval = sparse;}
+	//evaluate the nets with nBits (8 or 16) bit integer weights, 0 for the
+	//floats; false when the agent has no integer evaluation
+	virtual bool setQuantized(unsigned int nBits) {return !nBits;}
+
+	//cheap scores for the pruning filter, higher is better for the side
+	//that made the move; only positions of the net classes are scored
+	virtual bool hasPruning() const {return false;}
+	virtual void prunePositions(const BgBoardView *aBoards, const positionclass *apc, float arScore[], int cPositions) {}
 
+	//evaluations may run on several threads at once
+	virtual bool isReentrant() const {return false;}
 	virtual bool isCloneable() const {return false;}
 	virtual BgAgent *clone() {return NULL;}
 	virtual void load() {}
 	virtual void save() {}
 
+	//cache of the network evaluations, NULL when the agent does not cache
+	const BgEvalCache *getEvalCache() const {return m_evalCache.get();}
+	void clearEvalCache() {if(m_evalCache.get()) m_evalCache->Clear();}
+
 protected:
-	bool m_learnMode, m_supportsSanityCheck, m_isFixed, m_needsInvertedEval;
+	bool m_learnMode, m_supportsSanityCheck, m_isFixed, m_needsInvertedEval, m_incrementalEval, m_sparseEval;
 	std::string m_fullName;
 	int m_playedGames;
 	fs::path m_path;
 	bgvariation m_bgv;
 
 	const BgBoard *m_curBoard;
+
+	std::auto_ptr<BgEvalCache> m_evalCache;
+	//identifies the weights behind the cached evaluations
+	virtual unsigned int evalVersion() const {return 0;}
 };
 
 #endif
@@ -1,31 +1,154 @@
 #include "FannFA.h"
 #include <assert.h>
+#include <string.h>
+#include "BgCommon.h"
 
 FannFA::FannFA()
 {
 	m_ann = NULL;
 	m_numInputs = 0;
 	m_numOutputs = 0;
+	m_sparse = NULL;
+	m_sparseVersion = 0;
+	m_quantBits = 0;
+	m_quantMaxInput = 1.0f;
+	m_quant = NULL;
+	m_quantVersion = 0;
 }
 
 FannFA::FannFA(std::shared_ptr<FANN::neural_net> ann)
 {
+	m_sparse = NULL;
+	m_sparseVersion = 0;
+	m_quantBits = 0;
+	m_quantMaxInput = 1.0f;
+	m_quant = NULL;
+	m_quantVersion = 0;
 	SetANN(ann);
 }
 
 FannFA::~FannFA()
 {
+	ClearBuffers();
+}
+
+FannFA::runcontext FannFA::AcquireContext()
+{
+	runcontext t = {NULL, NULL};
+#pragma omp critical(FannFAContexts)
+	if(!m_contexts.empty())
+	{
+		t = m_contexts.back();
+		m_contexts.pop_back();
+	}
+	if(t.ctx)
+		return t;
+
+	t.ctx = m_ann->create_context();
+	t.inc = m_ann->create_incremental();
+	if(!t.ctx || !t.inc)
+	{
+		fann_destroy_context(t.ctx);
+		fann_destroy_incremental(t.inc);
+		throw std::exception("can't allocate FANN buffers");
+	}
+	return t;
+}
+
+void FannFA::ReleaseContext(const runcontext& t)
+{
+#pragma omp critical(FannFAContexts)
+	m_contexts.push_back(t);
+}
+
+void FannFA::ClearBuffers()
+{
+	for(size_t i = 0; i < m_contexts.size(); i++)
+	{
+		fann_destroy_context(m_contexts[ i ].ctx);
+		fann_destroy_incremental(m_contexts[ i ].inc);
+	}
+	m_contexts.clear();
+	fann_destroy_sparse(m_sparse);
+	m_sparse = NULL;
+	m_sparseVersion = 0;
+	//the integer copy is made again for the new network
+	fann_destroy_quant(m_quant);
+	m_quant = NULL;
+	m_quantVersion = 0;
+}
+
+const struct fann_sparse *FannFA::Sparse()
+{
+	//the weights only change between evaluations, never during them
+	bool fFailed = false;
+#pragma omp critical(FannFASparse)
+	if(m_sparseVersion != getVersion())
+	{
+		if(!m_sparse)
+			m_sparse = m_ann->create_sparse();
+		else
+			m_ann->update_sparse(m_sparse);
+		if(m_sparse)
+			m_sparseVersion = getVersion();
+		else
+			fFailed = true;
+	}
+	if(fFailed)
+		throw std::exception("can't allocate FANN buffers");
+	return m_sparse;
+}
+
+const struct fann_quant *FannFA::Quant()
+{
+	bool fFailed = false;
+#pragma omp critical(FannFAQuant)
+	if(m_quantVersion != getVersion())
+	{
+		fann_destroy_quant(m_quant);
+		m_quant = m_ann->create_quant(m_quantBits, m_quantMaxInput);
+		if(m_quant)
+			m_quantVersion = getVersion();
+		else
+			fFailed = true;
+	}
+	if(fFailed)
+		throw std::exception("can't quantize the FANN network");
+	return m_quant;
+}
+
+bool FannFA::setQuantized(unsigned int nBits, float rMaxInput)
+{
+	if(!nBits && !m_quantBits)
+		return true;
+	fann_destroy_quant(m_quant);
+	m_quant = NULL;
+	m_quantVersion = 0;
+	m_quantBits = 0;
+	//the evaluation caches must not mix the rewards of both
+	updateVersion();
+	if(!nBits)
+		return true;
+
+	m_quant = m_ann->create_quant(nBits, rMaxInput);
+	if(!m_quant)
+		return false;
+	m_quantBits = nBits;
+	m_quantMaxInput = rMaxInput;
+	m_quantVersion = getVersion();
+	return true;
 }
 
 void FannFA::SetANN(std::shared_ptr<FANN::neural_net> ann)
 {
 	assert(ann.get() != NULL);
+	ClearBuffers();
 	m_ann = ann;
-	m_ann->can_use_avx();
-	m_ann->can_use_sse();
+	m_ann->select_isa();
 
 	m_numInputs = m_ann->get_num_input();
 	m_numOutputs = m_ann->get_num_output();
+	updateVersion();
 }
 
 BgReward FannFA::GetReward(const std::vector<float> &input)
@@ -33,14 +156,10 @@ BgReward FannFA::GetReward(const std::vector<float> &input)
 	assert(m_numInputs + 1 == input.size());
 	BgReward res;
 	
-	float *output = NULL;
-	if(m_ann->isAvxOk())
-		output = m_ann->run_avx(&input[0]);
-	else
-	if(m_ann->isSseOk())
-		output = m_ann->run_sse(&input[0]);
-	else
-		output = m_ann->run(&input[0]);
+	contextlease lease(*this);
+	if(m_quantBits)
+		return QuantReward(&input[0], Quant(), lease.ctx());
+	const float *output = m_ann->run_dispatch(&input[0], lease.ctx());
 
 	for(int i = 0; i < std::min(BgReward::NN_SIZE, m_numOutputs); i++)
 		res[i] = output[i];
@@ -48,19 +167,118 @@ BgReward FannFA::GetReward(const std::vector<float> &input)
 	return res;	
 }
 
+BgReward FannFA::QuantReward(const float *input, const struct fann_quant *quant, struct fann_context *ctx) const
+{
+	const float *output = m_ann->run_quant(input, quant, ctx);
+	if(!output)
+		throw std::exception("can't allocate FANN buffers");
+
+	BgReward res;
+	for(int i = 0; i < std::min(BgReward::NN_SIZE, m_numOutputs); i++)
+		res[i] = output[i];
+	return res;
+}
+
+void FannFA::GetRewards(const std::vector<float> &inputs, size_t count, BgReward rewards[])
+{
+	if(!count)
+		return;
+
+	const size_t width = inputs.size() / count;
+	assert(m_numInputs + 1 == width);
+	contextlease lease(*this);
+	if(m_quantBits)
+	{
+		const struct fann_quant *quant = Quant();
+		for(size_t i = 0; i < count; i++)
+			rewards[i] = QuantReward(&inputs[i * width], quant, lease.ctx());
+		return;
+	}
+
+	std::vector<float> outputs(count * m_numOutputs);
+	m_ann->run_batch(&inputs[0], (unsigned int)count, (unsigned int)width, &outputs[0], lease.ctx());
+	for(size_t i = 0; i < count; i++)
+	{
+		BgReward res;
+		for(int j = 0; j < std::min(BgReward::NN_SIZE, m_numOutputs); j++)
+			res[j] = outputs[i * m_numOutputs + j];
+		rewards[i] = res;
+	}
+}
+
+//the first input is run in full, the others from its hidden sums
+void FannFA::GetRewardsIncremental(const std::vector<float> &inputs, size_t count, BgReward rewards[])
+{
+	if(m_quantBits)
+	{
+		GetRewards(inputs, count, rewards);
+		return;
+	}
+
+	const size_t width = inputs.size() / count;
+	assert(m_numInputs + 1 == width);
+	contextlease lease(*this);
+	struct fann_incremental *inc = lease.inc();
+	inc->saved = 0;
+	for(size_t i = 0; i < count; i++)
+	{
+		const float *output = m_ann->run_incremental(&inputs[i * width], inc);
+		BgReward res;
+		for(int j = 0; j < std::min(BgReward::NN_SIZE, m_numOutputs); j++)
+			res[j] = output[j];
+		rewards[i] = res;
+	}
+}
+
+void FannFA::GetRewardsSparse(const std::vector<unsigned int> &aiIndex, const std::vector<float> &arValue, 
+	const std::vector<size_t> &aiFirst, size_t width, BgReward rewards[])
+{
+	assert(m_numInputs + 1 == width);
+	contextlease lease(*this);
+	struct fann_context *ctx = lease.ctx();
+	if(m_quantBits)
+	{
+		//the integer copy runs the inputs in full
+		const struct fann_quant *quant = Quant();
+		std::vector<float> input(width);
+		for(size_t i = 0; i + 1 < aiFirst.size(); i++)
+		{
+			std::fill(input.begin(), input.end(), 0.0f);
+			for(size_t j = aiFirst[i]; j < aiFirst[i + 1]; j++)
+				input[aiIndex[j]] = arValue[j];
+			rewards[i] = QuantReward(&input[0], quant, ctx);
+		}
+		return;
+	}
+
+	const struct fann_sparse *sparse = Sparse();
+	for(size_t i = 0; i + 1 < aiFirst.size(); i++)
+	{
+		const unsigned int *aiInput = aiIndex.data() + aiFirst[i];
+		unsigned int count = (unsigned int)(aiFirst[i + 1] - aiFirst[i]);
+		//the last value of an input is the bias neuron's place, the network
+		//does not read it
+		while(count && aiInput[count - 1] >= m_numInputs)
+			count--;
+
+		const float *output = m_ann->run_sparse(aiInput, arValue.data() + aiFirst[i], count, sparse, ctx);
+		BgReward res;
+		for(int j = 0; j < std::min(BgReward::NN_SIZE, m_numOutputs); j++)
+			res[j] = output[j];
+		rewards[i] = res;
+	}
+}
+
 void FannFA::SetReward(const std::vector<float> &input, const BgReward& reward)
 {
-	if(m_ann->isAvxOk())
-		m_ann->train_avx(&input[0], &reward[0]);
-	else
-	if(m_ann->isSseOk())
-		m_ann->train_sse(&input[0], &reward[0]);
-	else
-		m_ann->train(&input[0], &reward[0]);
+	m_ann->train_dispatch(&input[0], &reward[0]);
+
+	updateVersion();
 }
 
 void FannFA::createNN(int input, int hidden, int output)
 {
+	ClearBuffers();
 	m_ann = std::shared_ptr<FANN::neural_net>(new FANN::neural_net);
 	unsigned int layers[3];
 
@@ -87,12 +305,12 @@ void FannFA::createNN(int input, int hidden, int output)
 	//m_ann->set_activation_steepness_output(5);
 	m_ann->randomize_weights(-0.5f, 0.5f);
 	//m_ann->randomize_weights(0, 0);
-	m_ann->can_use_sse();
-	m_ann->can_use_avx();
+	m_ann->select_isa();
 	m_ann->print_parameters();
 
 	m_numInputs = input;
 	m_numOutputs = output;
+	updateVersion();
 }
 
 void FannFA::saveNN(fs::path path, std::string name)
@@ -104,15 +322,16 @@ void FannFA::saveNN(fs::path path, std::string name)
 bool FannFA::loadNN(fs::path path, std::string name)
 {
 	path /= name;
+	ClearBuffers();
 	m_ann = std::shared_ptr<FANN::neural_net>(new FANN::neural_net);
 	if(!m_ann->create_from_file(path.string().c_str()))
 		return false;
 
-	m_ann->can_use_sse();
-	m_ann->can_use_avx();
+	m_ann->select_isa();
 
 	m_numInputs = m_ann->get_num_input();
 	m_numOutputs = m_ann->get_num_output();
+	updateVersion();
 
 	return true;
 }
@@ -2,6 +2,7 @@
 #define _FANNFA_H_
 
 #include <memory>
+#include <vector>
 #include "FunctionApproximator.h"
 #include "fann.h"
 #include "fann_cpp.h"
@@ -18,6 +19,18 @@ public:
 	
 	virtual void SetReward(const std::vector<float> &input, const BgReward& reward);
 	virtual BgReward GetReward(const std::vector<float> &input);
+	//all the inputs in one batched pass, the rewards are those of GetReward
+	virtual void GetRewards(const std::vector<float> &inputs, size_t count, BgReward rewards[]);
+	virtual void GetRewardsIncremental(const std::vector<float> &inputs, size_t count, BgReward rewards[]);
+	//the first layer from the rows of the non-zero inputs, see fann_run_sparse
+	virtual void GetRewardsSparse(const std::vector<unsigned int> &aiIndex, const std::vector<float> &arValue, 
+		const std::vector<size_t> &aiFirst, size_t width, BgReward rewards[]);
+	//the weights are only read by evaluations, every thread runs them in
+	//buffers of its own
+	virtual bool isReentrant() const {return true;}
+	//the evaluations run an integer copy of the network, see fann_run_quant;
+	//training goes on with the floats
+	virtual bool setQuantized(unsigned int nBits, float rMaxInput);
 
 	virtual void createNN(int input, int hidden, int output);
 	virtual void saveNN(fs::path path, std::string name);
@@ -27,6 +40,57 @@ protected:
 	std::shared_ptr<FANN::neural_net> m_ann;
 	BgReward InternalGetReward(const std::vector<float> &input);
 	size_t m_numInputs, m_numOutputs;
+
+private:
+	//the buffers of one run
+	struct runcontext
+	{
+		struct fann_context *ctx;
+		struct fann_incremental *inc;
+	};
+	//the buffers no run holds; a run takes one and gives it back, so there
+	//are as many as runs ever went at once, whatever threads made them
+	std::vector<runcontext> m_contexts;
+	runcontext AcquireContext();
+	void ReleaseContext(const runcontext& t);
+
+	//the buffers of a run for as long as it lasts
+	class contextlease
+	{
+	public:
+		explicit contextlease(FannFA& fa) : m_fa(fa), m_t(fa.AcquireContext()) {}
+		~contextlease() {m_fa.ReleaseContext(m_t);}
+		struct fann_context *ctx() const {return m_t.ctx;}
+		struct fann_incremental *inc() const {return m_t.inc;}
+
+	private:
+		FannFA& m_fa;
+		runcontext m_t;
+
+		contextlease(const contextlease&);
+		contextlease& operator=(const contextlease&);
+	};
+
+	//the buffers belong to the network, they go with it
+	void ClearBuffers();
+
+	//the first layer input by input, shared by the threads and copied again
+	//on the first sparse run after the weights changed
+	struct fann_sparse *m_sparse;
+	unsigned int m_sparseVersion;
+	const struct fann_sparse *Sparse();
+
+	//the integer copy of the evaluations, 0 bits for none; made again like
+	//the sparse one
+	unsigned int m_quantBits;
+	float m_quantMaxInput;
+	struct fann_quant *m_quant;
+	unsigned int m_quantVersion;
+	const struct fann_quant *Quant();
+	BgReward QuantReward(const float *input, const struct fann_quant *quant, struct fann_context *ctx) const;
+
+	FannFA(const FannFA&);
+	FannFA& operator=(const FannFA&);
 };
 
 #endif
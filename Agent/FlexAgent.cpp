@@ -18,8 +18,10 @@ FlexAgent::FlexAgent(fs::path path, std::shared_ptr<InputRepresentation> represe
 	m_gamma = 1;
  	m_lambda = 0.7f;
 	m_step = 0;
+	m_sparseEval = true;
 
 	m_heuristic.reset(new HeuristicAgent(m_path));
+	m_evalCache.reset(new BgEvalCache());
 }
 
 FlexAgent::~FlexAgent(void)
@@ -36,6 +38,7 @@ BgAgent *FlexAgent::clone()
 	a->m_gamma = m_gamma;
 	a->m_lambda = m_lambda;
 	a->m_learnMode = m_learnMode;
+	a->m_sparseEval = m_sparseEval;
 
 	a->m_nnContact = m_nnContact;
 	a->m_nnCrashed = m_nnCrashed;
@@ -44,6 +47,28 @@ BgAgent *FlexAgent::clone()
 	return a;
 }
 
+bool FlexAgent::isReentrant() const
+{
+	return m_nnContact && m_nnContact->isReentrant() && m_nnRace && m_nnRace->isReentrant() && 
+		m_nnCrashed && m_nnCrashed->isReentrant();
+}
+
+bool FlexAgent::setQuantized(unsigned int nBits)
+{
+	const float rMaxInput = m_representation->getMaxInput();
+	FunctionApproximator *apnn[] = {m_nnContact.get(), m_nnRace.get(), m_nnCrashed.get()};
+	for(int i = 0; i < 3; i++)
+		if(apnn[i] && !apnn[i]->setQuantized(nBits, rMaxInput))
+		{
+			//all the nets or none
+			for(int j = 0; j < i; j++)
+				if(apnn[j])
+					apnn[j]->setQuantized(0, rMaxInput);
+			return false;
+		}
+	return true;
+}
+
 void FlexAgent::createContactFA(int input, int hidden, int output, ApproxType annType)
 {
 	if(annType == atFann)
@@ -245,7 +270,7 @@ void FlexAgent::doMove(const bgmove& pm)
 	m_prevEntry = entry;
 }
 
-void FlexAgent::UpdateETrace(BgReward deltaReward)
+void FlexAgent::UpdateETrace(const BgReward& deltaReward)
 {
 	//Update Q values and eligibility traces
 	std::list<ETraceEntry>::iterator i;
@@ -291,7 +316,7 @@ FunctionApproximator *FlexAgent::getQ(positionclass pc) const
 	}
 }
 
-void FlexAgent::evalRace(const BgBoard *board, BgReward& reward)
+void FlexAgent::evalRace(const BgBoardView& board, BgReward& reward)
 {
 	std::vector<float> arInput(m_representation->getRaceInputs(), 0);
 	m_representation->calculateRaceInputs( board, &arInput[0] );
@@ -311,8 +336,8 @@ void FlexAgent::evalRace(const BgBoard *board, BgReward& reward)
     
 		for(i = 23; i >= 0; --i) 
 		{
-			totMen0 += board->anBoard[0][i];
-			totMen1 += board->anBoard[1][i];
+			totMen0 += board.anBoard[0][i];
+			totMen1 += board.anBoard[1][i];
 		}
 
 		if( totMen1 == 15 )
@@ -327,7 +352,7 @@ void FlexAgent::evalRace(const BgBoard *board, BgReward& reward)
 			{
 				for(i = 23; i >= 18; --i) 
 				{
-					if( board->anBoard[1][i] > 0 ) 
+					if( board.anBoard[1][i] > 0 ) 
 					{
 						break;
 					}
@@ -341,7 +366,7 @@ void FlexAgent::evalRace(const BgBoard *board, BgReward& reward)
 			{
 				for(i = 23; i >= 18; --i) 
 				{
-					if( board->anBoard[0][i] > 0 ) 
+					if( board.anBoard[0][i] > 0 ) 
 						break;
 				}
 
@@ -386,21 +411,100 @@ void FlexAgent::evalRace(const BgBoard *board, BgReward& reward)
 	}
 }
 
-void FlexAgent::evalCrashed(const BgBoard *board, BgReward& reward)
+void FlexAgent::evalCrashed(const BgBoardView& board, BgReward& reward)
 {
 	std::vector<float> arInput(m_representation->getCrashedInputs(), 0);
 	m_representation->calculateCrashedInputs( board, &arInput[0] );
 	reward = m_nnCrashed->GetReward(arInput);
 }
 
-void FlexAgent::evalContact(const BgBoard *board, BgReward& reward)
+void FlexAgent::evalContact(const BgBoardView& board, BgReward& reward)
 {
+	if(isSparseContact())
+	{
+		const size_t cInputs = m_representation->getContactInputs();
+		std::vector<unsigned int> aiIndex(cInputs);
+		std::vector<float> arValue(cInputs);
+		std::vector<size_t> aiFirst(2, 0);
+		aiFirst[1] = m_representation->calculateContactSparse(board, &aiIndex[0], &arValue[0]);
+		m_nnContact->GetRewardsSparse(aiIndex, arValue, aiFirst, cInputs, &reward);
+		return;
+	}
+
 	std::vector<float> arInput(m_representation->getContactInputs(), 0);
 	m_representation->calculateContactInputs( board, &arInput[0] );
 	reward = m_nnContact->GetReward(arInput);
 }
 
-void FlexAgent::evaluatePosition(const BgBoard *board, positionclass& pc, BgReward& reward)
+//mirrors evaluatePosition: everything but finished games goes to the contact net,
+//whose inputs are collected into one matrix
+void FlexAgent::evaluatePositions(const BgBoardView *aBoards, positionclass *apc, BgReward *arReward, int cPositions)
+{
+	if(isLearnMode() && m_step > 1000)
+	{
+		BgAgent::evaluatePositions(aBoards, apc, arReward, cPositions);
+		return;
+	}
+
+	const size_t cInputs = m_representation->getContactInputs();
+	//the incremental run takes the dense inputs
+	const bool fSparse = isSparseContact() && !isIncrementalEval();
+	std::vector<int> aiContact;
+	std::vector<AuchKey> aauch;
+	std::vector<float> arInput;
+	std::vector<unsigned int> aiIndex;
+	std::vector<size_t> aiFirst(1, 0);
+	for(int i = 0; i < cPositions; i++)
+	{
+		if(apc[i] == CLASS_OVER)
+		{
+			evalOver(aBoards[i], arReward[i]);
+			continue;
+		}
+
+		apc[i] = CLASS_CONTACT;
+		AuchKey auch = aBoards[i].PositionKey();
+		if(m_evalCache->Lookup(auch, evalVersion(), arReward[i]))
+			continue;
+
+		aiContact.push_back(i);
+		aauch.push_back(auch);
+		if(fSparse)
+		{
+			//arInput holds the values, at most cInputs per position
+			aiIndex.resize(aiFirst.back() + cInputs);
+			arInput.resize(aiFirst.back() + cInputs);
+			aiFirst.push_back(aiFirst.back() + 
+				m_representation->calculateContactSparse(aBoards[i], &aiIndex[aiFirst.back()], &arInput[aiFirst.back()]));
+		}
+		else
+		{
+			arInput.resize(aiContact.size() * cInputs, 0);
+			m_representation->calculateContactInputs(aBoards[i], &arInput[arInput.size() - cInputs]);
+		}
+	}
+
+	if(aiContact.empty())
+		return;
+
+	std::vector<BgReward> arContact(aiContact.size());
+	if(fSparse)
+		m_nnContact->GetRewardsSparse(aiIndex, arInput, aiFirst, cInputs, &arContact[0]);
+	else if(isIncrementalEval())
+		m_nnContact->GetRewardsIncremental(arInput, aiContact.size(), &arContact[0]);
+	else
+		m_nnContact->GetRewards(arInput, aiContact.size(), &arContact[0]);
+	for(size_t i = 0; i < aiContact.size(); i++)
+	{
+		arReward[aiContact[i]] = arContact[i];
+		//the incremental rows after the first depend on it, they stay out
+		//of the cache
+		if(!i || !isIncrementalEval())
+			m_evalCache->Store(aauch[i], evalVersion(), arContact[i]);
+	}
+}
+
+void FlexAgent::evaluatePosition(const BgBoardView& board, positionclass& pc, BgReward& reward)
 {
 	if(isLearnMode() && pc != CLASS_OVER && m_step > 1000)
 	{
@@ -447,7 +551,12 @@ void FlexAgent::evaluatePosition(const BgBoard *board, positionclass& pc, BgRewa
 		*/
 	default:
 		//throw std::exception("Unknown class. How did we get here?");
-		evalContact(board, reward);
+		AuchKey auch = board.PositionKey();
+		if(!m_evalCache->Lookup(auch, evalVersion(), reward))
+		{
+			evalContact(board, reward);
+			m_evalCache->Store(auch, evalVersion(), reward);
+		}
 		pc = CLASS_CONTACT;
 	}
 }
@@ -28,17 +28,23 @@ public:
 	FlexAgent(fs::path path, std::shared_ptr<InputRepresentation> representation, std::string name);
 	virtual ~FlexAgent(void);
 
-	virtual void evaluatePosition(const BgBoard *board, positionclass& pc, BgReward& reward);
-	virtual void evalRace(const BgBoard *board, BgReward& reward);
-	virtual void evalCrashed(const BgBoard *board, BgReward& reward);
-	virtual void evalContact(const BgBoard *board, BgReward& reward);
+	virtual void evaluatePosition(const BgBoardView& board, positionclass& pc, BgReward& reward);
+	virtual void evaluatePositions(const BgBoardView *aBoards, positionclass *apc, BgReward *arReward, int cPositions);
+	virtual void evalRace(const BgBoardView& board, BgReward& reward);
+	virtual void evalCrashed(const BgBoardView& board, BgReward& reward);
+	virtual void evalContact(const BgBoardView& board, BgReward& reward);
 
 	virtual void startGame(bgvariation bgv);
 	virtual void endGame();
 	virtual void doMove(const bgmove& pm);
 
+	//clones share the approximators, which run their own buffers per thread
+	virtual bool isReentrant() const;
 	virtual bool isCloneable() const {return true;}
 	virtual BgAgent *clone();
+	//the approximators are quantized for the range of the representation,
+	//the clones share them
+	virtual bool setQuantized(unsigned int nBits);
 	bool loadNN(ApproxType annType);
 	virtual void load();
 	virtual void save();
@@ -92,7 +98,10 @@ private:
 	size_t m_step;
 
 	FunctionApproximator *getQ(positionclass pc) const;
-	void UpdateETrace(BgReward deltaReward);
+	bool isSparseContact() const {return isSparseEval() && m_representation->hasSparseInputs();}
+	//every position but a finished game goes to the contact net
+	virtual unsigned int evalVersion() const {return m_nnContact->getVersion();}
+	void UpdateETrace(const BgReward& deltaReward);
 	void prepareStep0(const bgmove& pm);
 	//Q update rule
 	BgReward calcDeltaReward(const bgmove& pm, const BgReward& reward);
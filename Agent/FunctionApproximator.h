@@ -3,6 +3,7 @@
 #pragma once
 
 #include <vector>
+#include <algorithm>
 #include "BgReward.h"
 
 #include <boost/filesystem.hpp>
@@ -14,6 +15,51 @@ class FunctionApproximator
 {
 public:
 	virtual BgReward GetReward(const std::vector<float> &input) = 0;
+	//rewards of count inputs stored one after another in inputs; approximators
+	//able to run several inputs in one pass override it
+	virtual void GetRewards(const std::vector<float> &inputs, size_t count, BgReward rewards[])
+	{
+		const size_t width = inputs.size() / count;
+		std::vector<float> input(width);
+		for(size_t i = 0; i < count; i++)
+		{
+			std::copy(inputs.begin() + i * width, inputs.begin() + (i + 1) * width, input.begin());
+			rewards[i] = GetReward(input);
+		}
+	}
+
+	//GetRewards for inputs that differ in a few values, e.g. the candidates
+	//of one roll; approximators able to start from the first input override it
+	virtual void GetRewardsIncremental(const std::vector<float> &inputs, size_t count, BgReward rewards[])
+	{
+		GetRewards(inputs, count, rewards);
+	}
+
+	//GetRewards for inputs of width values given by their non-zero ones:
+	//input i has arValue[ j ] at aiIndex[ j ] for j from aiFirst[ i ] to
+	//aiFirst[ i + 1 ] - 1; approximators able to skip the zeros override it
+	virtual void GetRewardsSparse(const std::vector<unsigned int> &aiIndex, const std::vector<float> &arValue, 
+		const std::vector<size_t> &aiFirst, size_t width, BgReward rewards[])
+	{
+		std::vector<float> input(width);
+		for(size_t i = 0; i + 1 < aiFirst.size(); i++)
+		{
+			std::fill(input.begin(), input.end(), 0.0f);
+			for(size_t j = aiFirst[ i ]; j < aiFirst[ i + 1 ]; j++)
+				input[ aiIndex[ j ] ] = arValue[ j ];
+			rewards[i] = GetReward(input);
+		}
+	}
+
+	//GetReward and GetRewards may run on several threads at once, as long as
+	//nothing changes the weights meanwhile
+	virtual bool isReentrant() const {return false;}
+
+	//evaluations with nBits (8 or 16) bit integer weights for inputs of
+	//magnitudes up to rMaxInput, 0 goes back to the floats; false when the
+	//approximator has no integer evaluation of its network
+	virtual bool setQuantized(unsigned int nBits, float rMaxInput) {return !nBits;}
+
 	virtual void SetReward(const std::vector<float> &input, const BgReward& reward) = 0;
 	
 	virtual void AddToReward(const std::vector<float> &input, const BgReward& deltaReward)
@@ -23,9 +69,26 @@ public:
 	
 	virtual ~FunctionApproximator(){};
 
+	//changes with every change of the weights and is unique among all
+	//approximators, evaluation caches use it as a part of their key
+	unsigned int getVersion() const {return m_version;}
+
 	virtual void createNN(int input, int hidden, int output) = 0;
 	virtual void saveNN(fs::path path, std::string name) = 0;
 	virtual bool loadNN(fs::path path, std::string name) = 0;
+
+protected:
+	FunctionApproximator() {updateVersion();}
+
+	void updateVersion()
+	{
+		static unsigned int nLastVersion = 0;
+#pragma omp critical(FunctionApproximatorVersion)
+		m_version = ++nLastVersion;
+	}
+
+private:
+	unsigned int m_version;
 };
 
 #endif
@@ -159,6 +159,9 @@ enum {
 
 #define NUM_INPUTS ((25 * MINPPERPOINT + MORE_INPUTS) * 2)
 #define NUM_RACE_INPUTS ( HALF_RACE_INPUTS * 2 )
+#define NUM_PRUNING_INPUTS ( 25 * MINPPERPOINT * 2 )
+/* the largest magnitude of an input the integer nets take exactly */
+#define QUANT_MAX_INPUT 8.0f
 
  
 GnubgAgent::GnubgAgent(fs::path path)
@@ -169,6 +172,14 @@ GnubgAgent::GnubgAgent(fs::path path)
 
 	m_supportsSanityCheck = true;
 	m_needsInvertedEval = true;
+	m_fPruning = false;
+	memset( &nnpContact, 0, sizeof( nnpContact ) );
+	memset( &nnpCrashed, 0, sizeof( nnpCrashed ) );
+	memset( &nnpRace, 0, sizeof( nnpRace ) );
+	memset( &nnqContact, 0, sizeof( nnqContact ) );
+	memset( &nnqCrashed, 0, sizeof( nnqCrashed ) );
+	memset( &nnqRace, 0, sizeof( nnqRace ) );
+	m_nQuantBits = 0;
 
 	fs::path binPath(m_path);
 	binPath /= "gnubg.wd";
@@ -178,6 +189,7 @@ GnubgAgent::GnubgAgent(fs::path path)
 
 	load(binPath, txtPath);
 	ComputeTable();
+	m_evalCache.reset(new BgEvalCache());
 }
 
 GnubgAgent::~GnubgAgent(void)
@@ -186,9 +198,35 @@ GnubgAgent::~GnubgAgent(void)
 	NeuralNetDestroy( &nnCrashed );
 	NeuralNetDestroy( &nnRace );
 
-//	NeuralNetDestroy( &nnpContact );
-//	NeuralNetDestroy( &nnpCrashed );
-//	NeuralNetDestroy( &nnpRace );
+	NeuralNetDestroy( &nnpContact );
+	NeuralNetDestroy( &nnpCrashed );
+	NeuralNetDestroy( &nnpRace );
+
+	NeuralNetQuantDestroy( &nnqContact );
+	NeuralNetQuantDestroy( &nnqCrashed );
+	NeuralNetQuantDestroy( &nnqRace );
+}
+
+bool GnubgAgent::setQuantized(unsigned int nBits)
+{
+	NeuralNetQuantDestroy( &nnqContact );
+	NeuralNetQuantDestroy( &nnqCrashed );
+	NeuralNetQuantDestroy( &nnqRace );
+	m_nQuantBits = 0;
+	if( !nBits )
+		return true;
+
+	if( NeuralNetQuantize( &nnContact, &nnqContact, nBits, QUANT_MAX_INPUT ) ||
+		NeuralNetQuantize( &nnCrashed, &nnqCrashed, nBits, QUANT_MAX_INPUT ) ||
+		NeuralNetQuantize( &nnRace, &nnqRace, nBits, QUANT_MAX_INPUT ) )
+	{
+		NeuralNetQuantDestroy( &nnqContact );
+		NeuralNetQuantDestroy( &nnqCrashed );
+		NeuralNetQuantDestroy( &nnqRace );
+		return false;
+	}
+	m_nQuantBits = nBits;
+	return true;
 }
 
 int GnubgAgent::binary_weights_failed(const char * filename, FILE * weights)
@@ -263,15 +301,17 @@ void GnubgAgent::load(fs::path binPath, fs::path txtPath)
 		    if( !fReadWeights && !( fReadWeights =
 					    !NeuralNetLoadBinary(&nnContact, pfWeights ) &&
 					    !NeuralNetLoadBinary(&nnRace, pfWeights ) &&
-					    !NeuralNetLoadBinary(&nnCrashed, pfWeights ) //&&
-
-					    //!NeuralNetLoadBinary(&nnpContact, pfWeights ) &&
-					    //!NeuralNetLoadBinary(&nnpCrashed, pfWeights ) &&
-					    //!NeuralNetLoadBinary(&nnpRace, pfWeights ) 
+					    !NeuralNetLoadBinary(&nnCrashed, pfWeights )
 						) ) 
 			{ 
 			    perror( binPath.string().c_str() );
 		    }
+			//the pruning nets are optional
+			if( fReadWeights )
+				m_fPruning = 
+					!NeuralNetLoadBinary(&nnpContact, pfWeights ) &&
+					!NeuralNetLoadBinary(&nnpCrashed, pfWeights ) &&
+					!NeuralNetLoadBinary(&nnpRace, pfWeights );
 	    }
 	    if (pfWeights)
 		    fclose( pfWeights );
@@ -286,13 +326,14 @@ void GnubgAgent::load(fs::path binPath, fs::path txtPath)
 		    if( !( fReadWeights =
 					    !NeuralNetLoad( &nnContact, pfWeights ) &&
 					    !NeuralNetLoad( &nnRace, pfWeights ) &&
-					    !NeuralNetLoad( &nnCrashed, pfWeights )// &&
-
-					    //!NeuralNetLoad( &nnpContact, pfWeights ) &&
-					    //!NeuralNetLoad( &nnpCrashed, pfWeights ) &&
-					    //!NeuralNetLoad( &nnpRace, pfWeights ) 
+					    !NeuralNetLoad( &nnCrashed, pfWeights )
 			 ) )
 			    perror( txtPath.string().c_str() );
+			else
+				m_fPruning = 
+					!NeuralNetLoad( &nnpContact, pfWeights ) &&
+					!NeuralNetLoad( &nnpCrashed, pfWeights ) &&
+					!NeuralNetLoad( &nnpRace, pfWeights );
 
 	    }
 	    if (pfWeights)
@@ -302,6 +343,14 @@ void GnubgAgent::load(fs::path binPath, fs::path txtPath)
 
 	assert(fReadWeights);
 
+	if( m_fPruning )
+	{
+		const neuralnet *apnn[] = { &nnpContact, &nnpCrashed, &nnpRace };
+		for( int i = 0; i < 3; i++ )
+			if( apnn[ i ]->cInput != NUM_PRUNING_INPUTS || apnn[ i ]->cOutput != NUM_OUTPUTS )
+				m_fPruning = false;
+	}
+
 	if( nnContact.cInput != NUM_INPUTS || nnContact.cOutput != NUM_OUTPUTS )
 	{
 		if (NeuralNetResize( &nnContact, NUM_INPUTS, nnContact.cHidden, NUM_OUTPUTS ) == -1)
@@ -333,13 +382,20 @@ void GnubgAgent::PrintError(const char* str)
 	fprintf(stderr, "%s: %s", str, strerror(errno));
 }
 
-void GnubgAgent::evalRace(const BgBoard *board, BgReward& reward)
+void GnubgAgent::evalRace(const BgBoardView& board, BgReward& reward)
 {
 	float SSE_ALIGN( arInput[ NUM_INPUTS ]);
 	CalculateRaceInputs( board, arInput );
 
-	NeuralNetEvaluateSSE( &nnRace, arInput, &reward[0], NULL);
-  
+	if( m_nQuantBits )
+		NeuralNetEvaluateQuant( &nnqRace, arInput, &reward[0] );
+	else
+		NeuralNetEvaluateSSE( &nnRace, arInput, &reward[0], NULL);
+	RaceBackgammons( board, reward );
+}
+
+void GnubgAgent::RaceBackgammons(const BgBoardView& board, BgReward& reward)
+{
 	/* anBoard[1] is on roll */
     /* total men for side not on roll */
     int totMen0 = 0;
@@ -352,8 +408,8 @@ void GnubgAgent::evalRace(const BgBoard *board, BgReward& reward)
     
     for(i = 23; i >= 0; --i) 
 	{
-		totMen0 += board->anBoard[0][i];
-		totMen1 += board->anBoard[1][i];
+		totMen0 += board.anBoard[0][i];
+		totMen1 += board.anBoard[1][i];
     }
 
     if( totMen1 == 15 )
@@ -368,7 +424,7 @@ void GnubgAgent::evalRace(const BgBoard *board, BgReward& reward)
 		{
 			for(i = 23; i >= 18; --i) 
 			{
-				if( board->anBoard[1][i] > 0 ) 
+				if( board.anBoard[1][i] > 0 ) 
 				{
 					break;
 				}
@@ -382,7 +438,7 @@ void GnubgAgent::evalRace(const BgBoard *board, BgReward& reward)
 		{
 			for(i = 23; i >= 18; --i) 
 			{
-				if( board->anBoard[0][i] > 0 ) 
+				if( board.anBoard[0][i] > 0 ) 
 					break;
 			}
 
@@ -426,13 +482,13 @@ void GnubgAgent::evalRace(const BgBoard *board, BgReward& reward)
 	/* sanity check will take care of rest */
 }
 
-void GnubgAgent::CalculateRaceInputs(const BgBoard *anBoard, float inputs[]) const
+void GnubgAgent::CalculateRaceInputs(const BgBoardView& anBoard, float inputs[]) const
 {
 	for(int side = 0; side < 2; ++side) 
 	{
 		unsigned int i, k;
 
-		const char* board = anBoard->anBoard[side];
+		const char* board = anBoard.anBoard[side];
 		float* const afInput = inputs + side * HALF_RACE_INPUTS;
 
 		unsigned int menOff = 15;
@@ -472,12 +528,18 @@ void GnubgAgent::CalculateRaceInputs(const BgBoard *anBoard, float inputs[]) con
 	}
 }
 
-void GnubgAgent::evalCrashed(const BgBoard *board, BgReward& reward)
+void GnubgAgent::evalCrashed(const BgBoardView& board, BgReward& reward)
 {
 	float SSE_ALIGN(arInput[ NUM_INPUTS ]);
 
 	CalculateCrashedInputs( board, arInput );
     
+	if( m_nQuantBits )
+	{
+		NeuralNetEvaluateQuant( &nnqCrashed, arInput, &reward[0] );
+		return;
+	}
+
 #if FANN_USE_SSE
 	NeuralNetEvaluateSSE( &nnCrashed, arInput, &reward[0], NULL);
 #else
@@ -486,29 +548,29 @@ void GnubgAgent::evalCrashed(const BgBoard *board, BgReward& reward)
 
 }
 
-void GnubgAgent::CalculateCrashedInputs(const BgBoard *anBoard, float arInput[]) const
+void GnubgAgent::CalculateCrashedInputs(const BgBoardView& anBoard, float arInput[]) const
 {
 	baseInputs(anBoard, arInput);
 
 	{
 		float* b = arInput + 4 * 25 * 2;
-		menOffAll(anBoard->anBoard[1], b + I_OFF1);
-		CalculateHalfInputs(anBoard->anBoard[1], anBoard->anBoard[0], b);
+		menOffAll(anBoard.anBoard[1], b + I_OFF1);
+		CalculateHalfInputs(anBoard.anBoard[1], anBoard.anBoard[0], b);
 	}
 
 	{
 		float* b = arInput + (4 * 25 * 2 + MORE_INPUTS);
-		menOffAll(anBoard->anBoard[0], b + I_OFF1);
-		CalculateHalfInputs( anBoard->anBoard[0], anBoard->anBoard[1], b);
+		menOffAll(anBoard.anBoard[0], b + I_OFF1);
+		CalculateHalfInputs( anBoard.anBoard[0], anBoard.anBoard[1], b);
 	}
 }
 
-void GnubgAgent::baseInputs(const BgBoard *anBoard, float arInput[]) const
+void GnubgAgent::baseInputs(const BgBoardView& anBoard, float arInput[]) const
 {
 	for(int j = 0; j < 2; ++j) 
 	{
 		float* afInput = arInput + j * 25*4;
-		const char* board = anBoard->anBoard[j];
+		const char* board = anBoard.anBoard[j];
     
 		/* Points */
 		for(int i = 0; i < 24; i++) 
@@ -1367,11 +1429,157 @@ void GnubgAgent::ComputeTable( void )
 	ComputeTable1();
 }
 
-void GnubgAgent::evalContact(const BgBoard *board, BgReward& reward)
+void GnubgAgent::evaluatePositions(const BgBoardView *aBoards, positionclass *apc, BgReward *arReward, int cPositions)
+{
+	std::vector<int> aiRace, aiCrashed, aiContact;
+	std::vector<AuchKey> aauch(cPositions);
+	for(int i = 0; i < cPositions; i++)
+	{
+		if(isNetClass(apc[i]))
+		{
+			aauch[i] = aBoards[i].PositionKey();
+			if(m_evalCache->Lookup(aauch[i], evalVersion(), arReward[i]))
+				continue;
+		}
+
+		switch(apc[i])
+		{
+		case CLASS_RACE:
+			aiRace.push_back(i);
+			break;
+		case CLASS_CRASHED:
+			aiCrashed.push_back(i);
+			break;
+		case CLASS_CONTACT:
+			aiContact.push_back(i);
+			break;
+		default:
+			evaluatePosition(aBoards[i], apc[i], arReward[i]);
+		}
+	}
+
+	const bool fIncRace = evalBatch(nnRace, nnqRace, &GnubgAgent::CalculateRaceInputs, aBoards, aiRace, arReward);
+	for(size_t i = 0; i < aiRace.size(); i++)
+		RaceBackgammons(aBoards[aiRace[i]], arReward[aiRace[i]]);
+
+	const bool fIncCrashed = evalBatch(nnCrashed, nnqCrashed, &GnubgAgent::CalculateCrashedInputs, aBoards, aiCrashed, arReward);
+	const bool fIncContact = evalBatch(nnContact, nnqContact, &GnubgAgent::CalculateContactInputs, aBoards, aiContact, arReward);
+
+	//an incremental evaluation depends on the first position of its batch,
+	//only full ones are shared through the cache
+	for(size_t i = 0; i < (fIncRace ? 1 : aiRace.size()); i++)
+		m_evalCache->Store(aauch[aiRace[i]], evalVersion(), arReward[aiRace[i]]);
+	for(size_t i = 0; i < (fIncCrashed ? 1 : aiCrashed.size()); i++)
+		m_evalCache->Store(aauch[aiCrashed[i]], evalVersion(), arReward[aiCrashed[i]]);
+	for(size_t i = 0; i < (fIncContact ? 1 : aiContact.size()); i++)
+		m_evalCache->Store(aauch[aiContact[i]], evalVersion(), arReward[aiContact[i]]);
+}
+
+//the pruning nets see the base inputs only, the score is the equity for
+//the side that made the move
+void GnubgAgent::prunePositions(const BgBoardView *aBoards, const positionclass *apc, float arScore[], int cPositions)
+{
+	const positionclass apcNet[] = { CLASS_CONTACT, CLASS_CRASHED, CLASS_RACE };
+	const neuralnet *apnn[] = { &nnpContact, &nnpCrashed, &nnpRace };
+	std::vector<int> aiPositions;
+	std::vector<float> arInput, arOutput;
+
+	for( int iNet = 0; iNet < 3; iNet++ )
+	{
+		aiPositions.clear();
+		for( int i = 0; i < cPositions; i++ )
+			if( apc[ i ] == apcNet[ iNet ] )
+				aiPositions.push_back( i );
+		if( aiPositions.empty() )
+			continue;
+
+		//five hidden nodes do not fit the SSE kernels
+		const neuralnet& nn = *apnn[ iNet ];
+		arInput.resize( aiPositions.size() * nn.cInput );
+		arOutput.resize( aiPositions.size() * nn.cOutput );
+		for( size_t i = 0; i < aiPositions.size(); i++ )
+			baseInputs( aBoards[ aiPositions[ i ] ], &arInput[ i * nn.cInput ] );
+		NeuralNetEvaluateBatch( &nn, &arInput[ 0 ], &arOutput[ 0 ], (unsigned int)aiPositions.size() );
+
+		for( size_t i = 0; i < aiPositions.size(); i++ )
+		{
+			const float *ar = &arOutput[ i * nn.cOutput ];
+			arScore[ aiPositions[ i ] ] = -( ar[ OUTPUT_WIN ] * 2.0f - 1.0f +
+				ar[ OUTPUT_WINGAMMON ] - ar[ OUTPUT_LOSEGAMMON ] + 
+				ar[ OUTPUT_WINBACKGAMMON ] - ar[ OUTPUT_LOSEBACKGAMMON ] );
+		}
+	}
+}
+
+//one input row per position, one forward pass over the whole matrix
+bool GnubgAgent::evalBatch(const neuralnet& nn, const neuralnetquant& nnq, CalculateInputsFn calculateInputs, 
+	const BgBoardView *aBoards, const std::vector<int>& aiPositions, BgReward *arReward) const
+{
+	const unsigned int cPositions = (unsigned int)aiPositions.size();
+	if(!cPositions)
+		return false;
+
+	//the integer copies evaluate in full
+	if(isIncrementalEval() && cPositions > 1 && !m_nQuantBits)
+	{
+		/* siblings differ in a few inputs: the first one is evaluated in
+		   full and saved, the others from its hidden sums */
+		float *arRow = sse_malloc(nn.cInput * sizeof(float));
+		float arOutput[ NUM_OUTPUTS ];
+		NNState nns;
+		nns.state = NNSTATE_INCREMENTAL;
+		nns.savedBase = sse_malloc(nn.cHidden * sizeof(float));
+		nns.savedIBase = sse_malloc(nn.cInput * sizeof(float));
+
+		for(unsigned int i = 0; i < cPositions; i++)
+		{
+			(this->*calculateInputs)(aBoards[aiPositions[i]], arRow);
+#if defined FANN_USE_SSE
+			NeuralNetEvaluateSSE( &nn, arRow, arOutput, &nns );
+#else
+			NeuralNetEvaluate( &nn, arRow, arOutput, &nns );
+#endif
+			std::copy(arOutput, arOutput + nn.cOutput, &arReward[aiPositions[i]][0]);
+		}
+
+		sse_free(nns.savedIBase);
+		sse_free(nns.savedBase);
+		sse_free(arRow);
+		return true;
+	}
+
+	std::vector<float> arInput(cPositions * nn.cInput);
+	std::vector<float> arOutput(cPositions * nn.cOutput);
+	for(unsigned int i = 0; i < cPositions; i++)
+		(this->*calculateInputs)(aBoards[aiPositions[i]], &arInput[i * nn.cInput]);
+
+	if(m_nQuantBits)
+		NeuralNetEvaluateBatchQuant( &nnq, &arInput[0], &arOutput[0], cPositions );
+	else
+	{
+#if defined FANN_USE_SSE
+		NeuralNetEvaluateBatchSSE( &nn, &arInput[0], &arOutput[0], cPositions );
+#else
+		NeuralNetEvaluateBatch( &nn, &arInput[0], &arOutput[0], cPositions );
+#endif
+	}
+
+	for(unsigned int i = 0; i < cPositions; i++)
+		std::copy(&arOutput[i * nn.cOutput], &arOutput[i * nn.cOutput] + nn.cOutput, &arReward[aiPositions[i]][0]);
+	return false;
+}
+
+void GnubgAgent::evalContact(const BgBoardView& board, BgReward& reward)
 {
 	float SSE_ALIGN(arInput[ NUM_INPUTS ]);
 	CalculateContactInputs( board, arInput );
     
+	if( m_nQuantBits )
+	{
+		NeuralNetEvaluateQuant( &nnqContact, arInput, &reward[0] );
+		return;
+	}
+
 #if defined FANN_USE_SSE
 	NeuralNetEvaluateSSE( &nnContact, arInput, &reward[0], NULL);
 #else
@@ -1379,21 +1587,21 @@ void GnubgAgent::evalContact(const BgBoard *board, BgReward& reward)
 #endif
 }
 
-void GnubgAgent::CalculateContactInputs(const BgBoard *anBoard, float arInput[]) const
+void GnubgAgent::CalculateContactInputs(const BgBoardView& anBoard, float arInput[]) const
 {
 	baseInputs(anBoard, arInput);
 
 	{
 		float* b = arInput + 4 * 25 * 2;
 		/* I accidentally switched sides (0 and 1) when I trained the net */
-		menOffNonCrashed(anBoard->anBoard[0], b + I_OFF1);
-  		CalculateHalfInputs(anBoard->anBoard[1], anBoard->anBoard[0], b);
+		menOffNonCrashed(anBoard.anBoard[0], b + I_OFF1);
+  		CalculateHalfInputs(anBoard.anBoard[1], anBoard.anBoard[0], b);
 	}
 
 	{
 		float* b = arInput + (4 * 25 * 2 + MORE_INPUTS);
-		menOffNonCrashed(anBoard->anBoard[1], b + I_OFF1);
-		CalculateHalfInputs( anBoard->anBoard[0], anBoard->anBoard[1], b);
+		menOffNonCrashed(anBoard.anBoard[1], b + I_OFF1);
+		CalculateHalfInputs( anBoard.anBoard[0], anBoard.anBoard[1], b);
 	}
 }
 
@@ -11,13 +11,27 @@ public:
 	GnubgAgent(fs::path path);
 	virtual ~GnubgAgent(void);
 
-	virtual void evalRace(const BgBoard *board, BgReward& reward);
-	virtual void evalCrashed(const BgBoard *board, BgReward& reward);
-	virtual void evalContact(const BgBoard *board, BgReward& reward);
+	virtual void evaluatePositions(const BgBoardView *aBoards, positionclass *apc, BgReward *arReward, int cPositions);
+	virtual void evalRace(const BgBoardView& board, BgReward& reward);
+	virtual void evalCrashed(const BgBoardView& board, BgReward& reward);
+	virtual void evalContact(const BgBoardView& board, BgReward& reward);
+
+	virtual bool isReentrant() const {return true;}
+	virtual bool hasPruning() const {return m_fPruning;}
+	virtual void prunePositions(const BgBoardView *aBoards, const positionclass *apc, float arScore[], int cPositions);
+	//integer copies of the three nets, the pruning ones stay floats
+	virtual bool setQuantized(unsigned int nBits);
 
 private:
 	neuralnet nnContact, nnRace, nnCrashed;
-	//neuralnet nnpContact, nnpRace, nnpCrashed;
+	//gnubg's pruning nets, when the weights file has them
+	neuralnet nnpContact, nnpRace, nnpCrashed;
+	bool m_fPruning;
+	neuralnetquant nnqContact, nnqRace, nnqCrashed;
+	unsigned int m_nQuantBits;
+	//the weights never change, the cached rewards differ by the
+	//quantization only
+	virtual unsigned int evalVersion() const {return m_nQuantBits;}
 	int anEscapes[ 0x1000 ];
 	int anEscapes1[ 0x1000 ];
 
@@ -26,11 +40,17 @@ private:
 	int weights_failed(const char * filename, FILE * weights);
 	void PrintError(const char* str);
 
-	void CalculateRaceInputs(const BgBoard *anBoard, float inputs[]) const;
-	void CalculateCrashedInputs(const BgBoard *anBoard, float inputs[]) const;
-	void CalculateContactInputs(const BgBoard *anBoard, float arInput[]) const;
+	typedef void (GnubgAgent::*CalculateInputsFn)(const BgBoardView& anBoard, float arInput[]) const;
+	//true when the positions after the first came from its hidden sums
+	bool evalBatch(const neuralnet& nn, const neuralnetquant& nnq, CalculateInputsFn calculateInputs, 
+		const BgBoardView *aBoards, const std::vector<int>& aiPositions, BgReward *arReward) const;
+	void RaceBackgammons(const BgBoardView& board, BgReward& reward);
+
+	void CalculateRaceInputs(const BgBoardView& anBoard, float inputs[]) const;
+	void CalculateCrashedInputs(const BgBoardView& anBoard, float inputs[]) const;
+	void CalculateContactInputs(const BgBoardView& anBoard, float arInput[]) const;
 	void CalculateHalfInputs( const char anBoard[ 25 ], const char anBoardOpp[ 25 ], float afInput[] ) const;
-	void baseInputs(const BgBoard *anBoard, float arInput[]) const;
+	void baseInputs(const BgBoardView& anBoard, float arInput[]) const;
 	void menOffAll(const char* anBoard, float* afInput) const;
 	void menOffNonCrashed(const char* anBoard, float* afInput) const;
 
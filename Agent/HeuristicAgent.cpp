@@ -15,11 +15,11 @@ HeuristicAgent::~HeuristicAgent(void)
 {
 }
 
-void HeuristicAgent::evalRace(const BgBoard *board, BgReward& reward)
+void HeuristicAgent::evalRace(const BgBoardView& board, BgReward& reward)
 {
 	reward.reset();
 	float value = 0;
-    const char *points = board->anBoard[BgBoard::SELF];
+    const char *points = board.anBoard[BgBoard::SELF];
 
 	char total = 0;
 	for(int i = 0; i < 25; i++)
@@ -51,7 +51,7 @@ void HeuristicAgent::evalRace(const BgBoard *board, BgReward& reward)
 	reward[OUTPUT_WIN] = value;
 }
 /*
-void HeuristicAgent::evaluatePosition(const BgBoard *board, positionclass& pc, 
+void HeuristicAgent::evaluatePosition(const BgBoardView& board, positionclass& pc, 
 		const bgvariation bgv, BgReward& reward)
 {
 	if(pc == CLASS_OVER)
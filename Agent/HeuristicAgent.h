@@ -10,12 +10,14 @@ public:
 	HeuristicAgent(fs::path path);
 	virtual ~HeuristicAgent(void);
 
-	//virtual void evaluatePosition(const BgBoard *board, positionclass& pc, 
+	//virtual void evaluatePosition(const BgBoardView& board, positionclass& pc, 
 	//	const bgvariation bgv, BgReward& reward);
 
-	virtual void evalRace(const BgBoard *board, BgReward& reward);
-	virtual void evalCrashed(const BgBoard *board, BgReward& reward) {evalRace(board, reward);}
-	virtual void evalContact(const BgBoard *board, BgReward& reward) {evalRace(board, reward);}
+	virtual void evalRace(const BgBoardView& board, BgReward& reward);
+	virtual void evalCrashed(const BgBoardView& board, BgReward& reward) {evalRace(board, reward);}
+	virtual void evalContact(const BgBoardView& board, BgReward& reward) {evalRace(board, reward);}
+
+	virtual bool isReentrant() const {return true;}
 };
 
 #endif
@@ -2,6 +2,7 @@
 #define __INPUT_REPRESENTATION_H
 
 #pragma once
+#include <exception>
 #include "BgBoard.h"
 
 class InputRepresentation
@@ -15,9 +16,21 @@ public:
 	int getCrashedInputs() const {return m_crashedInputs;}
 	int getContactInputs() const {return m_contactInputs;}
 
-	virtual void calculateRaceInputs(const BgBoard *anBoard, float inputs[]) const = 0;
-	virtual void calculateCrashedInputs(const BgBoard *anBoard, float inputs[]) const = 0;
-	virtual void calculateContactInputs(const BgBoard *anBoard, float arInput[]) const = 0;
+	virtual void calculateRaceInputs(const BgBoardView& anBoard, float inputs[]) const = 0;
+	virtual void calculateCrashedInputs(const BgBoardView& anBoard, float inputs[]) const = 0;
+	virtual void calculateContactInputs(const BgBoardView& anBoard, float arInput[]) const = 0;
+
+	//the contact inputs as the indices and values of the non-zero ones, in
+	//index order, for the encodings that leave most of their inputs zero;
+	//returns how many there are, at most getContactInputs()
+	virtual bool hasSparseInputs() const {return false;}
+	virtual int calculateContactSparse(const BgBoardView& anBoard, unsigned int aiIndex[], float arValue[]) const
+	{
+		throw std::exception("not implemented");
+	}
+
+	//the largest magnitude of an input, the range of the integer evaluations
+	virtual float getMaxInput() const {return 1.0f;}
 
 private:
 	int m_raceInputs, m_crashedInputs, m_contactInputs;
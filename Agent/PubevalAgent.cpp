@@ -100,24 +100,25 @@ float PubevalAgent::pubeval(bool race, int pos[28])
 	return(score); 
 }
 
-void PubevalAgent::preparePos(const BgBoard *b, int pos[28]) const
+void PubevalAgent::preparePos(const BgBoardView& b, int pos[28]) const
 {
-	int men[2];
-	BgBoard tmpBoard(*b);
-	tmpBoard.SwapSides();
-	tmpBoard.ChequersCount((unsigned int *)men);
+	//pubeval scores from the side of the player who has just moved
+	BgBoardView board = b.Swapped();
+
+	unsigned int men[2];
+	board.ChequersCount(men);
 
 	for(int i = 0; i < 24; i++)
 	{
-		pos[i+1] = tmpBoard.anBoard[BgBoard::SELF][i];
-		if(tmpBoard.anBoard[BgBoard::OPPONENT][23 - i])
-			pos[i+1] = -tmpBoard.anBoard[BgBoard::OPPONENT][23 - i];
+		pos[i+1] = board.anBoard[BgBoard::SELF][i];
+		if(board.anBoard[BgBoard::OPPONENT][23 - i])
+			pos[i+1] = -board.anBoard[BgBoard::OPPONENT][23 - i];
 	}
 
-	pos[25] = tmpBoard.anBoard[BgBoard::SELF][BgBoard::BAR];
-	pos[0] = -tmpBoard.anBoard[BgBoard::OPPONENT][BgBoard::BAR];
+	pos[25] = board.anBoard[BgBoard::SELF][BgBoard::BAR];
+	pos[0] = -board.anBoard[BgBoard::OPPONENT][BgBoard::BAR];
 	pos[26] = 15 - men[BgBoard::SELF];
-	pos[27] = -(15 - men[BgBoard::OPPONENT]);
+	pos[27] = -(15 - (int)men[BgBoard::OPPONENT]);
 }
 
 void PubevalAgent::setX(const int pos[28])
@@ -151,7 +152,7 @@ void PubevalAgent::setX(const int pos[28])
 	m_x[122] = m_x[123] = 0;
 } 
 
-void PubevalAgent::evaluatePosition(const BgBoard *board, positionclass& pc, BgReward& reward)
+void PubevalAgent::evaluatePosition(const BgBoardView& board, positionclass& pc, BgReward& reward)
 {
 	if(pc == CLASS_OVER)
 	{
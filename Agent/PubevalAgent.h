@@ -11,7 +11,7 @@ public:
 	PubevalAgent(fs::path path);
 	virtual ~PubevalAgent(void);
 
-	virtual void evaluatePosition(const BgBoard *board, positionclass& pc, BgReward& reward);
+	virtual void evaluatePosition(const BgBoardView& board, positionclass& pc, BgReward& reward);
 
 private:
 	float m_wr[124];
@@ -20,7 +20,7 @@ private:
 
 	void loadWeights(fs::path contact, fs::path race);
 	void setX(const int pos[28]);
-	void preparePos(const BgBoard *board, int pos[28]) const;
+	void preparePos(const BgBoardView& board, int pos[28]) const;
 	float pubeval(bool race, int pos[28]);
 };
 
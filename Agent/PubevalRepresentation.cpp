@@ -1,6 +1,6 @@
 #include "PubevalRepresentation.h"
 
-void PubevalRepresentation::calculateContactInputs(const BgBoard *anBoard, float arInput[]) const
+void PubevalRepresentation::calculateContactInputs(const BgBoardView& anBoard, float arInput[]) const
 {
 	char pos[28];
 	preparePos(anBoard, pos);
@@ -34,20 +34,42 @@ void PubevalRepresentation::calculateContactInputs(const BgBoard *anBoard, float
 	arInput[122] = arInput[123] = 0;
 }
 
-void PubevalRepresentation::preparePos(const BgBoard *board, char pos[28]) const
+int PubevalRepresentation::calculateContactSparse(const BgBoardView& anBoard, unsigned int aiIndex[], float arValue[]) const
+{
+	char pos[28];
+	preparePos(anBoard, pos);
+
+	/* the non-zero ones of calculateContactInputs in index order */
+	int jm1, n, c = 0;
+	for(int j=1; j <= 24; ++j) 
+	{
+	    jm1 = j - 1;
+	    n = pos[25-j];
+		if(n==-1) {aiIndex[c] = 5*jm1+0; arValue[c++] = 1.0f;}
+		if(n==1)  {aiIndex[c] = 5*jm1+1; arValue[c++] = 1.0f;}
+		if(n>=2)  {aiIndex[c] = 5*jm1+2; arValue[c++] = 1.0f;}
+		if(n==3)  {aiIndex[c] = 5*jm1+3; arValue[c++] = 1.0f;}
+		if(n>=4)  {aiIndex[c] = 5*jm1+4; arValue[c++] = (float)(n-3)/2.0f;}
+	}
+	if(pos[0]) {aiIndex[c] = 120; arValue[c++] = -(float)(pos[0])/2.0f;}
+	if(pos[26]) {aiIndex[c] = 121; arValue[c++] = (float)(pos[26])/15.0f;}
+	return c;
+}
+
+void PubevalRepresentation::preparePos(const BgBoardView& board, char pos[28]) const
 {
 	unsigned int men[2];
-	board->ChequersCount(men);
+	board.ChequersCount(men);
 
 	for(int i = 0; i < 24; i++)
 	{
-		pos[i+1] = board->anBoard[BgBoard::SELF][i];
-		if(board->anBoard[BgBoard::OPPONENT][23 - i])
-			pos[i+1] = -board->anBoard[BgBoard::OPPONENT][23 - i];
+		pos[i+1] = board.anBoard[BgBoard::SELF][i];
+		if(board.anBoard[BgBoard::OPPONENT][23 - i])
+			pos[i+1] = -board.anBoard[BgBoard::OPPONENT][23 - i];
 	}
 
-	pos[25] = board->anBoard[BgBoard::SELF][BgBoard::BAR];
-	pos[0] = -board->anBoard[BgBoard::OPPONENT][BgBoard::BAR];
+	pos[25] = board.anBoard[BgBoard::SELF][BgBoard::BAR];
+	pos[0] = -board.anBoard[BgBoard::OPPONENT][BgBoard::BAR];
 	pos[26] = 15 - men[BgBoard::SELF];
 	pos[27] = -char(15 - men[BgBoard::OPPONENT]);
 }
@@ -12,18 +12,24 @@ public:
 
 	virtual void init() {}
 
-	virtual void calculateRaceInputs(const BgBoard *anBoard, float inputs[]) const
+	virtual void calculateRaceInputs(const BgBoardView& anBoard, float inputs[]) const
 	{
 		calculateContactInputs(anBoard, inputs);
 	};
-	virtual void calculateCrashedInputs(const BgBoard *anBoard, float inputs[]) const 
+	virtual void calculateCrashedInputs(const BgBoardView& anBoard, float inputs[]) const 
 	{
 		calculateContactInputs(anBoard, inputs);
 	};
-	virtual void calculateContactInputs(const BgBoard *anBoard, float arInput[]) const;
+	virtual void calculateContactInputs(const BgBoardView& anBoard, float arInput[]) const;
+
+	//at most 3 inputs per point and the two counts are set
+	virtual bool hasSparseInputs() const {return true;}
+	virtual int calculateContactSparse(const BgBoardView& anBoard, unsigned int aiIndex[], float arValue[]) const;
+	//15 men on the bar
+	virtual float getMaxInput() const {return 7.5f;}
 
 private:
-	void preparePos(const BgBoard *board, char pos[28]) const;
+	void preparePos(const BgBoardView& board, char pos[28]) const;
 };
 
 #endif
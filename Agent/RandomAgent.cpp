@@ -12,7 +12,7 @@ RandomAgent::~RandomAgent(void)
 {
 }
 
-void RandomAgent::evalRace(const BgBoard *board, BgReward& reward)
+void RandomAgent::evalRace(const BgBoardView& board, BgReward& reward)
 {
 	reward.reset();
 	reward[OUTPUT_WIN] = float(rand()) / RAND_MAX;
@@ -10,9 +10,9 @@ public:
 	RandomAgent(fs::path path);
 	virtual ~RandomAgent(void);
 
-	virtual void evalRace(const BgBoard *board, BgReward& reward);
-	virtual void evalCrashed(const BgBoard *board, BgReward& reward) {evalRace(board, reward);}
-	virtual void evalContact(const BgBoard *board, BgReward& reward) {evalRace(board, reward);}
+	virtual void evalRace(const BgBoardView& board, BgReward& reward);
+	virtual void evalCrashed(const BgBoardView& board, BgReward& reward) {evalRace(board, reward);}
+	virtual void evalContact(const BgBoardView& board, BgReward& reward) {evalRace(board, reward);}
 };
 
 #endif
@@ -1,9 +1,9 @@
 #include "RawRepresentation.h"
 
-void RawRepresentation::calculateContactInputs(const BgBoard *anBoard, float arInput[]) const
+void RawRepresentation::calculateContactInputs(const BgBoardView& anBoard, float arInput[]) const
 {
-	calculateHalfBoard(anBoard->anBoard[0], arInput);
-	calculateHalfBoard(anBoard->anBoard[1], arInput + 100);
+	calculateHalfBoard(anBoard.anBoard[0], arInput);
+	calculateHalfBoard(anBoard.anBoard[1], arInput + 100);
 	
 	//padding
 	//arInput[200] = arInput[201] = arInput[202] = arInput[203] = 0;
@@ -40,6 +40,65 @@ void RawRepresentation::calculateHalfBoard(const char *halfBoard, float *halfInp
 	halfInputs[96 + 1] = home / 15.0f;
 }
 
+int RawRepresentation::calculateContactSparse(const BgBoardView& anBoard, unsigned int aiIndex[], float arValue[]) const
+{
+	int n = calculateHalfSparse(anBoard.anBoard[0], 0, aiIndex, arValue);
+	return n + calculateHalfSparse(anBoard.anBoard[1], 100, aiIndex + n, arValue + n);
+}
+
+int RawRepresentation::calculateHalfSparse(const char *halfBoard, unsigned int first, 
+	unsigned int aiIndex[], float arValue[]) const
+{
+	//the values of calculateHalfBoard, an empty point sets none of its inputs
+	int n = 0;
+	float arPoint[4];
+	for(int i = 0; i < 24; i++)
+	{
+		if(!halfBoard[i])
+			continue;
+
+		switch(m_encoding)
+		{
+		case encSutton:
+			setPointSutton(halfBoard[i], arPoint);
+			break;
+		case encTes89:
+			setPointTes89(halfBoard[i], arPoint);
+			break;
+		case encTes92:
+			setPointTes92(halfBoard[i], arPoint);
+			break;
+		case encGnu:
+			setPointGnu(halfBoard[i], arPoint);
+			break;
+		default:
+			throw std::exception("Unknown board encoding");
+		}
+
+		for(int j = 0; j < 4; j++)
+			if(arPoint[j] != 0.0f)
+			{
+				aiIndex[n] = first + 4*i + j;
+				arValue[n++] = arPoint[j];
+			}
+	}
+
+	if(halfBoard[24])
+	{
+		aiIndex[n] = first + 96 + 0;
+		arValue[n++] = halfBoard[24] * 0.5f;
+	}
+	int home = BgBoard::TOTAL_MEN;
+	for(int i = 0; i < 25; i++)
+		home -= halfBoard[i];
+	if(home)
+	{
+		aiIndex[n] = first + 96 + 1;
+		arValue[n++] = home / 15.0f;
+	}
+	return n;
+}
+
 void RawRepresentation::setPointSutton(const char men, float *inputs) const
 {
     inputs[0] = men >= 1 ? 1.0f : 0.0f;
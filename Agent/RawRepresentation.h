@@ -13,19 +13,26 @@ public:
 		: InputRepresentation(200, 200, 200), m_encoding(encoding) {}
 	virtual ~RawRepresentation(void) {}
 
-	virtual void calculateRaceInputs(const BgBoard *anBoard, float inputs[]) const
+	virtual void calculateRaceInputs(const BgBoardView& anBoard, float inputs[]) const
 	{
 		calculateContactInputs(anBoard, inputs);
 	};
-	virtual void calculateCrashedInputs(const BgBoard *anBoard, float inputs[]) const 
+	virtual void calculateCrashedInputs(const BgBoardView& anBoard, float inputs[]) const 
 	{
 		calculateContactInputs(anBoard, inputs);
 	};
-	virtual void calculateContactInputs(const BgBoard *anBoard, float arInput[]) const;
+	virtual void calculateContactInputs(const BgBoardView& anBoard, float arInput[]) const;
+
+	//a board sets at most 4 inputs per occupied point and two more per side
+	virtual bool hasSparseInputs() const {return true;}
+	virtual int calculateContactSparse(const BgBoardView& anBoard, unsigned int aiIndex[], float arValue[]) const;
+	//15 men on the bar
+	virtual float getMaxInput() const {return 7.5f;}
 
 private:
-	void preparePos(const BgBoard *board, char pos[28]) const;
+	void preparePos(const BgBoardView& board, char pos[28]) const;
 	void calculateHalfBoard(const char *halfBoard, float *halfInputs) const;
+	int calculateHalfSparse(const char *halfBoard, unsigned int first, unsigned int aiIndex[], float arValue[]) const;
 	BoardEncoding m_encoding;
 
 	void setPointSutton(const char men, float *inputs) const;
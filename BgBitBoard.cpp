@@ -0,0 +1,169 @@
+#include "BgBitBoard.h"
+
+BgBitBoard::BgBitBoard(const BgBoard& board)
+	: m_board(board)
+{
+	unsigned int blocked = 0;
+	m_self = m_blots = 0;
+	m_hash = m_board.PositionHash();
+
+	for(int i = 0; i < 25; i++)
+	{
+		if(m_board.anBoard[BgBoard::SELF][i])
+			m_self |= 1 << i;
+	}
+
+	for(int i = 0; i < 24; i++)
+	{
+		int n = m_board.anBoard[BgBoard::OPPONENT][23 - i];
+		if(n >= 2)
+			blocked |= 1 << i;
+		else if(n == 1)
+			m_blots |= 1 << i;
+	}
+
+	//the opponent can't make or break points while we move
+	m_anOpen[0] = 0;
+	for(int nRoll = 1; nRoll <= 6; nRoll++)
+		m_anOpen[nRoll] = ~(blocked << nRoll) & (POINTS_MASK & ~((1 << nRoll) - 1));
+}
+
+unsigned int BgBitBoard::LegalSources(int nRoll) const
+{
+	unsigned int sources = m_self & m_anOpen[nRoll];
+
+	//bearing off: exactly, or with the back chequer when the die is larger
+	if(m_self && !(m_self & ~HOME_MASK))
+	{
+		sources |= m_self & (1 << (nRoll - 1));
+		int nBack = HighestBit(m_self);
+		if(nBack < nRoll - 1)
+			sources |= 1 << nBack;
+	}
+
+	return sources;
+}
+
+bool BgBitBoard::ApplySubMove(int iSrc, int nRoll)
+{
+	int iDest = iSrc - nRoll;
+	bool fHit = false;
+
+	char *anSelf = m_board.anBoard[BgBoard::SELF];
+	char *anOpponent = m_board.anBoard[BgBoard::OPPONENT];
+
+	BgBoard::UpdateHash(m_hash, BgBoard::SELF, iSrc, anSelf[iSrc], anSelf[iSrc] - 1);
+	if(!--anSelf[iSrc])
+		m_self &= ~(1 << iSrc);
+
+	if(iDest < 0)
+		return false;
+
+	if(m_blots & (1 << iDest))
+	{
+		fHit = true;
+		m_blots &= ~(1 << iDest);
+		BgBoard::UpdateHash(m_hash, BgBoard::OPPONENT, 23 - iDest, 1, 0);
+		BgBoard::UpdateHash(m_hash, BgBoard::OPPONENT, BgBoard::BAR, anOpponent[BgBoard::BAR], anOpponent[BgBoard::BAR] + 1);
+		anOpponent[23 - iDest] = 0;
+		anOpponent[BgBoard::BAR]++;
+	}
+
+	BgBoard::UpdateHash(m_hash, BgBoard::SELF, iDest, anSelf[iDest], anSelf[iDest] + 1);
+	anSelf[iDest]++;
+	m_self |= 1 << iDest;
+	return fHit;
+}
+
+//restores the board and masks, the caller restores the hash
+void BgBitBoard::UndoSubMove(int iSrc, int nRoll, bool fHit)
+{
+	int iDest = iSrc - nRoll;
+
+	if(iDest >= 0)
+	{
+		if(!--m_board.anBoard[BgBoard::SELF][iDest])
+			m_self &= ~(1 << iDest);
+
+		if(fHit)
+		{
+			m_blots |= 1 << iDest;
+			m_board.anBoard[BgBoard::OPPONENT][23 - iDest] = 1;
+			m_board.anBoard[BgBoard::OPPONENT][BgBoard::BAR]--;
+		}
+	}
+
+	m_board.anBoard[BgBoard::SELF][iSrc]++;
+	m_self |= 1 << iSrc;
+}
+
+//mirrors BgBoard::GenerateMovesSub, see there for the meaning of the return value
+//and of the template parameters
+template<int nMoveDepth, bool fDouble>
+bool BgBitBoard::GenerateMovesSub(movelist *pml, int n0, int n1,
+	int iPip, int cPip, ChequerMove& anMoves, bool fPartial)
+{
+	const int nMaxDepth = fDouble ? 4 : 2;
+	const int nNextDepth = nMoveDepth < nMaxDepth ? nMoveDepth + 1 : nMaxDepth;
+
+	if(nMoveDepth == nMaxDepth)
+		return true;
+
+	const int nRoll = nMoveDepth == 0 ? n0 : n1;
+
+	if(m_self & (1 << BgBoard::BAR))
+	{
+		if(!(m_anOpen[nRoll] & (1 << BgBoard::BAR)))
+			return true;
+
+		anMoves[nMoveDepth * 2] = BgBoard::BAR;
+		anMoves[nMoveDepth * 2 + 1] = BgBoard::BAR - nRoll;
+
+		unsigned long long hash = m_hash;
+		bool fHit = ApplySubMove(BgBoard::BAR, nRoll);
+		if(GenerateMovesSub<nNextDepth, fDouble>(pml, n0, n1, 23, cPip + nRoll, anMoves, fPartial))
+			m_board.SaveMoves(pml, nMoveDepth + 1, cPip + nRoll, anMoves, fPartial, m_hash);
+		UndoSubMove(BgBoard::BAR, nRoll, fHit);
+		m_hash = hash;
+
+		return fPartial;
+	}
+
+	unsigned int sources = LegalSources(nRoll) & ((2u << iPip) - 1);
+	if(!sources)
+		return true;
+
+	while(sources)
+	{
+		int i = HighestBit(sources);
+		sources &= ~(1 << i);
+
+		anMoves[nMoveDepth * 2] = i;
+		anMoves[nMoveDepth * 2 + 1] = i - nRoll;
+
+		unsigned long long hash = m_hash;
+		bool fHit = ApplySubMove(i, nRoll);
+		if(GenerateMovesSub<nNextDepth, fDouble>(pml, n0, n1,
+			fDouble ? i : 23, cPip + nRoll, anMoves, fPartial))
+		{
+			m_board.SaveMoves(pml, nMoveDepth + 1, cPip + nRoll, anMoves, fPartial, m_hash);
+		}
+		UndoSubMove(i, nRoll, fHit);
+		m_hash = hash;
+	}
+
+	return fPartial;
+}
+
+void BgBitBoard::GenerateMoves(movelist *pml, int anRoll[4], bool fPartial)
+{
+	ChequerMove anMoves;
+
+	if(anRoll[0] == anRoll[1])
+		GenerateMovesSub<0, true>(pml, anRoll[0], anRoll[0], 23, 0, anMoves, fPartial);
+	else
+	{
+		GenerateMovesSub<0, false>(pml, anRoll[0], anRoll[1], 23, 0, anMoves, fPartial);
+		GenerateMovesSub<0, false>(pml, anRoll[1], anRoll[0], 23, 0, anMoves, fPartial);
+	}
+}
@@ -0,0 +1,56 @@
+#ifndef __BGBITBOARD_H
+#define __BGBITBOARD_H
+
+#pragma once
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include "BgBoard.h"
+
+// Alternative move generator. Instead of copying the board for every
+// sub-move it keeps one board plus occupancy masks of the side on roll and
+// applies/undoes sub-moves in place. Legal source points for a die are
+// found with a mask operation, so empty and blocked points are never visited.
+// Moves are generated in exactly the same order as the classic generator.
+class BgBitBoard
+{
+public:
+	BgBitBoard(const BgBoard& board);
+
+	void GenerateMoves(movelist *pml, int anRoll[4], bool fPartial);
+
+	static inline int HighestBit(unsigned int mask)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanReverse(&index, mask);
+		return (int)index;
+#else
+		return 31 - __builtin_clz(mask);
+#endif
+	}
+
+private:
+	static const unsigned int HOME_MASK = 0x3f;
+	static const unsigned int POINTS_MASK = 0x1ffffff;
+
+	BgBoard m_board;
+	//points 0..24 occupied by the side on roll
+	unsigned int m_self;
+	//opponent blots, in the numbering of the side on roll
+	unsigned int m_blots;
+	//per die value: points whose destination is neither blocked nor off the board
+	unsigned int m_anOpen[7];
+	//BgBoard::PositionHash() of m_board
+	unsigned long long m_hash;
+
+	unsigned int LegalSources(int nRoll) const;
+	bool ApplySubMove(int iSrc, int nRoll);
+	void UndoSubMove(int iSrc, int nRoll, bool fHit);
+	template<int nMoveDepth, bool fDouble>
+	bool GenerateMovesSub(movelist *pml, int n0, int n1,
+		int iPip, int cPip, ChequerMove& anMoves, bool fPartial);
+};
+
+#endif
@@ -3,9 +3,35 @@
 #include <algorithm>
 
 #include "BgBoard.h"
+#include "BgBitBoard.h"
+#include "BgBoardStats.h"
 #include "PositionId.h"
 #include "BgReward.h"
 
+//duplicate position index of the movelist being generated, one per thread
+static BG_THREAD_LOCAL moveindex s_moveIndex;
+
+movegenerator BgBoard::s_moveGenerator = MOVEGEN_CLASSIC;
+unsigned long long BgBoard::s_aanZobrist[2][25][TOTAL_MEN + 1];
+
+bool BgBoard::s_fZobristInit = BgBoard::InitZobrist();
+
+//fills the Zobrist table with a fixed splitmix64 sequence on startup
+bool BgBoard::InitZobrist()
+{
+	unsigned long long x = 0x4d756c746947616dull;
+	unsigned long long *p = &s_aanZobrist[0][0][0];
+	for(size_t i = 0; i < sizeof(s_aanZobrist) / sizeof(*p); i++)
+	{
+		unsigned long long z = ( x += 0x9E3779B97F4A7C15ull );
+		z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+		z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBull;
+		p[i] = z ^ ( z >> 31 );
+	}
+
+	return true;
+}
+
 BgBoard::BgBoard(void)
 {
 	m_fClockwise = false;
@@ -58,67 +84,112 @@ void BgBoard::InitBoard(const bgvariation bgv)
 	}
 }
 
-// See https://savannah.gnu.org/bugs/index.php?28421 regarding the code below
-// Portable code 
+// The key is the gnubg unary code: for every point of both sides as many 1
+// bits as there are chequers followed by a 0 bit, least significant bit
+// first. Bits are gathered in a 64 bit accumulator and stored 32 at a
+// time (little endian, as everything else here is x86)
 AuchKey BgBoard::PositionKey() const
 {
-	unsigned int i, iBit = 0;
+	return BgBoardView( this ).PositionKey();
+}
+
+AuchKey BgBoardView::PositionKey() const
+{
+	//the key is a run of ones per point closed by a zero. A side never
+	//needs more than 15 + 25 bits, so each side collects the positions of
+	//its closing zeros in one register, both sides in the same pass so the
+	//two bit position chains overlap; the halves are then inverted and joined
 	AuchKey auchKey;
-	memset((void *)&auchKey[0], 0, auchKey.size() * sizeof(AuchKey::value_type));
+	unsigned long long anZeros[ 2 ] = { 0, 0 };
+	unsigned int anBits[ 2 ] = { 0, 0 };
 
-	for(i = 0; i < 2; ++i) 
+	for(int j = 0; j < 25; j++)
 	{
-		const char* b = anBoard[i];
-		for(const char* j = b; j < b + 25; ++j)
+		for(int i = 0; i < 2; i++)
 		{
-			const unsigned int nc = *j;
-
-			if( nc ) 
-			{
-				addBits(auchKey, iBit, nc);
-				iBit += nc + 1;
-			} 
-			else 
-			{
-				++iBit;
-			}
+			const unsigned int nc = anBoard[ i ][ j ];
+			//invalid boards wrap around rather than overrun
+			anZeros[ i ] |= 1ull << ( ( anBits[ i ] + nc ) & 63 );
+			anBits[ i ] += nc + 1;
 		}
 	}
 
+	unsigned long long anSide[ 2 ];
+	for(int i = 0; i < 2; i++)
+	{
+		anBits[ i ] &= 63;
+		anSide[ i ] = ~anZeros[ i ] & ( ( 1ull << anBits[ i ] ) - 1 );
+	}
+
+	unsigned long long anKey[ 2 ];
+	anKey[ 0 ] = anSide[ 0 ] | ( anSide[ 1 ] << anBits[ 0 ] );
+	anKey[ 1 ] = anSide[ 1 ] >> ( 63 - anBits[ 0 ] ) >> 1;
+	memcpy(&auchKey[ 0 ], anKey, AuchKey::KEY_SIZE);
 	return auchKey;
 }
 
-BgBoard BgBoard::PositionFromKey(const AuchKey auch)
+//64 bit Zobrist hash of the position. The move generator keeps it up to
+//date sub-move by sub-move, so it identifies leaves without encoding them
+unsigned long long BgBoard::PositionHash() const
 {
-	int i = 0, j = 0;
-	BgBoard newBoard;
+	unsigned long long hash = 0;
+	for(int i = 0; i < 2; i++)
+		for(int j = 0; j < 25; j++)
+			hash ^= s_aanZobrist[i][j][(int)anBoard[i][j]];
 
-	for(size_t a = 0; a < auch.size(); a++) 
+	return hash;
+}
+
+//decoding table: for every key byte the number of 0 bits (point separators)
+//and the lengths of the runs of 1 bits (chequers) around them, LSB first
+struct keybyte
+{
+	unsigned char nZeros;
+	unsigned char anRun[ 9 ];
+};
+
+static keybyte s_aKeyByte[ 256 ];
+
+static bool InitKeyTable()
+{
+	for(int b = 0; b < 256; b++)
 	{
-		unsigned char cur = auch[a];
-    
-		for(int k = 0; k < 8; ++k)
+		keybyte& kb = s_aKeyByte[ b ];
+		memset(&kb, 0, sizeof(kb));
+		for(int k = 0; k < 8; k++)
 		{
-			if( (cur & 0x1) )
-			{
-				if (i >= 2 || j >= 25)
-				{	// Error, so return - will probably show error message
-					return newBoard;
-				}
-				++newBoard.anBoard[i][j];
-			}
+			if( b & ( 1 << k ) )
+				kb.anRun[ kb.nZeros ]++;
 			else
-			{
-				if( ++j == 25 )
-				{
-					++i;
-					j = 0;
-				}
-			}
-			cur >>= 1;
+				kb.nZeros++;
 		}
 	}
 
+	return true;
+}
+
+static bool s_fKeyTableInit = InitKeyTable();
+
+// Byte at a time: the first run of a byte continues the current point, the
+// following ones start new points. Writing all 8 possible new points
+// unconditionally (with zeros past the last separator) keeps the loop free
+// of branches; the padding bits at the end of the key only ever advance
+// into the spare room of an[].
+BgBoard BgBoard::PositionFromKey(const AuchKey& auch)
+{
+	BgBoard newBoard;
+	char an[ 8 * AuchKey::KEY_SIZE + 9 ], *pn = an;
+
+	memset(an, 0, sizeof(an));
+	for(unsigned int a = 0; a < AuchKey::KEY_SIZE; a++) 
+	{
+		const keybyte& kb = s_aKeyByte[ auch[ a ] ];
+		pn[ 0 ] += kb.anRun[ 0 ];
+		memcpy(pn + 1, kb.anRun + 1, 8);
+		pn += kb.nZeros;
+	}
+
+	memcpy(newBoard.anBoard, an, sizeof(newBoard.anBoard));
 	return newBoard;
 }
 
@@ -178,27 +249,6 @@ bool BgBoard::CheckPosition() const
     return false;
 }
 
-inline void BgBoard::addBits(AuchKey& auchKey, unsigned int bitPos, unsigned int nBits)
-{
-	unsigned int k = bitPos >> 3;
-	unsigned int r = (bitPos & 0x7);
-	unsigned int b = (((unsigned int)0x1 << nBits) - 1) << r;
-
-	auchKey[k] |= (unsigned char)b;
-
-	if( k < 8 )
-	{
-		auchKey[k+1] |= (unsigned char)(b >> 8);
-		auchKey[k+2] |= (unsigned char)(b >> 16);
-	} 
-	else 
-	if( k == 8 ) 
-	{
-		auchKey[k+1] |= (unsigned char)(b >> 8);
-	}
-}
-
-
 bool BgBoard::LegalMove(int iSrc, int nPips ) const
 {
     int i, nBack = 0, iDest = iSrc - nPips;
@@ -217,7 +267,7 @@ bool BgBoard::LegalMove(int iSrc, int nPips ) const
     return ( nBack <= 5 && ( iSrc == nBack || iDest == -1 ) );
 }
 
-int BgBoard::ApplySubMove(const int iSrc, const int nRoll, const bool fCheckLegal) 
+int BgBoard::ApplySubMove(const int iSrc, const int nRoll, const bool fCheckLegal, unsigned long long *pHash) 
 {
     int iDest = iSrc - nRoll;
 
@@ -235,6 +285,8 @@ int BgBoard::ApplySubMove(const int iSrc, const int nRoll, const bool fCheckLega
 		return -1;
     }
     
+	if( pHash )
+		UpdateHash( *pHash, SELF, iSrc, anBoard[ SELF ][ iSrc ], anBoard[ SELF ][ iSrc ] - 1 );
     anBoard[ SELF ][ iSrc ]--;
 
     if( iDest < 0 )
@@ -250,13 +302,23 @@ int BgBoard::ApplySubMove(const int iSrc, const int nRoll, const bool fCheckLega
 		}
 
 		//blot hit
+		if( pHash )
+		{
+			UpdateHash( *pHash, SELF, iDest, anBoard[ SELF ][ iDest ], 1 );
+			UpdateHash( *pHash, OPPONENT, 23 - iDest, 1, 0 );
+			UpdateHash( *pHash, OPPONENT, BAR, anBoard[ OPPONENT ][ BAR ], anBoard[ OPPONENT ][ BAR ] + 1 );
+		}
 		anBoard[ SELF ][ iDest ] = 1;
 		anBoard[ OPPONENT ][ 23 - iDest ] = 0;
 		//send to bar
 		anBoard[ OPPONENT ][ BAR ]++;
     } 
 	else
+	{
+		if( pHash )
+			UpdateHash( *pHash, SELF, iDest, anBoard[ SELF ][ iDest ], anBoard[ SELF ][ iDest ] + 1 );
 		anBoard[ SELF ][ iDest ]++;
+	}
 	
     return 0;
 }
@@ -270,7 +332,10 @@ int BgBoard::ApplyMove(const ChequerMove& anMove, const bool fCheckLegal)
     return 0;
 }
 
-void BgBoard::SaveMoves(movelist *pml, unsigned int cMoves, unsigned int cPip, const ChequerMove& anMoves, bool fPartial) 
+//hash is the PositionHash() of this board, maintained by the generator. The
+//position key is encoded once per saved position and for hash hits
+void BgBoard::SaveMoves(movelist *pml, unsigned int cMoves, unsigned int cPip, const ChequerMove& anMoves, 
+						bool fPartial, unsigned long long hash) 
 {
     unsigned int i, j;
     bgmove *pm;
@@ -293,7 +358,10 @@ void BgBoard::SaveMoves(movelist *pml, unsigned int cMoves, unsigned int cPip, c
 			return;
 
 		if( cMoves > pml->cMaxMoves || cPip > pml->cMaxPips )
+		{
 			pml->cMoves = 0;
+			s_moveIndex.reset();
+		}
 	
 		pml->cMaxMoves = cMoves;
 		pml->cMaxPips = cPip;
@@ -301,27 +369,38 @@ void BgBoard::SaveMoves(movelist *pml, unsigned int cMoves, unsigned int cPip, c
     
     pm = &pml->amMoves[pml->cMoves];
     
-    AuchKey auch = PositionKey();
-    
-    for( i = 0; i < pml->cMoves; i++ )
+	//the key is only encoded when the hash is already there
+	AuchKey auch;
+	bool fKey = false;
+	unsigned int iSlot = moveindex::firstSlot(hash);
+	int iDup;
+	while( ( iDup = s_moveIndex.find(hash, &iSlot) ) >= 0 )
 	{
-		if( PositionId::EqualKeys( &auch[0], &pml->amMoves[ i ].auch[0] ) )
+		if( !fKey )
 		{
-			if( cMoves > pml->amMoves[ i ].cMoves ||
-				cPip > pml->amMoves[ i ].cPips )
-			{
-				for( j = 0; j < cMoves * 2; j++ )
-					pml->amMoves[ i ].anMove[ j ] = anMoves[ j ] > -1 ? anMoves[ j ] : -1;
-			
-				if( cMoves < 4 )
-					pml->amMoves[ i ].anMove[ cMoves * 2 ] = -1;
-
-				pml->amMoves[ i ].cMoves = cMoves;
-				pml->amMoves[ i ].cPips = cPip;
-			}
-		    
-			return;
+			auch = PositionKey();
+			fKey = true;
 		}
+		if( pml->amMoves[ iDup ].auch == auch )
+			break;
+	}
+
+	if( iDup >= 0 )
+	{
+		bgmove *pmDup = &pml->amMoves[ iDup ];
+		if( cMoves > pmDup->cMoves || cPip > pmDup->cPips )
+		{
+			for( j = 0; j < cMoves * 2; j++ )
+				pmDup->anMove[ j ] = anMoves[ j ] > -1 ? anMoves[ j ] : -1;
+		
+			if( cMoves < 4 )
+				pmDup->anMove[ cMoves * 2 ] = -1;
+
+			pmDup->cMoves = cMoves;
+			pmDup->cPips = cPip;
+		}
+	    
+		return;
 	}
     
     for( i = 0; i < cMoves * 2; i++ )
@@ -330,7 +409,8 @@ void BgBoard::SaveMoves(movelist *pml, unsigned int cMoves, unsigned int cPip, c
     if( cMoves < 4 )
 		pm->anMove[ cMoves * 2 ] = -1;
     
-	pm->auch = auch;
+	pm->auch = fKey ? auch : PositionKey();
+	s_moveIndex.insert(iSlot, hash, pml->cMoves);
 
     pm->cMoves = cMoves;
     pm->cPips = cPip;
@@ -344,43 +424,50 @@ void BgBoard::SaveMoves(movelist *pml, unsigned int cMoves, unsigned int cPip, c
 
 int BgBoard::BackChequer() const
 {
-	int back = -1;
-	for (int b = 24; b > -1; b--) 
-	{
-		if (anBoard[SELF][b] > 0) 
-		{
-			back = b;
-			break;
-		}
-	}
+	return BgBoardStats::BackChequer(anBoard[SELF]);
+}
 
-	return back;
+int BgBoardView::BackChequer() const
+{
+	return BgBoardStats::BackChequer(anBoard[BgBoard::SELF]);
 }
 
-bool BgBoard::GenerateMovesSub( movelist *pml, int anRoll[], int nMoveDepth,
-			     int iPip, int cPip, ChequerMove& anMoves, bool fPartial ) const
+//Sub-move generator specialised per roll shape: a double plays up to four
+//sub-moves of one die, a non-double two, first n0 then n1. The depth is a
+//template parameter, so the recursion is unrolled at compile time and the
+//die, the recursion limit and the ordering rule of doubles are constants.
+//Returns true if the position reached should be saved by the caller
+template<int nMoveDepth, bool fDouble>
+bool BgBoard::GenerateMovesSub( movelist *pml, int n0, int n1, int iPip, int cPip, 
+	ChequerMove& anMoves, bool fPartial, unsigned long long hash ) const
 {
+	const int nMaxDepth = fDouble ? 4 : 2;
+	//the last depth only ends the recursion; clamping the next one keeps
+	//the compiler from instantiating deeper levels
+	const int nNextDepth = nMoveDepth < nMaxDepth ? nMoveDepth + 1 : nMaxDepth;
     bool fUsed = false;
 
-    if( nMoveDepth > 3 || !anRoll[ nMoveDepth ] )
+    if( nMoveDepth == nMaxDepth )
 		return true;
 
+	const int nRoll = nMoveDepth == 0 ? n0 : n1;
+
     if( anBoard[ SELF ][ BAR ] ) // on bar
 	{ 
-		if( anBoard[ OPPONENT ][ anRoll[ nMoveDepth ] - 1 ] >= 2 )
+		if( anBoard[ OPPONENT ][ nRoll - 1 ] >= 2 )
 			return true;
 
 		anMoves[ nMoveDepth * 2 ] = 24;
-		anMoves[ nMoveDepth * 2 + 1 ] = 24 - anRoll[ nMoveDepth ];
+		anMoves[ nMoveDepth * 2 + 1 ] = 24 - nRoll;
 
 	    BgBoard anBoardNew(*this);
-		anBoardNew.ApplySubMove(24, anRoll[ nMoveDepth ], true);
+		unsigned long long hashNew = hash;
+		anBoardNew.ApplySubMove(24, nRoll, true, &hashNew);
 	
-		if(anBoardNew.GenerateMovesSub( pml, anRoll, nMoveDepth + 1, 23, cPip +
-			      anRoll[ nMoveDepth ], anMoves, fPartial ) )
+		if(anBoardNew.GenerateMovesSub<nNextDepth, fDouble>( pml, n0, n1, 23, cPip + nRoll, 
+			anMoves, fPartial, hashNew ) )
 		{
-			anBoardNew.SaveMoves( pml, nMoveDepth + 1, cPip + anRoll[ nMoveDepth ],
-				   anMoves, fPartial );
+			anBoardNew.SaveMoves( pml, nMoveDepth + 1, cPip + nRoll, anMoves, fPartial, hashNew );
 		}
 
 		return fPartial;
@@ -389,20 +476,21 @@ bool BgBoard::GenerateMovesSub( movelist *pml, int anRoll[], int nMoveDepth,
 	{
 		for(int i = iPip; i >= 0; i-- )
 		{
-			if( anBoard[ SELF ][ i ] && LegalMove(i, anRoll[ nMoveDepth ] ) ) 
+			if( anBoard[ SELF ][ i ] && LegalMove(i, nRoll ) ) 
 			{
 				anMoves[ nMoveDepth * 2 ] = i;
-				anMoves[ nMoveDepth * 2 + 1 ] = i -	anRoll[ nMoveDepth ];
+				anMoves[ nMoveDepth * 2 + 1 ] = i - nRoll;
 
 			    BgBoard anBoardNew(*this);
-				anBoardNew.ApplySubMove(i, anRoll[ nMoveDepth ], true);
+				unsigned long long hashNew = hash;
+				anBoardNew.ApplySubMove(i, nRoll, true, &hashNew);
 		
-				if( anBoardNew.GenerateMovesSub( pml, anRoll, nMoveDepth + 1,
-					   anRoll[ 0 ] == anRoll[ 1 ] ? i : 23,
-					   cPip + anRoll[ nMoveDepth ],  anMoves, fPartial ) )
+				//doubles move the chequers in descending order so that
+				//every combination is generated once
+				if( anBoardNew.GenerateMovesSub<nNextDepth, fDouble>( pml, n0, n1, fDouble ? i : 23,
+					   cPip + nRoll, anMoves, fPartial, hashNew ) )
 				{
-					anBoardNew.SaveMoves( pml, nMoveDepth + 1, cPip +
-					   anRoll[ nMoveDepth ], anMoves, fPartial );
+					anBoardNew.SaveMoves( pml, nMoveDepth + 1, cPip + nRoll, anMoves, fPartial, hashNew );
 				}
 		
 				fUsed = true;
@@ -425,17 +513,163 @@ int BgBoard::GenerateMoves( movelist *pml, bgmove* amMoves, int n0, int n1, bool
 
     pml->cMoves = pml->cMaxMoves = pml->cMaxPips = pml->iMoveBest = 0;
 	pml->amMoves = amMoves;
-    GenerateMovesSub( pml, anRoll, 0, 23, 0, anMoves, fPartial );
+	s_moveIndex.reset();
 
-    if( anRoll[ 0 ] != anRoll[ 1 ] ) 
+	if( s_moveGenerator == MOVEGEN_BITBOARD )
 	{
-		std::swap( anRoll[0], anRoll[1] );
-		GenerateMovesSub( pml, anRoll, 0, 23, 0, anMoves, fPartial );
-    }
+		BgBitBoard bitBoard(*this);
+		bitBoard.GenerateMoves( pml, anRoll, fPartial );
+		return pml->cMoves;
+	}
+
+	//a non-double walks the tree of each order of the dice in turn; the two
+	//trees share only the root, and the duplicate index merges the moves
+	//reaching the same position
+	unsigned long long hash = PositionHash();
+	if( n0 == n1 )
+		GenerateMovesSub<0, true>( pml, n0, n0, 23, 0, anMoves, fPartial, hash );
+	else
+	{
+		GenerateMovesSub<0, false>( pml, n0, n1, 23, 0, anMoves, fPartial, hash );
+		GenerateMovesSub<0, false>( pml, n1, n0, 23, 0, anMoves, fPartial, hash );
+	}
 
 	return pml->cMoves;
 }
 
+//Generates the movelists of all 21 rolls at once. The first sub-move of a
+//roll depends on one die only, so the bar check, the point scan and the
+//board copies of the first level are done once per die and shared by every
+//roll containing it; the remaining sub-moves are the usual recursion. The
+//bitboard generator sets up its masks once and reuses them for every roll
+//instead. Moves and their order are the same as GenerateMoves gives for
+//each roll
+int BgBoard::GenerateMovesAllRolls(allrollsmovelist *paml, bool fPartial) const
+{
+	unsigned int anOffset[ allrollsmovelist::NUM_ROLLS ];
+	unsigned int cMoves = 0;
+	int iRoll = 0;
+
+	if( s_moveGenerator == MOVEGEN_BITBOARD )
+	{
+		BgBitBoard bitBoard(*this);
+
+		for(int n0 = 1; n0 <= 6; n0++)
+		{
+			for(int n1 = n0; n1 <= 6; n1++, iRoll++)
+			{
+				int anRoll[ 4 ];
+				movelist *pml = BeginRoll( paml, iRoll, n0, n1, cMoves, anRoll );
+				anOffset[ iRoll ] = cMoves;
+				bitBoard.GenerateMoves( pml, anRoll, fPartial );
+				cMoves += pml->cMoves;
+			}
+		}
+	}
+	else
+	{
+		struct firstmove
+		{
+			int iSrc;
+			unsigned long long hash;
+			BgBoard board;
+		};
+
+		//at most 15 occupied points or the bar per die
+		firstmove aaFirst[ 6 ][ TOTAL_MEN ];
+		int acFirst[ 6 ];
+		unsigned long long hash = PositionHash();
+
+		for(int nDie = 1; nDie <= 6; nDie++)
+		{
+			int& cFirst = acFirst[ nDie - 1 ];
+			cFirst = 0;
+
+			for(int i = anBoard[ SELF ][ BAR ] ? BAR : 23; i >= 0; i--)
+			{
+				if( i == BAR ? anBoard[ OPPONENT ][ nDie - 1 ] < 2 : anBoard[ SELF ][ i ] && LegalMove( i, nDie ) )
+				{
+					firstmove& fm = aaFirst[ nDie - 1 ][ cFirst++ ];
+					fm.iSrc = i;
+					fm.hash = hash;
+					fm.board = *this;
+					fm.board.ApplySubMove( i, nDie, true, &fm.hash );
+				}
+
+				//a chequer on the bar is the only one that may move
+				if( i == BAR )
+					break;
+			}
+		}
+
+		ChequerMove anMoves;
+		for(int n0 = 1; n0 <= 6; n0++)
+		{
+			for(int n1 = n0; n1 <= 6; n1++, iRoll++)
+			{
+				int anRoll[ 4 ];
+				movelist *pml = BeginRoll( paml, iRoll, n0, n1, cMoves, anRoll );
+				anOffset[ iRoll ] = cMoves;
+
+				for(int nOrder = n0 == n1 ? 1 : 2; nOrder > 0; nOrder--)
+				{
+					const int nDie = anRoll[ 0 ];
+					for(int i = 0; i < acFirst[ nDie - 1 ]; i++)
+					{
+						firstmove& fm = aaFirst[ nDie - 1 ][ i ];
+						anMoves[ 0 ] = fm.iSrc;
+						anMoves[ 1 ] = fm.iSrc - nDie;
+
+						//entering from the bar always leaves the whole board open
+						bool fSave;
+						if( n0 == n1 )
+							fSave = fm.board.GenerateMovesSub<1, true>( pml, n0, n0, fm.iSrc != BAR ? fm.iSrc : 23, 
+								nDie, anMoves, fPartial, fm.hash );
+						else
+							fSave = fm.board.GenerateMovesSub<1, false>( pml, anRoll[ 0 ], anRoll[ 1 ], 23, 
+								nDie, anMoves, fPartial, fm.hash );
+
+						if( fSave )
+							fm.board.SaveMoves( pml, 1, nDie, anMoves, fPartial, fm.hash );
+					}
+
+					std::swap( anRoll[ 0 ], anRoll[ 1 ] );
+				}
+
+				cMoves += pml->cMoves;
+			}
+		}
+	}
+
+	//the arena may have moved while it grew
+	for(iRoll = 0; iRoll < allrollsmovelist::NUM_ROLLS; iRoll++)
+		paml->aml[ iRoll ].amMoves = &paml->amArena[ 0 ] + anOffset[ iRoll ];
+	paml->cMoves = cMoves;
+
+	return cMoves;
+}
+
+//Prepares the movelist of one roll of GenerateMovesAllRolls at the end of
+//the arena, making room for the largest possible list
+movelist *BgBoard::BeginRoll(allrollsmovelist *paml, int iRoll, int n0, int n1, unsigned int cMoves, int anRoll[ 4 ])
+{
+	if( paml->amArena.size() < cMoves + movelist::MAX_INCOMPLETE_MOVES )
+		paml->amArena.resize( std::max( 2 * paml->amArena.size(), 
+			(size_t)( cMoves + movelist::MAX_INCOMPLETE_MOVES ) ) );
+
+	movelist *pml = &paml->aml[ iRoll ];
+	pml->cMoves = pml->cMaxMoves = pml->cMaxPips = pml->iMoveBest = 0;
+	pml->amMoves = &paml->amArena[ cMoves ];
+	paml->aanRoll[ iRoll ][ 0 ] = n0;
+	paml->aanRoll[ iRoll ][ 1 ] = n1;
+	s_moveIndex.reset();
+
+	anRoll[ 0 ] = n0;
+	anRoll[ 1 ] = n1;
+	anRoll[ 2 ] = anRoll[ 3 ] = ( ( n0 == n1 ) ? n0 : 0 );
+	return pml;
+}
+
 void BgBoard::SwapSides() 
 {
     for(int i = 0; i < 25; i++ ) 
@@ -448,26 +682,30 @@ void BgBoard::SwapSides()
 
 void BgBoard::PipCount(unsigned int anPips[ 2 ] ) const
 {
-    anPips[ OPPONENT ] = 0;
-    anPips[ SELF ] = 0;
-    
-    for(int i = 0; i < 25; i++ ) 
-	{
-		anPips[ OPPONENT ] += anBoard[ OPPONENT ][ i ] * ( i + 1 );
-		anPips[ SELF ] += anBoard[ SELF ][ i ] * ( i + 1 );
-    }
+	BgBoardStats stats(*this);
+	anPips[ OPPONENT ] = stats.Pips( OPPONENT );
+	anPips[ SELF ] = stats.Pips( SELF );
 }
 
 void BgBoard::ChequersCount(unsigned int anChequers[ 2 ]) const
 {
-    anChequers[ OPPONENT ] = 0;
-    anChequers[ SELF ] = 0;
+	BgBoardStats stats(*this);
+	anChequers[ OPPONENT ] = stats.Chequers( OPPONENT );
+	anChequers[ SELF ] = stats.Chequers( SELF );
+}
 
-    for(int i = 0; i < 25; i++ ) 
-	{
-		anChequers[ OPPONENT ] += anBoard[ OPPONENT ][ i ];
-		anChequers[ SELF ] += anBoard[ SELF ][ i ];
-    }
+void BgBoardView::PipCount(unsigned int anPips[ 2 ] ) const
+{
+	BgBoardStats stats(*this);
+	anPips[ BgBoard::OPPONENT ] = stats.Pips( BgBoard::OPPONENT );
+	anPips[ BgBoard::SELF ] = stats.Pips( BgBoard::SELF );
+}
+
+void BgBoardView::ChequersCount(unsigned int anChequers[ 2 ]) const
+{
+	BgBoardStats stats(*this);
+	anChequers[ BgBoard::OPPONENT ] = stats.Chequers( BgBoard::OPPONENT );
+	anChequers[ BgBoard::SELF ] = stats.Chequers( BgBoard::SELF );
 }
 
 AuchKey BgBoard::MoveKey (const ChequerMove& anMove) const
@@ -497,7 +735,7 @@ int BgBoard::GameStatus(const bgvariation bgv ) const
 {
 	BgReward ar;
     
-	if( BgEval::Instance()->ClassifyPosition( this, bgv ) != CLASS_OVER )
+	if( !BgBoardStats( *this ).IsOver() )
 		return 0;
 
 	BgEval::Instance()->EvalOver( this, ar, bgv );
@@ -517,7 +755,7 @@ char *BgBoard::PositionID() const
     return PositionIDFromKey(auch);
 }
 
-char *BgBoard::PositionIDFromKey(const AuchKey auchKey) const
+char *BgBoard::PositionIDFromKey(const AuchKey& auchKey) const
 {
     const unsigned char *puch = &auchKey[0];
     static char szID[ PositionId::L_POSITIONID + 1 ];
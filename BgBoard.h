@@ -8,8 +8,16 @@
 #include "BgMove.h"
 #include "BgReward.h"
 
+enum movegenerator
+{
+	MOVEGEN_CLASSIC,	/* recursive generator copying the board per sub-move */
+	MOVEGEN_BITBOARD	/* occupancy mask generator, see BgBitBoard */
+};
+
 class BgBoard
 {
+	friend class BgBitBoard;
+
 public:
 	static const int OPPONENT = 0;
 	static const int SELF = 1;
@@ -30,9 +38,10 @@ public:
 
 	//position key stuff
 	AuchKey PositionKey() const;
+	unsigned long long PositionHash() const;
 	char *PositionID() const;
-	char *PositionIDFromKey(const AuchKey auchKey) const;
-	static BgBoard PositionFromKey(const AuchKey auchKey);
+	char *PositionIDFromKey(const AuchKey& auchKey) const;
+	static BgBoard PositionFromKey(const AuchKey& auchKey);
 	static bool PositionFromID(BgBoard& anBoard, const char* pchEnc);
 	bool CheckPosition() const;
 	char *DrawBoard( char *pch, int fRoll, char *asz[7], char *szMatchID, int nChequers ) const;
@@ -40,6 +49,9 @@ public:
 
 	//moves
 	int GenerateMoves(movelist *pml, bgmove* amMoves, int n0, int n1, bool fPartial) const;
+	int GenerateMovesAllRolls(allrollsmovelist *paml, bool fPartial) const;
+	static void setMoveGenerator(movegenerator mg) {s_moveGenerator = mg;}
+	static movegenerator getMoveGenerator() {return s_moveGenerator;}
 	unsigned int locateMove (const ChequerMove& anMove, const movelist *pml) const;
 	char *FormatMove( char *sz, const ChequerMove& anMove) const;
 	char *FormatMovePlain( char *sz, const ChequerMove& anMove) const;
@@ -48,17 +60,29 @@ public:
 	char anBoard[2][25];
 private:
 	bool m_fClockwise;
+	static movegenerator s_moveGenerator;
+	//Zobrist numbers per side, point and number of chequers
+	static unsigned long long s_aanZobrist[2][25][TOTAL_MEN + 1];
+	static bool s_fZobristInit;
+	static bool InitZobrist();
+
+	static inline void UpdateHash(unsigned long long& hash, int side, int point, int nOld, int nNew)
+	{
+		hash ^= s_aanZobrist[side][point][nOld] ^ s_aanZobrist[side][point][nNew];
+	}
 
 	void clearBoard();
-	static inline void addBits(AuchKey& auchKey, unsigned int bitPos, unsigned int nBits);
 
 	//Moves
 	bool LegalMove(int iSrc, int nPips) const;
-	int ApplySubMove(const int iSrc, const int nRoll, const bool fCheckLegal);
+	int ApplySubMove(const int iSrc, const int nRoll, const bool fCheckLegal, unsigned long long *pHash = NULL);
 	AuchKey MoveKey (const ChequerMove& anMove) const;
-	void SaveMoves(movelist *pml, unsigned int cMoves, unsigned int cPip, const ChequerMove& anMoves, bool fPartial);
-	bool GenerateMovesSub( movelist *pml, int anRoll[], int nMoveDepth,
-		int iPip, int cPip, ChequerMove& anMoves, bool fPartial ) const;
+	void SaveMoves(movelist *pml, unsigned int cMoves, unsigned int cPip, const ChequerMove& anMoves, 
+		bool fPartial, unsigned long long hash);
+	template<int nMoveDepth, bool fDouble>
+	bool GenerateMovesSub( movelist *pml, int n0, int n1, int iPip, int cPip, 
+		ChequerMove& anMoves, bool fPartial, unsigned long long hash ) const;
+	static movelist *BeginRoll(allrollsmovelist *paml, int iRoll, int n0, int n1, unsigned int cMoves, int anRoll[ 4 ]);
 
 	//draw board
 	char *DrawBoardStd( char *sz, int fRoll, char *asz[7], char *szMatchID, int nChequers ) const;
@@ -68,4 +92,42 @@ private:
 	static char *FormatPointPlain( char *pch, int n );
 };
 
+// Read-only view of a board from either side. It holds pointers to the two
+// rows of a BgBoard, exchanged when fSwap is set, so evaluation code can see
+// the opponent as SELF without copying and swapping the board. Rows are
+// indexed as in BgBoard, anBoard[side][point]. Views are built implicitly
+// from boards, so everything taking a view takes a board as well. The board
+// must outlive the view.
+class BgBoardView
+{
+public:
+	BgBoardView(const BgBoard *board, bool fSwap = false)
+	{
+		anBoard[BgBoard::OPPONENT] = board->anBoard[fSwap ? BgBoard::SELF : BgBoard::OPPONENT];
+		anBoard[BgBoard::SELF] = board->anBoard[fSwap ? BgBoard::OPPONENT : BgBoard::SELF];
+	}
+
+	BgBoardView(const BgBoard& board, bool fSwap = false)
+	{
+		anBoard[BgBoard::OPPONENT] = board.anBoard[fSwap ? BgBoard::SELF : BgBoard::OPPONENT];
+		anBoard[BgBoard::SELF] = board.anBoard[fSwap ? BgBoard::OPPONENT : BgBoard::SELF];
+	}
+
+	//the same board from the other side
+	BgBoardView Swapped() const
+	{
+		BgBoardView view(*this);
+		view.anBoard[BgBoard::OPPONENT] = anBoard[BgBoard::SELF];
+		view.anBoard[BgBoard::SELF] = anBoard[BgBoard::OPPONENT];
+		return view;
+	}
+
+	void PipCount(unsigned int anPips[ 2 ] ) const;
+	void ChequersCount(unsigned int anChequers[ 2 ]) const;
+	int  BackChequer() const;
+	AuchKey PositionKey() const;
+
+	const char *anBoard[2];
+};
+
 #endif
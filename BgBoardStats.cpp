@@ -0,0 +1,59 @@
+#include "BgBoardStats.h"
+
+BgBoardStats::BgBoardStats(const BgBoardView& board)
+{
+	const __m128i zero = _mm_setzero_si128();
+	//the second load of a row repeats points 9..15, lanes 0..6 drop them
+	const __m128i hiMask = _mm_set_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0);
+	//pip weight of each 16 bit lane: point + 1
+	const __m128i weight0 = _mm_set_epi16(8, 7, 6, 5, 4, 3, 2, 1);
+	const __m128i weight1 = _mm_set_epi16(16, 15, 14, 13, 12, 11, 10, 9);
+	const __m128i weight2 = _mm_set_epi16(17, 0, 0, 0, 0, 0, 0, 0);
+	const __m128i weight3 = _mm_set_epi16(25, 24, 23, 22, 21, 20, 19, 18);
+
+	for(int side = 0; side < 2; side++)
+	{
+		const char *anRow = board.anBoard[side];
+		__m128i lo = _mm_loadu_si128((const __m128i *)anRow);
+		__m128i hi = _mm_loadu_si128((const __m128i *)(anRow + 9));
+
+		unsigned int maskLo = _mm_movemask_epi8(_mm_cmpeq_epi8(lo, zero)) ^ 0xffff;
+		unsigned int maskHi = _mm_movemask_epi8(_mm_cmpeq_epi8(hi, zero)) ^ 0xffff;
+		unsigned int mask = maskLo | (maskHi << 9);
+		m_anBack[side] = mask ? BgBitBoard::HighestBit(mask) : -1;
+
+		//no point holds more than 15 chequers, so the bytes add up safely
+		hi = _mm_and_si128(hi, hiMask);
+		__m128i sad = _mm_sad_epu8(_mm_add_epi8(lo, hi), zero);
+		m_anChequers[side] = _mm_cvtsi128_si32(_mm_add_epi32(sad, _mm_srli_si128(sad, 8)));
+
+		__m128i pips = _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), weight0);
+		pips = _mm_add_epi32(pips, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), weight1));
+		pips = _mm_add_epi32(pips, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), weight2));
+		pips = _mm_add_epi32(pips, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), weight3));
+		pips = _mm_add_epi32(pips, _mm_srli_si128(pips, 8));
+		pips = _mm_add_epi32(pips, _mm_srli_si128(pips, 4));
+		m_anPips[side] = _mm_cvtsi128_si32(pips);
+	}
+
+	m_fCrashed = IsContact() &&
+		(IsCrashedSide(board.anBoard[0], m_anChequers[0]) || IsCrashedSide(board.anBoard[1], m_anChequers[1]));
+}
+
+bool BgBoardStats::IsCrashedSide(const char *anRow, unsigned int tot)
+{
+	unsigned int const N = 6;
+
+	if( tot <= N )
+		return true;
+
+	if( anRow[0] > 1 )
+	{
+		if( tot <= (N + anRow[0]) )
+			return true;
+
+		return anRow[1] > 1 && (1 + tot - (anRow[0] + anRow[1])) <= N;
+	}
+
+	return tot <= (N + (anRow[1] - 1));
+}
@@ -0,0 +1,56 @@
+#ifndef __BGBOARDSTATS_H
+#define __BGBOARDSTATS_H
+
+#pragma once
+
+#include <emmintrin.h>
+#include "BgBitBoard.h"
+
+// Per side figures of a board computed in one SSE2 pass over both rows:
+// back chequer, number of chequers and pip count, plus the game over,
+// contact and crashed tests of BgEval::ClassifyPosition. BgBoard and BgEval
+// build their board queries on it.
+// A row is read as two overlapping 16 byte loads, points 0..15 and 9..24,
+// so nothing outside the row is touched.
+class BgBoardStats
+{
+public:
+	BgBoardStats(const BgBoardView& board);
+
+	int BackChequer(int side) const {return m_anBack[side];}
+	unsigned int Chequers(int side) const {return m_anChequers[side];}
+	unsigned int Pips(int side) const {return m_anPips[side];}
+
+	bool IsOver() const {return m_anBack[0] < 0 || m_anBack[1] < 0;}
+	bool IsContact() const {return m_anBack[0] + m_anBack[1] > 22;}
+	//contact position where one side has less than 7 active chequers
+	bool IsCrashed() const {return m_fCrashed;}
+
+	//bit i set when point i of the row holds chequers
+	static inline unsigned int OccupiedMask(const char *anRow)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		__m128i lo = _mm_loadu_si128((const __m128i *)anRow);
+		__m128i hi = _mm_loadu_si128((const __m128i *)(anRow + 9));
+		unsigned int maskLo = _mm_movemask_epi8(_mm_cmpeq_epi8(lo, zero)) ^ 0xffff;
+		unsigned int maskHi = _mm_movemask_epi8(_mm_cmpeq_epi8(hi, zero)) ^ 0xffff;
+		return maskLo | (maskHi << 9);
+	}
+
+	//highest occupied point of the row, -1 for an empty one
+	static inline int BackChequer(const char *anRow)
+	{
+		unsigned int mask = OccupiedMask(anRow);
+		return mask ? BgBitBoard::HighestBit(mask) : -1;
+	}
+
+private:
+	int m_anBack[2];
+	unsigned int m_anChequers[2];
+	unsigned int m_anPips[2];
+	bool m_fCrashed;
+
+	static bool IsCrashedSide(const char *anRow, unsigned int tot);
+};
+
+#endif
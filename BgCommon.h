@@ -34,5 +34,34 @@ enum bgvariation
 #define SGN(x) ((x) > 0 ? 1 : -1)
 #endif
 
+//static thread local storage, POD types only
+#if defined(_MSC_VER)
+#define BG_THREAD_LOCAL __declspec(thread)
+#else
+#define BG_THREAD_LOCAL __thread
+#endif
+
+//16 byte alignment of the SIMD value types; 32-bit VS2010 cannot pass
+//aligned types by value, which its std::vector::resize does
+#if defined(_MSC_VER)
+#if defined(_WIN64) || _MSC_VER >= 1700
+#define BG_ALIGN16 __declspec(align(16))
+#else
+#define BG_ALIGN16
+#endif
+#else
+#define BG_ALIGN16 __attribute__ ((aligned(16)))
+#endif
+
+//OpenMP runtime, single threaded stand-ins when it is off
+#if defined(_OPENMP)
+#include <omp.h>
+#else
+#include <time.h>
+inline int omp_get_thread_num() {return 0;}
+inline int omp_get_max_threads() {return 1;}
+inline double omp_get_wtime() {return (double)clock() / CLOCKS_PER_SEC;}
+#endif
+
 
 #endif
@@ -2,6 +2,9 @@
 #include "BgDispatcher.h"
 #include "Agent/BgAgentFactory.h"
 #include "BgGameDispatcher.h"
+#include "BgPerft.h"
+#include "BgRollout.h"
+#include "fann_cpu.h"
 
 extern char *aszCopying[];
 extern char *aszWarranty[];
@@ -21,6 +24,40 @@ BgDispatcher::BgDispatcher(void)
 	("train-games,T", po::value<int>()->default_value(10000),   "number of games for training")
 	("bench-games,G", po::value<int>()->default_value(1000),   "number of games for benchmark")
 	("bench-period,P", po::value<int>()->default_value(10000),   "benchmark every n games")
+	("plies", po::value<int>()->default_value(0),   "lookahead plies of the trained agent(s) in benchmark games, 0-4")
+	("bench-plies", po::value<int>()->default_value(0),   "lookahead plies of the benchmark agent, 0-4")
+	("search-threads", po::value<int>()->default_value(0),   "threads of the n-ply search and rollouts, 0 for all")
+	("prune", po::value<int>()->default_value(0),   "prune the candidates of the trained agent(s) with cheap evaluations, 0 or 1")
+	("bench-prune", po::value<int>()->default_value(0),   "prune the candidates of the benchmark agent with cheap evaluations, 0 or 1")
+	("prune-keep", po::value<int>()->default_value(5),   "candidates always kept by pruning")
+	("prune-extra", po::value<int>()->default_value(11),   "more candidates kept by pruning within prune-threshold")
+	("prune-threshold", po::value<float>()->default_value(0.16f),   "cheap equity band of the extra candidates")
+	("prune-audit", po::value<int>()->default_value(0),   "count how often pruning cuts the best 0-ply move, 0 or 1")
+	("rollout", po::value< std::string >()->implicit_value("4HPwATDgc/ABMA"),   "roll out a position ID with the first agent")
+	("rollout-trials", po::value<int>()->default_value(1296),   "rollout trials")
+	("rollout-truncate", po::value<int>()->default_value(0),   "plies per rollout trial, 0 for full games")
+	("rollout-seed", po::value<int>()->default_value(0),   "seed of the rollout dice")
+	("rollout-rotate", po::value<int>()->default_value(1),   "stratify the first two rolls of the rollout, 0 or 1")
+	("rollout-varredn", po::value<int>()->default_value(1),   "rollout variance reduction by luck adjustment, 0 or 1")
+	("move-generator,M", po::value< std::string >()->default_value("classic"),   "move generator: classic or bitboard")
+	("fann-isa", po::value< std::string >()->default_value("avx512"),   "fastest FANN kernel to use: generic, sse, avx, fma or avx512")
+	("incremental", po::value<int>()->default_value(0),   "evaluate the candidates of a roll from the hidden sums of the first one, faster but thread timing dependent, 0 or 1")
+	("quant", po::value<int>()->default_value(0),   "evaluate the trained agent(s) in benchmark games and rollouts with 8 or 16 bit integer weights, 0 for floats")
+	("perft", po::value< std::string >(),   "move generator benchmark over a file of position IDs")
+	("perft-selfplay", po::value<int>(),   "move generator benchmark over n positions from seeded random self-play")
+	("perft-seed", po::value<int>()->default_value(12345),   "seed for perft corpus and cross check positions")
+	("perft-passes", po::value<int>()->default_value(1),   "perft passes over the corpus")
+	("perft-save", po::value< std::string >(),   "save the perft corpus as position IDs")
+	("perft-checksum", po::value< std::string >(),   "expected perft checksum (hex)")
+	("perft-allrolls",   "also compare all rolls generation with per roll generation over the perft corpus")
+	("perft-crosscheck", po::value<int>(),   "compare generators move by move over n random positions")
+	("perft-codec", po::value<int>(),   "check and time the position key codec, n random positions")
+	("perft-analytics", po::value<int>(),   "check and time the board analytics, n random positions")
+	("perft-search", po::value<int>(),   "n-ply search scaling over 1..perft-threads threads on the perft corpus, first agent")
+	("perft-threads", po::value<int>()->default_value(0),   "most threads for perft-search, 0 for all")
+	("perft-incremental",   "full against incremental batch evaluation over the perft corpus, first agent")
+	("perft-fann", po::value< std::string >(),   "checks and times every FANN kernel with a network file over the perft corpus")
+	("perft-quant",   "float against 16 and 8 bit integer evaluation over the perft corpus, first agent")
 	;
 }
 
@@ -78,13 +115,69 @@ bool BgDispatcher::init(int argc, char **argv)
 		return false;
 	}
 
+	std::string moveGenerator = m_vm["move-generator"].as< std::string >();
+	if(moveGenerator == "bitboard")
+		BgBoard::setMoveGenerator(MOVEGEN_BITBOARD);
+	else if(moveGenerator != "classic")
+	{
+		fprintf(stderr, "Unknown move generator %s\n", moveGenerator.c_str());
+		return false;
+	}
+
+	std::string fannIsa = m_vm["fann-isa"].as< std::string >();
+	int isa = FANN_ISA_AVX512;
+	while(isa >= FANN_ISA_GENERIC && fannIsa != FANN_ISA_NAMES[isa])
+		isa--;
+	if(isa < FANN_ISA_GENERIC)
+	{
+		fprintf(stderr, "Unknown FANN kernel %s\n", fannIsa.c_str());
+		return false;
+	}
+	fann_set_isa_limit((fann_isa_enum)isa);
+
+	const char *aszPlies[] = {"plies", "bench-plies"};
+	for(int i = 0; i < 2; i++)
+	{
+		int nPlies = m_vm[aszPlies[i]].as<int>();
+		if(nPlies < 0 || nPlies > MAX_FILTER_PLIES)
+		{
+			fprintf(stderr, "Invalid %s %d\n", aszPlies[i], nPlies);
+			return false;
+		}
+	}
+
+	int nQuantBits = m_vm["quant"].as<int>();
+	if(nQuantBits != 0 && nQuantBits != 8 && nQuantBits != 16)
+	{
+		fprintf(stderr, "Invalid quant %d\n", nQuantBits);
+		return false;
+	}
+
+	if(m_vm["prune-keep"].as<int>() < 1 || m_vm["prune-extra"].as<int>() < 0)
+	{
+		fprintf(stderr, "Invalid prune-keep %d or prune-extra %d\n", 
+			m_vm["prune-keep"].as<int>(), m_vm["prune-extra"].as<int>());
+		return false;
+	}
+
 	BgEval::Instance()->load(m_argv[0]);
 	BgEval::Instance()->getRng().seed((unsigned __int32)16000000);
 	return true;
 }
 
-void BgDispatcher::run()
+bool BgDispatcher::run()
 {
+	if(m_vm.count("perft") || m_vm.count("perft-selfplay") || m_vm.count("perft-crosscheck") || 
+		m_vm.count("perft-codec") || m_vm.count("perft-analytics") || needsPerftCorpus())
+	{
+		return runPerft();
+	}
+
+	if(m_vm.count("rollout"))
+	{
+		return runRollout();
+	}
+
 	std::vector<std::string> agentsList;
 	try
 	{
@@ -93,7 +186,7 @@ void BgDispatcher::run()
 	catch(...)
 	{
 		fprintf(stderr, "No agents to train\n");
-		return;
+		return false;
 	}
 	std::string benchAgenName = m_vm["bench-agent"].as< std::string >();
 	time_t start = time(NULL);
@@ -109,6 +202,7 @@ void BgDispatcher::run()
 	time_t total = end - start;
 
 	printf("Elapsed time %02ld:%02ld:%02ld\n", total/3600, (total/60) % 60, total % 60);
+	return true;
 }
 
 void BgDispatcher::runAgentIteration(const char *agentName, const char *benchAgentName)
@@ -122,15 +216,24 @@ void BgDispatcher::runAgentIteration(const char *agentName, const char *benchAge
 	else
 		agent2.reset(BgAgentFactory::createAgent(agentName));
 
+	const bool fIncremental = m_vm["incremental"].as<int>() != 0;
+	agent1->setIncrementalEval(fIncremental);
+	agent2->setIncrementalEval(fIncremental);
+	benchAgent->setIncrementalEval(fIncremental);
+
 	int trainGames = m_vm["train-games"].as<int>();
 	int benchmarkGames = m_vm["bench-games"].as<int>();
 	int benchmarkPeriod = m_vm["bench-period"].as<int>();
+	int plies = m_vm["plies"].as<int>();
+	int benchPlies = m_vm["bench-plies"].as<int>();
+	int searchThreads = m_vm["search-threads"].as<int>();
 
-	runIteration(agent1.get(), benchAgent.get(), agent2.get(), trainGames, benchmarkGames, benchmarkPeriod);
+	runIteration(agent1.get(), benchAgent.get(), agent2.get(), trainGames, benchmarkGames, benchmarkPeriod,
+		plies, benchPlies, searchThreads);
 }
 
 void BgDispatcher::runIteration(BgAgent *agent1, BgAgent *benchAgent, BgAgent *agent2,	
-		int trainGames, int benchmarkGames, int benchmarkPeriod)
+		int trainGames, int benchmarkGames, int benchmarkPeriod, int plies, int benchPlies, int searchThreads)
 {
 	BgGameDispatcher gameDispatcher(agent1, agent2);
 	gameDispatcher.setShowLog(false);
@@ -146,6 +249,11 @@ void BgDispatcher::runIteration(BgAgent *agent1, BgAgent *benchAgent, BgAgent *a
 			//benchmark
 			BgGameDispatcher *benchDispatcher = new BgGameDispatcher(agent1, benchAgent);
 			benchDispatcher->setShowLog(false);
+			benchDispatcher->setPlies(0, plies);
+			benchDispatcher->setPlies(1, benchPlies);
+			benchDispatcher->setSearchThreads(searchThreads);
+			setPruning(benchDispatcher);
+			setQuantized(agent1);
 			int half = benchmarkGames / 2;
 			benchDispatcher->playGames(half, false);
 			benchDispatcher->swapAgents();
@@ -154,6 +262,8 @@ void BgDispatcher::runIteration(BgAgent *agent1, BgAgent *benchAgent, BgAgent *a
 			benchDispatcher->swapAgents();
 			benchDispatcher->printStatistics();
 			delete benchDispatcher;
+			//training goes on with the floats
+			agent1->setQuantized(0);
 		}
 	}
 	else
@@ -161,6 +271,11 @@ void BgDispatcher::runIteration(BgAgent *agent1, BgAgent *benchAgent, BgAgent *a
 		//benchmark
 		BgGameDispatcher *benchDispatcher = new BgGameDispatcher(agent1, benchAgent);
 		benchDispatcher->setShowLog(false);
+		benchDispatcher->setPlies(0, plies);
+		benchDispatcher->setPlies(1, benchPlies);
+		benchDispatcher->setSearchThreads(searchThreads);
+		setPruning(benchDispatcher);
+		setQuantized(agent1);
 		int half = benchmarkGames / 2;
 		benchDispatcher->playGames(half, false);
 		benchDispatcher->swapAgents();
@@ -171,3 +286,162 @@ void BgDispatcher::runIteration(BgAgent *agent1, BgAgent *benchAgent, BgAgent *a
 		delete benchDispatcher;
 	}
 }
+
+void BgDispatcher::setPruning(BgGameDispatcher *benchDispatcher) const
+{
+	movefilter mf;
+	mf.Accept = m_vm["prune-keep"].as<int>();
+	mf.Extra = m_vm["prune-extra"].as<int>();
+	mf.Threshold = m_vm["prune-threshold"].as<float>();
+	benchDispatcher->setPrune(0, m_vm["prune"].as<int>() != 0);
+	benchDispatcher->setPrune(1, m_vm["bench-prune"].as<int>() != 0);
+	benchDispatcher->setPruneFilter(mf, m_vm["prune-audit"].as<int>() != 0);
+}
+
+void BgDispatcher::setQuantized(BgAgent *agent) const
+{
+	const unsigned int nBits = m_vm["quant"].as<int>();
+	if(nBits && !agent->setQuantized(nBits))
+		fprintf(stderr, "%s has no %u bit integer evaluation, it runs the floats\n", 
+			agent->getFullName().c_str(), nBits);
+}
+
+bool BgDispatcher::runRollout()
+{
+	std::string position = m_vm["rollout"].as< std::string >();
+	BgBoard board;
+	if(!BgBoard::PositionFromID(board, position.c_str()) || !board.CheckPosition())
+	{
+		fprintf(stderr, "Invalid position ID %s\n", position.c_str());
+		return false;
+	}
+
+	std::string agentName = m_vm.count("agent") ? 
+		m_vm["agent"].as< std::vector<std::string> >()[0] : std::string("Gnubg");
+	std::auto_ptr<BgAgent> agent(BgAgentFactory::createAgent(agentName.c_str()));
+	if(!agent.get())
+	{
+		fprintf(stderr, "Unknown agent %s\n", agentName.c_str());
+		return false;
+	}
+	agent->setLearnMode(false);
+	agent->setIncrementalEval(m_vm["incremental"].as<int>() != 0);
+	setQuantized(agent.get());
+
+	rolloutcontext rc;
+	rc.nTrials = m_vm["rollout-trials"].as<int>();
+	rc.nTruncate = m_vm["rollout-truncate"].as<int>();
+	rc.nSeed = m_vm["rollout-seed"].as<int>();
+	rc.fRotate = m_vm["rollout-rotate"].as<int>() != 0;
+	rc.fVarRedn = m_vm["rollout-varredn"].as<int>() != 0;
+
+	printf("Rollout of %s by %s: %d trials, %s, %s, %s\n", position.c_str(), agent->getFullName().c_str(), 
+		rc.nTrials, rc.nTruncate ? "truncated" : "full games", 
+		rc.fRotate ? "stratified first rolls" : "random first rolls",
+		rc.fVarRedn ? "variance reduction" : "no variance reduction");
+	if(rc.nTruncate)
+		printf("truncated after %d plies\n", rc.nTruncate);
+
+	BgRollout rollout(agent.get(), rc);
+	rollout.setThreads(m_vm["search-threads"].as<int>());
+	rollout.Rollout(board);
+	rollout.printResults();
+	return true;
+}
+
+//the options that run over the perft corpus
+bool BgDispatcher::needsPerftCorpus() const
+{
+	const char *aszOptions[] = {"perft-save", "perft-checksum", "perft-allrolls", "perft-search", 
+		"perft-incremental", "perft-quant", "perft-fann"};
+	for(size_t i = 0; i < sizeof(aszOptions) / sizeof(aszOptions[0]); i++)
+		if(m_vm.count(aszOptions[i]))
+			return true;
+	return false;
+}
+
+bool BgDispatcher::runPerft()
+{
+	BgPerft perft;
+	unsigned int seed = m_vm["perft-seed"].as<int>();
+
+	if(m_vm.count("perft-codec"))
+	{
+		if(perft.codecCheck(m_vm["perft-codec"].as<int>(), seed))
+			return false;
+	}
+
+	if(m_vm.count("perft-analytics"))
+	{
+		if(perft.analyticsCheck(m_vm["perft-analytics"].as<int>(), seed))
+			return false;
+	}
+
+	if(m_vm.count("perft-crosscheck"))
+	{
+		if(perft.crossCheck(m_vm["perft-crosscheck"].as<int>(), seed))
+			return false;
+	}
+
+	if(m_vm.count("perft"))
+	{
+		if(!perft.loadCorpus(m_vm["perft"].as< std::string >().c_str()))
+			return false;
+	}
+	else if(m_vm.count("perft-selfplay"))
+		perft.generateCorpus(m_vm["perft-selfplay"].as<int>(), seed);
+	else if(needsPerftCorpus())
+	{
+		fprintf(stderr, "No perft corpus, use --perft or --perft-selfplay\n");
+		return false;
+	}
+	else
+		return true;
+
+	if(m_vm.count("perft-save") && !perft.saveCorpus(m_vm["perft-save"].as< std::string >().c_str()))
+		return false;
+
+	unsigned long long checksum = perft.run(m_vm["perft-passes"].as<int>());
+	if(m_vm.count("perft-checksum"))
+	{
+		unsigned long long expected = 0;
+		sscanf(m_vm["perft-checksum"].as< std::string >().c_str(), "%llx", &expected);
+		if(expected != checksum)
+		{
+			printf("Checksum MISMATCH, expected %016llx\n", expected);
+			return false;
+		}
+		printf("Checksum OK\n");
+	}
+
+	if(m_vm.count("perft-allrolls") && perft.runAllRolls(m_vm["perft-passes"].as<int>()))
+		return false;
+
+	if(m_vm.count("perft-search") || m_vm.count("perft-incremental") || m_vm.count("perft-quant"))
+	{
+		std::string agentName = m_vm.count("agent") ? 
+			m_vm["agent"].as< std::vector<std::string> >()[0] : std::string("Gnubg");
+		std::auto_ptr<BgAgent> agent(BgAgentFactory::createAgent(agentName.c_str()));
+		if(!agent.get())
+		{
+			fprintf(stderr, "Unknown agent %s\n", agentName.c_str());
+			return false;
+		}
+		agent->setLearnMode(false);
+		agent->setIncrementalEval(m_vm["incremental"].as<int>() != 0);
+		if(m_vm.count("perft-search") && 
+			perft.searchScaling(agent.get(), m_vm["perft-search"].as<int>(), m_vm["perft-threads"].as<int>(), seed))
+			return false;
+		//rounding may turn near ties either way, a report rather than a check
+		if(m_vm.count("perft-incremental"))
+			perft.incrementalCheck(agent.get(), m_vm["perft-passes"].as<int>(), seed);
+		if(m_vm.count("perft-quant") && perft.quantCheck(agent.get(), m_vm["perft-passes"].as<int>(), seed))
+			return false;
+	}
+
+	if(m_vm.count("perft-fann") && 
+		perft.fannKernelCheck(m_vm["perft-fann"].as< std::string >().c_str(), m_vm["perft-passes"].as<int>(), seed))
+		return false;
+
+	return true;
+}
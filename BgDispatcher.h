@@ -8,12 +8,15 @@
 #include <boost/program_options.hpp>
 namespace po = boost::program_options;
 
+class BgGameDispatcher;
+
 class BgDispatcher
 {
 public:
 	BgDispatcher(void);
 	bool init(int argc, char **argv);
-	void run();
+	//false when a perft check or a rollout failed
+	bool run();
 
 private:
 	int m_argc;
@@ -22,8 +25,13 @@ private:
 	po::options_description m_desc;
 	po::variables_map m_vm;
 	void runAgentIteration(const char *agentName, const char *benchAgentName);
+	bool runPerft();
+	bool needsPerftCorpus() const;
+	bool runRollout();
 	void runIteration(BgAgent *agent1, BgAgent *benchAgent, BgAgent *agent2,
-		int trainGames, int benchmarkGames, int benchmarkPeriod);
+		int trainGames, int benchmarkGames, int benchmarkPeriod, int plies, int benchPlies, int searchThreads);
+	void setPruning(BgGameDispatcher *benchDispatcher) const;
+	void setQuantized(BgAgent *agent) const;
 
 	static void banner();
 	static void showTextArray(char *textArr[]);
@@ -3,6 +3,7 @@
 #include "BgEval.h"
 #include "PositionId.h"
 #include "BgBoard.h"
+#include "BgBoardStats.h"
 #include "bearoffgammon.h"
 
 int BgEval::anChequers[ NUM_VARIATIONS ] = { 15, 15, 1, 2, 3 };
@@ -59,7 +60,7 @@ void BgEval::Destroy()
 	}
 }
 
-void BgEval::SanityCheck(const BgBoard *board, BgReward& reward) const
+void BgEval::SanityCheck(const BgBoardView& board, BgReward& reward) const
 {
 	int i, j, nciq, ac[ 2 ], anBack[ 2 ], anCross[ 2 ], anGammonCross[ 2 ],
 		anBackgammonCross[ 2 ], anMaxTurns[ 2 ], fContact;
@@ -76,51 +77,51 @@ void BgEval::SanityCheck(const BgBoard *board, BgReward& reward) const
 	for( j = 0; j < 2; j++ ) 
 	{
 		for( i = 0, nciq = 0; i < 6; i++ )
-			if( board->anBoard[ j ][ i ] ) 
+			if( board.anBoard[ j ][ i ] ) 
 			{
 				anBack[ j ] = i;
-				nciq += board->anBoard[ j ][ i ];
+				nciq += board.anBoard[ j ][ i ];
 			}
 		ac[ j ] = anCross[ j ] = nciq;
 
 		for( i = 6, nciq = 0; i < 12; i++ )
-			if( board->anBoard[ j ][ i ] ) 
+			if( board.anBoard[ j ][ i ] ) 
 			{
 				anBack[ j ] = i;
-				nciq += board->anBoard[ j ][ i ];
+				nciq += board.anBoard[ j ][ i ];
 			}
 		ac[ j ] += nciq;
 		anCross[ j ] += 2*nciq;
 		anGammonCross[ j ] += nciq;
 
 		for( i = 12, nciq = 0; i < 18; i++ )
-			if( board->anBoard[ j ][ i ] ) 
+			if( board.anBoard[ j ][ i ] ) 
 			{
 				anBack[ j ] = i;
-				nciq += board->anBoard[ j ][ i ];
+				nciq += board.anBoard[ j ][ i ];
 			}
 		ac[ j ] += nciq;
 		anCross[ j ] += 3*nciq;
 		anGammonCross[ j ] += 2*nciq;
 
 		for( i = 18, nciq = 0; i < 24; i++ )
-			if( board->anBoard[ j ][ i ] ) 
+			if( board.anBoard[ j ][ i ] ) 
 			{
 				anBack[ j ] = i;
-				nciq += board->anBoard[ j ][ i ];
+				nciq += board.anBoard[ j ][ i ];
 			}
 		ac[ j ] += nciq;
 		anCross[ j ] += 4*nciq;
 		anGammonCross[ j ] += 3*nciq;
 		anBackgammonCross[ j ] = nciq;
 
-		if( board->anBoard[ j ][ 24 ] ) 
+		if( board.anBoard[ j ][ 24 ] ) 
 		{
 			anBack[ j ] = 24;
-			ac[ j ] += board->anBoard[ j ][ 24 ];
-			anCross[ j ] += 5 * board->anBoard[ j ][ 24 ];
-			anGammonCross[ j ] += 4 * board->anBoard[ j ][ 24 ];
-			anBackgammonCross[ j ] += 2 * board->anBoard[ j ][ 24 ];
+			ac[ j ] += board.anBoard[ j ][ 24 ];
+			anCross[ j ] += 5 * board.anBoard[ j ][ 24 ];
+			anGammonCross[ j ] += 4 * board.anBoard[ j ][ 24 ];
+			anBackgammonCross[ j ] += 2 * board.anBoard[ j ][ 24 ];
 		}
 	}
 
@@ -133,7 +134,7 @@ void BgEval::SanityCheck(const BgBoard *board, BgReward& reward) const
 			if( anBack[ i ] < 6 && pbc1 )
 			{
 				anMaxTurns[ i ] = 
-					MaxTurns( PositionId::PositionBearoff( board->anBoard[ i ], pbc1->nPoints, pbc1->nChequers ) );
+					MaxTurns( PositionId::PositionBearoff( board.anBoard[ i ], pbc1->nPoints, pbc1->nChequers ) );
 			}
 			else
 			{
@@ -257,19 +258,11 @@ int BgEval::MaxTurns( int id ) const
 	return -1;
 }
 
-positionclass BgEval::ClassifyPosition(const BgBoard *anBoard, const bgvariation bgv ) const
+positionclass BgEval::ClassifyPosition(const BgBoardView& anBoard, const bgvariation bgv ) const
 {
-	int nOppBack = -1, nBack = -1;
+	BgBoardStats stats(anBoard);
 
-	for(nOppBack = 24; nOppBack >= 0; --nOppBack) 
-		if( anBoard->anBoard[0][nOppBack] ) 
-			break;
-
-	for(nBack = 24; nBack >= 0; --nBack) 
-		if( anBoard->anBoard[1][nBack] ) 
-			break;
-
-	if( nBack < 0 || nOppBack < 0 )
+	if( stats.IsOver() )
 		return CLASS_OVER;
 
 	// special classes for hypergammon variants 
@@ -291,41 +284,8 @@ positionclass BgEval::ClassifyPosition(const BgBoard *anBoard, const bgvariation
 	case VARIATION_STANDARD:
 	case VARIATION_NACKGAMMON:
 		// normal backgammon 
-	    if( nBack + nOppBack > 22 ) 
-		{
-			// contact position
-			unsigned int const N = 6;
-			unsigned int i;
-			unsigned int side;
-    
-			for(side = 0; side < 2; ++side) 
-			{
-				unsigned int tot = 0;
-				const char* board = anBoard->anBoard[side];
-      
-		        for(i = 0;  i < 25; ++i) 
-					tot += board[i];
-
-				if( tot <= N ) 
-					return CLASS_CRASHED;
-				else 
-				{
-					if( board[0] > 1 ) 
-					{
-						if( tot <= (N + board[0]) ) 
-							return CLASS_CRASHED;
-						else 
-						if( board[1] > 1 && (1 + tot - (board[0] + board[1])) <= N ) 
-							return CLASS_CRASHED;
-					} 
-					else 
-					if( tot <= (N + (board[1] - 1))) 
-						return CLASS_CRASHED;
-				}
-			}
-
-			return CLASS_CONTACT;
-		}
+	    if( stats.IsContact() ) 
+			return stats.IsCrashed() ? CLASS_CRASHED : CLASS_CONTACT;
 		else 
 		{
     		if ( isBearoff ( pbc2, anBoard ) )
@@ -352,69 +312,69 @@ positionclass BgEval::ClassifyPosition(const BgBoard *anBoard, const bgvariation
 	return CLASS_OVER;   // for fussy compilers
 }
 
-int BgEval::EvalBearoff2(const BgBoard *anBoard, BgReward& arOutput) const
+int BgEval::EvalBearoff2(const BgBoardView& anBoard, BgReward& arOutput) const
 {
 	assert ( pbc2 );
 	return BearoffEval ( pbc2, anBoard, arOutput );
 }
 
-int BgEval::EvalBearoffOS(const BgBoard *anBoard, BgReward& arOutput) const 
+int BgEval::EvalBearoffOS(const BgBoardView& anBoard, BgReward& arOutput) const 
 {
 	assert ( pbcOS );
 	return BearoffEval ( pbcOS, anBoard, arOutput );
 }
 
-int BgEval::EvalBearoffTS(const BgBoard *anBoard, BgReward& arOutput) const 
+int BgEval::EvalBearoffTS(const BgBoardView& anBoard, BgReward& arOutput) const 
 {
 	assert ( pbcTS );
 	return BearoffEval ( pbcTS, anBoard, arOutput );
 }
 
-int BgEval::EvalHypergammon1(const BgBoard *anBoard, BgReward& arOutput) const 
+int BgEval::EvalHypergammon1(const BgBoardView& anBoard, BgReward& arOutput) const 
 {
 	assert ( apbcHyper[ 0 ] );
 	return BearoffEval ( apbcHyper[ 0 ], anBoard, arOutput );
 }
 
-int BgEval::EvalHypergammon2(const BgBoard *anBoard, BgReward& arOutput) const 
+int BgEval::EvalHypergammon2(const BgBoardView& anBoard, BgReward& arOutput) const 
 {
 	assert ( apbcHyper[ 1 ] );
 	return BearoffEval ( apbcHyper[ 1 ], anBoard, arOutput );
 }
 
-int BgEval::EvalHypergammon3(const BgBoard *anBoard, BgReward& arOutput) const 
+int BgEval::EvalHypergammon3(const BgBoardView& anBoard, BgReward& arOutput) const 
 {
 	assert ( apbcHyper[ 2 ] );
 	return BearoffEval ( apbcHyper[ 2 ], anBoard, arOutput );
 }
 
-int BgEval::EvalBearoff1(const BgBoard *anBoard, BgReward& arOutput) const
+int BgEval::EvalBearoff1(const BgBoardView& anBoard, BgReward& arOutput) const
 {
 	assert ( pbc1 );
 	return BearoffEval( pbc1, anBoard, arOutput );
 }
 
-float BgEval::raceBGprob(const BgBoard *anBoard, const int side, const bgvariation bgv) const
+float BgEval::raceBGprob(const BgBoardView& anBoard, const int side, const bgvariation bgv) const
 {
 	int totMenHome = 0;
 	int totPipsOp = 0;
 	BgBoard dummy;
   
 	for(int i = 0; i < 6; ++i)
-		totMenHome += anBoard->anBoard[side][i];
+		totMenHome += anBoard.anBoard[side][i];
 	
 	for(int i = 22; i >= 18; --i) 
-		totPipsOp += anBoard->anBoard[1-side][i] * (i-17);
+		totPipsOp += anBoard.anBoard[1-side][i] * (i-17);
 	
 
 	if(! ((totMenHome + 3) / 4 - (side == 1 ? 1 : 0) <= (totPipsOp + 2) / 3) )
 		return 0.0f;
 
 	for(int i = 0; i < 25; ++i) 
-		dummy.anBoard[side][i] = anBoard->anBoard[side][i];
+		dummy.anBoard[side][i] = anBoard.anBoard[side][i];
 
 	for(int i = 0; i < 6; ++i)
-		dummy.anBoard[1-side][i] = anBoard->anBoard[1-side][18+i];
+		dummy.anBoard[1-side][i] = anBoard.anBoard[1-side][18+i];
 
 	for(int i = 6; i < 25; ++i)
 		dummy.anBoard[1-side][i] = 0;
@@ -423,7 +383,7 @@ float BgEval::raceBGprob(const BgBoard *anBoard, const int side, const bgvariati
 		const long* bgp = getRaceBGprobs(dummy.anBoard[1-side]);
 		if( bgp ) 
 		{
-			int k = PositionId::PositionBearoff(anBoard->anBoard[side], pbc1->nPoints, pbc1->nChequers);
+			int k = PositionId::PositionBearoff(anBoard.anBoard[side], pbc1->nPoints, pbc1->nChequers);
 			unsigned short int aProb[32];
 			float p = 0.0f;
 			unsigned long scale = (side == 0) ? 36 : 1;
@@ -447,11 +407,11 @@ float BgEval::raceBGprob(const BgBoard *anBoard, const int side, const bgvariati
       		if( PositionId::PositionBearoff( dummy.anBoard[0], 6, 15 ) > 923 ||
 				PositionId::PositionBearoff( dummy.anBoard[1], 6, 15 ) > 923 ) 
 			{
-				EvalBearoff1(&dummy, p);
+				EvalBearoff1(dummy, p);
 			} 
 			else 
 			{
-				EvalBearoff2(&dummy, p);
+				EvalBearoff2(dummy, p);
 			}
 
 			return side == 1 ? p[0] : 1 - p[0];
@@ -528,13 +488,13 @@ void BgEval::BearoffProgress( unsigned int i )
     //fflush( stdout );
 }
 
-int BgEval::EvalOver( const BgBoard *anBoard, BgReward& arOutput, const bgvariation bgv) const
+int BgEval::EvalOver( const BgBoardView& anBoard, BgReward& arOutput, const bgvariation bgv) const
 {
 	int i, c;
 	int n = anChequers[ bgv ];
 
 	for( i = 0; i < 25; i++ )
-		if( anBoard->anBoard[ 0 ][ i ] )
+		if( anBoard.anBoard[ 0 ][ i ] )
 		break;
 
 	if( i == 25 ) 
@@ -543,7 +503,7 @@ int BgEval::EvalOver( const BgBoard *anBoard, BgReward& arOutput, const bgvariat
 		arOutput[ OUTPUT_WIN ] = arOutput[ OUTPUT_WINGAMMON ] = arOutput[ OUTPUT_WINBACKGAMMON ] = 0.0;
 
 		for( i = 0, c = 0; i < 25; i++ )
-			c += anBoard->anBoard[ 1 ][ i ];
+			c += anBoard.anBoard[ 1 ][ i ];
 
 		if( c == n ) 
 		{
@@ -552,7 +512,7 @@ int BgEval::EvalOver( const BgBoard *anBoard, BgReward& arOutput, const bgvariat
 
 			for( i = 18; i < 25; i++ )
 			{
-				if( anBoard->anBoard[ 1 ][ i ] ) 
+				if( anBoard.anBoard[ 1 ][ i ] ) 
 				{
 					/* player still has pieces in opponent's home board;
 					loses backgammon */
@@ -570,7 +530,7 @@ int BgEval::EvalOver( const BgBoard *anBoard, BgReward& arOutput, const bgvariat
 	}
     
 	for( i = 0; i < 25; i++ )
-		if( anBoard->anBoard[ 1 ][ i ] )
+		if( anBoard.anBoard[ 1 ][ i ] )
 			break;
 
 	if( i == 25 ) 
@@ -580,7 +540,7 @@ int BgEval::EvalOver( const BgBoard *anBoard, BgReward& arOutput, const bgvariat
 		arOutput[ OUTPUT_LOSEGAMMON ] = arOutput[ OUTPUT_LOSEBACKGAMMON ] = 0.0;
 
 		for( i = 0, c = 0; i < 25; i++ )
-			c += anBoard->anBoard[ 0 ][ i ];
+			c += anBoard.anBoard[ 0 ][ i ];
 
 		if( c == n ) 
 		{
@@ -589,7 +549,7 @@ int BgEval::EvalOver( const BgBoard *anBoard, BgReward& arOutput, const bgvariat
 
 			for( i = 18; i < 25; i++ )
 			{
-				if( anBoard->anBoard[ 0 ][ i ] ) 
+				if( anBoard.anBoard[ 0 ][ i ] ) 
 				{
 					/* opponent still has pieces in player's home board;
 					win backgammon */
@@ -18,7 +18,7 @@ enum evaltype { EVAL_NONE, EVAL_EVAL, EVAL_ROLLOUT } ;
 
 /* we'll have filters for 1..4 ply evaluation */
 #define MAX_FILTER_PLIES	4
-//extern movefilter defaultFilters[MAX_FILTER_PLIES][MAX_FILTER_PLIES];
+extern movefilter defaultFilters[MAX_FILTER_PLIES][MAX_FILTER_PLIES];
 
 struct evalcontext
 {
@@ -51,11 +51,29 @@ struct evalcontext
 
 #define SGF_FORMAT_VER 3
 
+struct rolloutcontext
+{
+    unsigned int nTrials;
+    unsigned int nTruncate;     /* plies per trial, 0 plays games to the end */
+    unsigned int fVarRedn : 1;  /* variance reduction by luck adjustment */
+    unsigned int fRotate : 1;   /* stratify the first two rolls over the trials */
+    unsigned long nSeed;
+
+	rolloutcontext()
+	{
+		nTrials = 1296;
+		nTruncate = 0;
+		fVarRedn = 1;
+		fRotate = 1;
+		nSeed = 0;
+	}
+};
+
 struct evalsetup
 {
   evaltype et;
   evalcontext ec;
-  //rolloutcontext rc;
+  rolloutcontext rc;
 };
 
 
@@ -126,6 +144,7 @@ namespace fs = boost::filesystem;
 using namespace std;
 
 class BgBoard;
+class BgBoardView;
 class BgEval
 {
 public:
@@ -144,24 +163,24 @@ public:
 	bool load(const char *path);
 
 	//validation
-	void SanityCheck(const BgBoard *board, BgReward& reward) const;
+	void SanityCheck(const BgBoardView& board, BgReward& reward) const;
 
 	//classification
-	positionclass ClassifyPosition(const BgBoard *board, const bgvariation bgv) const;
+	positionclass ClassifyPosition(const BgBoardView& board, const bgvariation bgv) const;
 
 	//Bearoff evaluation
-	int EvalOver( const BgBoard *anBoard, BgReward& arOutput, const bgvariation bgv) const;
-	int EvalHypergammon1(const BgBoard *anBoard, BgReward& arOutput) const;
-	int EvalHypergammon2(const BgBoard *anBoard, BgReward& arOutput) const;
-	int EvalHypergammon3(const BgBoard *anBoard, BgReward& arOutput) const;
-	int EvalBearoff2(const BgBoard *anBoard, BgReward& arOutput) const;
-	int EvalBearoffTS(const BgBoard *anBoard, BgReward& arOutput) const;
-	int EvalBearoff1(const BgBoard *anBoard, BgReward& arOutput) const;
-	int EvalBearoffOS(const BgBoard *anBoard, BgReward& arOutput) const;
+	int EvalOver( const BgBoardView& anBoard, BgReward& arOutput, const bgvariation bgv) const;
+	int EvalHypergammon1(const BgBoardView& anBoard, BgReward& arOutput) const;
+	int EvalHypergammon2(const BgBoardView& anBoard, BgReward& arOutput) const;
+	int EvalHypergammon3(const BgBoardView& anBoard, BgReward& arOutput) const;
+	int EvalBearoff2(const BgBoardView& anBoard, BgReward& arOutput) const;
+	int EvalBearoffTS(const BgBoardView& anBoard, BgReward& arOutput) const;
+	int EvalBearoff1(const BgBoardView& anBoard, BgReward& arOutput) const;
+	int EvalBearoffOS(const BgBoardView& anBoard, BgReward& arOutput) const;
 
 	//side - side that potentially can win a backgammon
 	//Return - Probablity that side will win a backgammon
-	float raceBGprob(const BgBoard *anBoard, const int side, const bgvariation bgv) const;
+	float raceBGprob(const BgBoardView& anBoard, const int side, const bgvariation bgv) const;
 
 	mt19937& getRng() { return m_rng; }
 	const fs::path getBasePath() const {return m_basePath;}
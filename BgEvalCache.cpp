@@ -0,0 +1,120 @@
+#include <string.h>
+#include "BgEvalCache.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#pragma intrinsic(_InterlockedCompareExchange, _InterlockedIncrement, _ReadWriteBarrier)
+#define CACHE_CAS(p, oldVal, newVal) _InterlockedCompareExchange((p), (newVal), (oldVal))
+#define CACHE_INC(p) _InterlockedIncrement(p)
+#define CACHE_BARRIER() _ReadWriteBarrier()
+#else
+#define CACHE_CAS(p, oldVal, newVal) __sync_val_compare_and_swap((p), (oldVal), (newVal))
+#define CACHE_INC(p) __sync_add_and_fetch((p), 1)
+#define CACHE_BARRIER() __asm__ __volatile__("" ::: "memory")
+#endif
+
+BgEvalCache::BgEvalCache(unsigned int cSetsLog2)
+{
+	m_cSets = 1u << cSetsLog2;
+	m_nShift = 64 - cSetsLog2;
+	m_aEntries = new entry[m_cSets * WAYS];
+	m_anNext = new long[m_cSets];
+	Clear();
+}
+
+BgEvalCache::~BgEvalCache()
+{
+	delete [] m_aEntries;
+	delete [] m_anNext;
+}
+
+void BgEvalCache::Clear()
+{
+	memset((void *)m_aEntries, 0, m_cSets * WAYS * sizeof(entry));
+	memset((void *)m_anNext, 0, m_cSets * sizeof(long));
+	m_nHits = m_nMisses = m_nEvictions = 0;
+}
+
+unsigned int BgEvalCache::SetIndex(const AuchKey& auch) const
+{
+	unsigned long long lo;
+	unsigned short hi;
+	memcpy(&lo, auch.begin(), sizeof(lo));
+	memcpy(&hi, auch.begin() + sizeof(lo), sizeof(hi));
+	//multiplicative hash, the top bits select the set
+	return (unsigned int)(((lo ^ ((unsigned long long)hi << 47)) * 0x9E3779B97F4A7C15ull) >> m_nShift);
+}
+
+bool BgEvalCache::Lookup(const AuchKey& auch, unsigned int nVersion, BgReward& reward)
+{
+	entry *aSet = m_aEntries + SetIndex(auch) * WAYS;
+
+	for(unsigned int i = 0; i < WAYS; i++)
+	{
+		entry& e = aSet[i];
+		long nSeq = e.nSeq;
+		if(!nSeq || (nSeq & 1))
+			continue;
+
+		CACHE_BARRIER();
+		if(e.nVersion != nVersion || e.auch != auch)
+			continue;
+
+		float arOutput[NUM_OUTPUTS];
+		memcpy(arOutput, e.arOutput, sizeof(arOutput));
+		CACHE_BARRIER();
+		//the entry was rewritten while being copied
+		if(e.nSeq != nSeq)
+			break;
+
+		for(int j = 0; j < NUM_OUTPUTS; j++)
+			reward[j] = arOutput[j];
+#pragma omp atomic
+		m_nHits++;
+		return true;
+	}
+
+#pragma omp atomic
+	m_nMisses++;
+	return false;
+}
+
+void BgEvalCache::Store(const AuchKey& auch, unsigned int nVersion, const BgReward& reward)
+{
+	const unsigned int iSet = SetIndex(auch);
+	entry *aSet = m_aEntries + iSet * WAYS;
+
+	//the same position from older weights, then a free way, then a way
+	//holding older weights, then round robin
+	entry *pe = NULL;
+	for(unsigned int i = 0; i < WAYS && !pe; i++)
+		if(aSet[i].auch == auch)
+			pe = aSet + i;
+	for(unsigned int i = 0; i < WAYS && !pe; i++)
+		if(!aSet[i].nSeq)
+			pe = aSet + i;
+	for(unsigned int i = 0; i < WAYS && !pe; i++)
+		if(aSet[i].nVersion != nVersion)
+			pe = aSet + i;
+	//threads storing to the same set each take the next way
+	if(!pe)
+		pe = aSet + ((unsigned long)CACHE_INC(m_anNext + iSet) % WAYS);
+
+	long nSeq = pe->nSeq;
+	//another thread is writing the entry, this evaluation is just not cached
+	if((nSeq & 1) || CACHE_CAS(&pe->nSeq, nSeq, nSeq + 1) != nSeq)
+		return;
+
+	if(nSeq && pe->nVersion == nVersion && pe->auch != auch)
+	{
+#pragma omp atomic
+		m_nEvictions++;
+	}
+
+	pe->nVersion = nVersion;
+	pe->auch = auch;
+	for(int j = 0; j < NUM_OUTPUTS; j++)
+		pe->arOutput[j] = reward[j];
+	CACHE_BARRIER();
+	pe->nSeq = nSeq + 2;
+}
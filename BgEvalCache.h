@@ -0,0 +1,58 @@
+#ifndef __BGEVALCACHE_H
+#define __BGEVALCACHE_H
+
+#pragma once
+
+#include "BgReward.h"
+#include "BgMove.h"
+
+// Fixed size, set associative cache of network evaluations keyed by the
+// position key and the version of the weights that produced them. Entries
+// are guarded by a sequence counter instead of a lock: a writer makes the
+// counter odd while it fills the entry, a reader retries nothing and takes
+// a miss when the counter was odd or changed under it. Lookup and Store can
+// be called from several OpenMP threads at once; Clear can not.
+// Evaluations of older weights are never returned since the version is
+// part of the key, so a learning agent needs no explicit invalidation.
+class BgEvalCache
+{
+public:
+	static const unsigned int WAYS = 4;
+
+	BgEvalCache(unsigned int cSetsLog2 = 14);
+	~BgEvalCache();
+
+	bool Lookup(const AuchKey& auch, unsigned int nVersion, BgReward& reward);
+	void Store(const AuchKey& auch, unsigned int nVersion, const BgReward& reward);
+	void Clear();
+
+	unsigned long long Hits() const {return m_nHits;}
+	unsigned long long Misses() const {return m_nMisses;}
+	unsigned long long Evictions() const {return m_nEvictions;}
+	unsigned int Size() const {return m_cSets * WAYS;}
+
+private:
+	struct entry
+	{
+		//even when the entry is stable, 0 for a never written one
+		volatile long nSeq;
+		unsigned int nVersion;
+		AuchKey auch;
+		float arOutput[NUM_OUTPUTS];
+	};
+
+	entry *m_aEntries;
+	//round robin victim of each set, advanced atomically
+	volatile long *m_anNext;
+	unsigned int m_cSets;
+	unsigned int m_nShift;
+
+	unsigned long long m_nHits, m_nMisses, m_nEvictions;
+
+	unsigned int SetIndex(const AuchKey& auch) const;
+
+	BgEvalCache(const BgEvalCache&);
+	BgEvalCache& operator=(const BgEvalCache&);
+};
+
+#endif
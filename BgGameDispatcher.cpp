@@ -16,17 +16,25 @@ BgGameDispatcher::BgGameDispatcher(BgAgent *agent1, BgAgent *agent2)
 	m_wonGames[0] = m_wonGames[1] = 0;
 	m_wonPoints[0] = m_wonPoints[1] = 0;
 	m_numGames = 0;
+	m_nTurns = m_nForcedTurns = 0;
+	m_rSeconds = 0;
 	pmr_hint = NULL;
 
 	m_learnMode = false;
 	m_isShowLog = false;
 	m_fAutoCrawford = true;
 
+	m_search[0] = new BgSearch();
+	m_search[1] = new BgSearch();
+	setTopMoves(1);
+
 	//m_amMoves.resize(movelist::MAX_INCOMPLETE_MOVES);
 }
 
 BgGameDispatcher::~BgGameDispatcher(void)
 {
+	delete m_search[0];
+	delete m_search[1];
 }
 
 void BgGameDispatcher::swapAgents()
@@ -34,6 +42,40 @@ void BgGameDispatcher::swapAgents()
 	std::swap(m_agents[0], m_agents[1]);
 	std::swap(m_wonGames[0], m_wonGames[1]);
 	std::swap(m_wonPoints[0], m_wonPoints[1]);
+	std::swap(m_search[0], m_search[1]);
+	std::swap(m_aec[0], m_aec[1]);
+}
+
+void BgGameDispatcher::setPlies(int iAgent, int nPlies)
+{
+	m_aec[iAgent].nPlies = nPlies;
+}
+
+void BgGameDispatcher::setSearchThreads(int nThreads)
+{
+	m_search[0]->setThreads(nThreads);
+	m_search[1]->setThreads(nThreads);
+}
+
+void BgGameDispatcher::setPrune(int iAgent, bool fPrune)
+{
+	m_aec[iAgent].fUsePrune = fPrune;
+}
+
+void BgGameDispatcher::setTopMoves(unsigned int nTop)
+{
+	m_nTopMoves = nTop;
+	for(int i = 0; i < 2; i++)
+		m_search[i]->setTopMoves(nTop);
+}
+
+void BgGameDispatcher::setPruneFilter(const movefilter& mf, bool fAudit)
+{
+	for(int i = 0; i < 2; i++)
+	{
+		m_search[i]->setPruneFilter(mf);
+		m_search[i]->setPruneAudit(fAudit);
+	}
 }
 
 void BgGameDispatcher::playGames(int numGames, bool learn)
@@ -43,6 +85,7 @@ void BgGameDispatcher::playGames(int numGames, bool learn)
 	m_agents[0]->setLearnMode(learn);
 	m_agents[1]->setLearnMode(learn);
 
+	const double rStart = omp_get_wtime();
 	for(int i = m_numGames+1; i < m_numGames + numGames + 1; i++)
 	{
 		playGame();	
@@ -54,6 +97,7 @@ void BgGameDispatcher::playGames(int numGames, bool learn)
 	}
 
 	m_numGames += numGames;
+	m_rSeconds += omp_get_wtime() - rStart;
 }
 
 void BgGameDispatcher::playGame()
@@ -96,6 +140,48 @@ void BgGameDispatcher::printStatistics()
 	printf("%c:%s: won %+5.3f ppg\n", signs[0], m_agents[0]->getFullName().c_str(), 
 		float(m_wonPoints[0] - m_wonPoints[1]) / m_numGames);
 
+	printf("forced moves %llu/%llu turns = %5.2f%%, %.1f games/s\n", m_nForcedTurns, m_nTurns,
+		m_nTurns ? float(m_nForcedTurns) / m_nTurns * 100 : 0.0f, m_rSeconds > 0 ? m_numGames / m_rSeconds : 0.0);
+
+	for(int i = 0; i < 2; i++)
+	{
+		const BgEvalCache *cache = m_agents[i]->getEvalCache();
+		if(!cache)
+			continue;
+
+		unsigned long long lookups = cache->Hits() + cache->Misses();
+		printf("%c:%s: eval cache hits %llu/%llu = %5.2f%%, evictions %llu\n", 
+			signs[i], m_agents[i]->getFullName().c_str(), 
+			cache->Hits(), lookups, lookups ? float(cache->Hits()) / lookups * 100 : 0.0f, cache->Evictions());
+	}
+
+	for(int i = 0; i < 2; i++)
+	{
+		if(!m_aec[i].nPlies)
+			continue;
+
+		double seconds = m_search[i]->getSeconds();
+		printf("%c:%s: %d-ply search %llu nodes, %.0f nodes/s, %d thread(s)\n", 
+			signs[i], m_agents[i]->getFullName().c_str(), m_aec[i].nPlies,
+			m_search[i]->getNodes(), seconds > 0 ? m_search[i]->getNodes() / seconds : 0.0,
+			m_agents[i]->isReentrant() ? m_search[i]->getThreads() : 1);
+	}
+
+	for(int i = 0; i < 2; i++)
+	{
+		const BgSearch::prunestats& ps = m_search[i]->getPruneStats();
+		if(!ps.nDecisions)
+			continue;
+
+		printf("%c:%s: pruning kept %llu/%llu candidates = %5.2f%% in %llu moves\n", 
+			signs[i], m_agents[i]->getFullName().c_str(), ps.nKept, ps.nCandidates, 
+			float(ps.nKept) / ps.nCandidates * 100, ps.nDecisions);
+		if(ps.nAudited)
+			printf("%c:%s: pruning cut the best 0-ply move %llu/%llu = %5.2f%%, %.4f equity per move\n", 
+				signs[i], m_agents[i]->getFullName().c_str(), ps.nBestPruned, ps.nAudited,
+				float(ps.nBestPruned) / ps.nAudited * 100, ps.rEquityLost / ps.nAudited);
+	}
+
 	fs::path logPath =  m_agents[0]->getPath();
 	logPath /= m_agents[0]->getFullName() + " vs " + m_agents[1]->getFullName() + ".csv";
 	FILE *f = fopen(logPath.string().c_str(), "at");
@@ -600,8 +686,7 @@ void BgGameDispatcher::computerTurn()
 			{
 				bgmove endMove = pmr.ml.amMoves[0];
 				BgBoard board = BgBoard::PositionFromKey(endMove.auch);
-				board.SwapSides();
-				endMove.auch = board.PositionKey();
+				endMove.auch = BgBoardView(board, true).PositionKey();
 				endMove.arEvalMove.invert();
 				m_agents[!m_currentMatch.fMove]->doMove(endMove);
 			}
@@ -718,109 +803,50 @@ int BgGameDispatcher::FindnSaveBestMoves( movelist *pml, int nDice0, int nDice1,
 	//it doesn't now
 	anBoard.GenerateMoves( pml, m_amMoves, nDice0, nDice1, false );
 	m_agents[m_currentMatch.fMove]->setCurrentBoard(&m_currentMatch.anBoard);
+	m_nTurns++;
 	if ( pml->cMoves == 0 ) 
 	{
 		/* no legal moves */
+		m_nForcedTurns++;
 		pml->amMoves = NULL;
 		return 0;
 	}
- 
-	/* Save moves */
-	bgmove *pm = new bgmove [ pml->cMoves ];
-	for(size_t i = 0; i < pml->cMoves; i++)
-		pm[i] = pml->amMoves[i];
-	pml->amMoves = pm;
-	nMoves = pml->cMoves;
-
-	/* evaluate moves on top ply */
-	if( ScoreMoves( pml ) < 0 ) 
-	{
-		delete [] pm;
-		pml->deleteMoves();
-		return -1;
-	}
-
-	/* Resort the moves, in case the new evaluation reordered them. */
-	//std::vector<move>::iterator it(pml->amMoves); 
-	std::sort(pml->amMoves, pml->amMoves + pml->cMoves, std::less<bgmove>() );
-	//qsort( pml->amMoves, pml->cMoves, sizeof( move ), (cfunc) move::CompareMovesGeneral );
-	pml->iMoveBest = 0;
-	/* set the proper size of the movelist */
-  	cOldMoves = pml->cMoves;
-	pml->cMoves = nMoves;
-
-	return 0;
-}
-
-int BgGameDispatcher::ScoreMoves( movelist *pml ) const
-{
-	unsigned int i;
-	int r = 0;	/* return value */
-	pml->rBestScore = -99999.9f;
 
-	for( i = 0; i < pml->cMoves; i++ ) 
+	if ( pml->cMoves == 1 )
 	{
-		if( ScoreMove(pml->amMoves[i]) < 0 ) 
-		{
-			r = -1;
-			break;
-		}
-
-		if( pml->amMoves[ i ].rScore > pml->rBestScore )
-		{
-			pml->iMoveBest = i;
-			pml->rBestScore = pml->amMoves[ i ].rScore;
-		}
+		/* a forced move, equal positions were merged by GenerateMoves; there
+		   is nothing to choose, only the TD update of a learning agent needs
+		   the class and the result of a finished game */
+		m_nForcedTurns++;
+		bgmove *pm = new bgmove [ 1 ];
+		pm[0] = pml->amMoves[0];
+		BgBoard board = BgBoard::PositionFromKey(pm[0].auch);
+		pm[0].pc = BgEval::Instance()->ClassifyPosition(BgBoardView(board, true), VARIATION_STANDARD);
+		if( m_learnMode && pm[0].pc == CLASS_OVER )
+			m_search[m_currentMatch.fMove]->EvaluatePosition( m_agents[m_currentMatch.fMove], board, 0, 
+				pm[0].arEvalMove, pm[0].pc );
+		pm[0].rScore = pm[0].arEvalMove[OUTPUT_EQUITY];
+		pml->amMoves = pm;
+		pml->iMoveBest = 0;
+		pml->rBestScore = pm[0].rScore;
+		return 0;
 	}
+ 
+	nMoves = pml->cMoves;
 
- 	return r;
-}
-
-int BgGameDispatcher::ScoreMove(bgmove& pm) const
-{
-    BgBoard anBoardTemp = BgBoard::PositionFromKey( pm.auch );
-    anBoardTemp.SwapSides();
-
-    BgReward arEval;
-    if ( GeneralEvaluationEPlied (arEval, &anBoardTemp, pm.pc ) )
-		return -1;
-
-	BgAgent *agent = m_agents[m_currentMatch.fMove];
-
-	if(agent->needsInvertedEval())
-		arEval.invert();
-	else
-	if(pm.pc != CLASS_CONTACT && pm.pc != CLASS_CRASHED && pm.pc != CLASS_RACE)
-		arEval.invert();
-
-    /* Save evaluations */  
-    pm.arEvalMove = arEval;
-    pm.rScore = arEval[ OUTPUT_EQUITY ];
-
-    return 0;
-}
-
-int BgGameDispatcher::GeneralEvaluationEPlied (BgReward& arOutput, const BgBoard *anBoard, positionclass& pc ) const
-{
-	pc = BgEval::Instance()->ClassifyPosition ( anBoard, VARIATION_STANDARD );
-	if ( EvaluatePositionFull ( anBoard, arOutput, pc ) )
-		return -1;
-
-	arOutput[ OUTPUT_EQUITY ] = arOutput.utility();
-	return 0;
-}
-
-int BgGameDispatcher::EvaluatePositionFull(const BgBoard *anBoard, BgReward& arOutput, positionclass& pc ) const
-{
-	/* at leaf node; use static evaluation */
-	BgAgent *agent = m_agents[m_currentMatch.fMove];
-	agent->evaluatePosition(anBoard, pc, arOutput);
+	/* evaluate the moves in place, pruning them between the plies, and put
+	   the best ones first */
+	m_search[m_currentMatch.fMove]->FindBestMoves( m_agents[m_currentMatch.fMove], pml, m_aec[m_currentMatch.fMove] );
+	cOldMoves = pml->cMoves;
 
-	if (pc > CLASS_PERFECT && agent->supportsSanityCheck() && !agent->isLearnMode())
-	{
-		/* no sanity check needed for exact evaluations */
-		BgEval::Instance()->SanityCheck( anBoard, arOutput );
-	}
+	/* save the moves: just the best ones when nothing looks at the others,
+	   or all of them for hints and analysis */
+	unsigned int cSave = m_nTopMoves ? std::min(m_nTopMoves, (unsigned int)cOldMoves) : nMoves;
+	bgmove *pm = new bgmove [ cSave ];
+	for(size_t i = 0; i < cSave; i++)
+		pm[i] = pml->amMoves[i];
+	pml->amMoves = pm;
+	pml->cMoves = cSave;
 
 	return 0;
 }
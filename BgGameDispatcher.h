@@ -5,6 +5,7 @@
 #include <list>
 #include "Agent/BgAgent.h"
 #include "BgMatch.h"
+#include "BgSearch.h"
 
 class BgGameDispatcher
 {
@@ -19,6 +20,17 @@ public:
 	void setShowLog(bool show) {m_isShowLog = show;}
 
 	void swapAgents();
+	//lookahead of the agent's move choice, 0 is a static evaluation
+	void setPlies(int iAgent, int nPlies);
+	//threads of the searches, 0 means all
+	void setSearchThreads(int nThreads);
+	//cut the candidates by the agent's cheap evaluator before scoring them
+	void setPrune(int iAgent, bool fPrune);
+	//the cut, and whether to check it against the full evaluation
+	void setPruneFilter(const movefilter& mf, bool fAudit);
+	//how many of the best moves a move record keeps, in order; 0 keeps all
+	//the candidates sorted, for hints and analysis
+	void setTopMoves(unsigned int nTop);
 
 	//export
 	void ExportMatchMat( char *sz, bool fSst ) const;
@@ -32,10 +44,17 @@ private:
 	bool m_learnMode;
 	bool m_isShowLog;
 	int m_numGames;
+	//turns played, those with at most one legal move, and the time spent
+	//in playGames
+	unsigned long long m_nTurns, m_nForcedTurns;
+	double m_rSeconds;
 	matchstate m_currentMatch;
 	std::list<std::list<moverecord> > m_lMatch;
 	moverecord *pmr_hint;
 	bgmove m_amMoves[movelist::MAX_INCOMPLETE_MOVES];
+	BgSearch *m_search[2];
+	unsigned int m_nTopMoves;
+	evalcontext m_aec[2];
 
 	bool m_fAutoCrawford;
 
@@ -63,10 +82,6 @@ private:
 	int FindnSaveBestMoves( movelist *pml, int nDice0, int nDice1,
 		const BgBoard& anBoard, unsigned char *auchMove, const
 		float rThr, const cubeinfo* pci);
-	int ScoreMoves( movelist *pml) const;
-	int ScoreMove(bgmove& pm) const;
-	int GeneralEvaluationEPlied (BgReward& arOutput, const BgBoard *anBoard, positionclass& pc ) const;
-	int EvaluatePositionFull(const BgBoard *anBoard, BgReward& arOutput, positionclass& pc) const;
 
 	//export-import
 	void ExportGameJF( FILE *pf, const std::list<moverecord>& plGame, int iGame, bool withScore, bool fSst ) const;
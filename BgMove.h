@@ -3,7 +3,9 @@
 
 #pragma once
 
+#include <string.h>
 #include <vector>
+#include <algorithm>
 #include "BgCommon.h"
 #include "BgEval.h"
 
@@ -15,13 +17,33 @@
 #define FALSE 0
 #endif
 
-class AuchKey : public std::vector<unsigned char>
+// gnubg 80 bit position key. Fixed size value type: copying a key never
+// touches the heap, which matters in the move generator
+class AuchKey
 {
 public:
+	typedef unsigned char value_type;
+	static const unsigned int KEY_SIZE = 10;
+
 	AuchKey() 
 	{
-		resize(10, 0);
+		memset(m_auch, 0, sizeof(m_auch));
 	}
+
+	value_type& operator[](unsigned int i) {return m_auch[i];}
+	const value_type& operator[](unsigned int i) const {return m_auch[i];}
+	unsigned int size() const {return KEY_SIZE;}
+
+	value_type *begin() {return m_auch;}
+	const value_type *begin() const {return m_auch;}
+	value_type *end() {return m_auch + KEY_SIZE;}
+	const value_type *end() const {return m_auch + KEY_SIZE;}
+
+	bool operator ==(const AuchKey& key) const {return memcmp(m_auch, key.m_auch, sizeof(m_auch)) == 0;}
+	bool operator !=(const AuchKey& key) const {return !(*this == key);}
+
+private:
+	value_type m_auch[KEY_SIZE];
 };
 
 enum movetype {
@@ -74,13 +96,33 @@ struct xmovegameinfo
 	int fCubeUse;
 };
 
-class ChequerMove : public std::vector<int>
+// Up to four (source, destination) pairs, terminated by -1 when fewer
+// chequers are moved. Fixed size value type like AuchKey
+class ChequerMove
 {
 public:
+	typedef int value_type;
+	static const unsigned int MOVE_SIZE = 8;
+
 	ChequerMove() 
 	{
-		resize(8, 0);
+		memset(m_anMove, 0, sizeof(m_anMove));
 	}
+
+	value_type& operator[](unsigned int i) {return m_anMove[i];}
+	const value_type& operator[](unsigned int i) const {return m_anMove[i];}
+	unsigned int size() const {return MOVE_SIZE;}
+
+	value_type *begin() {return m_anMove;}
+	const value_type *begin() const {return m_anMove;}
+	value_type *end() {return m_anMove + MOVE_SIZE;}
+	const value_type *end() const {return m_anMove + MOVE_SIZE;}
+
+	bool operator ==(const ChequerMove& anMove) const {return memcmp(m_anMove, anMove.m_anMove, sizeof(m_anMove)) == 0;}
+	bool operator !=(const ChequerMove& anMove) const {return !(*this == anMove);}
+
+private:
+	value_type m_anMove[MOVE_SIZE];
 };
 
 struct xmovenormal 
@@ -186,6 +228,104 @@ struct movelist
 	bgmove *amMoves;
 };
 
+/* Movelists of all 21 rolls of one position, see
+ * BgBoard::GenerateMovesAllRolls. The moves of every roll lie back to back
+ * in one arena, roll after roll, so an evaluator averaging over the dice
+ * walks a single contiguous block; aml[ i ].amMoves points into it. The
+ * arena only grows, so keeping the structure around between calls avoids
+ * allocating once it has warmed up. Rolls are ordered 1-1, 1-2, ... 1-6,
+ * 2-2, ... 6-6 */
+struct allrollsmovelist
+{
+	static const int NUM_ROLLS = 21;
+
+	/* index of the roll in aml, for either order of the dice */
+	static int RollIndex(int n0, int n1)
+	{
+		if( n0 > n1 )
+			std::swap( n0, n1 );
+		return ( n0 - 1 ) * ( 14 - n0 ) / 2 + n1 - n0;
+	}
+
+	/* number of ways to throw a roll out of 36 */
+	int Weight(int iRoll) const { return aanRoll[ iRoll ][ 0 ] == aanRoll[ iRoll ][ 1 ] ? 1 : 2; }
+
+	movelist aml[ NUM_ROLLS ];
+	int aanRoll[ NUM_ROLLS ][ 2 ];
+	/* total number of moves over all rolls, aml[ 0 ].amMoves[ 0 .. cMoves - 1 ] */
+	unsigned int cMoves;
+	std::vector<bgmove> amArena;
+};
+
+/* Open addressing index over the positions of the movelist being
+ * generated, so that SaveMoves finds a duplicate resulting position in O(1)
+ * instead of scanning all moves saved so far. Positions are looked up by
+ * their 64 bit Zobrist hash (BgBoard::PositionHash), which the generator
+ * keeps up to date per sub-move, and told apart by their keys. Slots are
+ * stamped with a generation number; bumping it empties the index without
+ * touching the table. Plain data without constructors, so it may live in
+ * thread local storage; a zero filled index is a valid empty one */
+struct moveindex
+{
+	/* power of 2, at least twice MAX_INCOMPLETE_MOVES */
+	static const unsigned int INDEX_SIZE = 8192;
+
+	void reset()
+	{
+		if( ++generation == 0 )
+		{
+			memset(aSlots, 0, sizeof(aSlots));
+			generation = 1;
+		}
+	}
+
+	/* first slot to be passed to find() */
+	static unsigned int firstSlot(unsigned long long hash)
+	{
+		return (unsigned int)( hash >> 51 ) & ( INDEX_SIZE - 1 );
+	}
+
+	/* returns the index of the next move with the same hash from *piSlot
+	 * on, and moves *piSlot past it; a 64 bit hash may still collide, so
+	 * the caller confirms it against the position key and calls again on
+	 * a mismatch. Returns -1 and the free slot to be passed to insert()
+	 * when there is none */
+	int find(unsigned long long hash, unsigned int *piSlot) const
+	{
+		unsigned int iSlot = *piSlot;
+		while( aSlots[ iSlot ].generation == generation )
+		{
+			const unsigned int iFound = iSlot;
+			iSlot = ( iSlot + 1 ) & ( INDEX_SIZE - 1 );
+			if( aSlots[ iFound ].hash == hash )
+			{
+				*piSlot = iSlot;
+				return aSlots[ iFound ].iMove;
+			}
+		}
+
+		*piSlot = iSlot;
+		return -1;
+	}
+
+	void insert(unsigned int iSlot, unsigned long long hash, unsigned int iMove)
+	{
+		aSlots[ iSlot ].hash = hash;
+		aSlots[ iSlot ].generation = generation;
+		aSlots[ iSlot ].iMove = (unsigned short)iMove;
+	}
+
+	struct slot
+	{
+		unsigned long long hash;
+		unsigned short generation;
+		unsigned short iMove;
+	};
+
+	unsigned short generation;
+	slot aSlots[ INDEX_SIZE ];
+};
+
 struct moverecord 
 {
 	/* 
@@ -0,0 +1,1113 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <algorithm>
+#include "BgPerft.h"
+#include "PositionId.h"
+#include "BgBoardStats.h"
+#include "BgSearch.h"
+#include "Agent/RawRepresentation.h"
+#include "fann_cpp.h"
+
+static const char *aszGenerator[] = {"classic", "bitboard"};
+
+BgPerft::BgPerft()
+	: m_amMoves(movelist::MAX_INCOMPLETE_MOVES)
+{
+}
+
+//one position ID per line, lines starting with # are comments
+bool BgPerft::loadCorpus(const char *fileName)
+{
+	FILE *pf = fopen(fileName, "r");
+	if(!pf)
+	{
+		perror(fileName);
+		return false;
+	}
+
+	char sz[256];
+	int line = 0;
+	m_corpus.clear();
+	while(fgets(sz, sizeof(sz), pf))
+	{
+		line++;
+		char *pch = sz + strspn(sz, " \t");
+		pch[strcspn(pch, " \t\r\n")] = 0;
+		if(!*pch || *pch == '#')
+			continue;
+
+		BgBoard board;
+		if(strlen(pch) != PositionId::L_POSITIONID || 
+			!BgBoard::PositionFromID(board, pch) || !board.CheckPosition())
+		{
+			fprintf(stderr, "%s:%d: invalid position ID %s\n", fileName, line, pch);
+			fclose(pf);
+			return false;
+		}
+		m_corpus.push_back(board);
+	}
+
+	fclose(pf);
+	return true;
+}
+
+bool BgPerft::saveCorpus(const char *fileName) const
+{
+	FILE *pf = fopen(fileName, "w");
+	if(!pf)
+	{
+		perror(fileName);
+		return false;
+	}
+
+	fprintf(pf, "# MultiGammon perft corpus, %d positions\n", (int)m_corpus.size());
+	for(size_t i = 0; i < m_corpus.size(); i++)
+		fprintf(pf, "%s\n", m_corpus[i].PositionID());
+
+	fclose(pf);
+	return true;
+}
+
+//positions met by two players choosing random legal moves from the
+//standard opening position
+void BgPerft::generateCorpus(unsigned int numPositions, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	movelist ml;
+	BgBoard board;
+
+	m_corpus.clear();
+	board.InitBoard(VARIATION_STANDARD);
+	while(m_corpus.size() < numPositions)
+	{
+		m_corpus.push_back(board);
+		int n0 = rng() % 6 + 1;
+		int n1 = rng() % 6 + 1;
+		int n = board.GenerateMoves(&ml, &m_amMoves[0], n0, n1, false);
+		if(n)
+			board.ApplyMove(m_amMoves[rng() % n].anMove, false);
+		board.SwapSides();
+
+		unsigned int anChequers[2];
+		board.ChequersCount(anChequers);
+		if(!anChequers[0] || !anChequers[1])
+			board.InitBoard(VARIATION_STANDARD);
+	}
+}
+
+//random, not necessarily reachable, position with chequers on the bar and
+//borne off, biased towards bearoff situations
+void BgPerft::randomPosition(BgBoard& board, std::mt19937& rng)
+{
+	memset(board.anBoard, 0, sizeof(board.anBoard));
+	for(int side = 0; side < 2; side++)
+	{
+		int n = BgBoard::TOTAL_MEN - rng() % 8;
+		if(rng() % 4 == 0)
+			board.anBoard[side][BgBoard::BAR] = rng() % 3;
+		n -= board.anBoard[side][BgBoard::BAR];
+
+		int range = rng() % 2 ? 24 : 6;
+		while(n-- > 0)
+		{
+			int point = rng() % range;
+			if(board.anBoard[!side][23 - point])
+				continue;
+			board.anBoard[side][point]++;
+		}
+	}
+}
+
+//FNV-1a over the key and the back chequer, finished with a mixer so that
+//summing the moves gives an order independent checksum
+unsigned long long BgPerft::moveChecksum(const bgmove& m)
+{
+	unsigned long long h = 14695981039346656037ull;
+	for(unsigned int i = 0; i < AuchKey::KEY_SIZE; i++)
+		h = (h ^ m.auch[i]) * 1099511628211ull;
+	h = (h ^ (unsigned char)(m.backChequer + 1)) * 1099511628211ull;
+
+	h = (h ^ (h >> 33)) * 0xff51afd7ed558ccdull;
+	return h ^ (h >> 33);
+}
+
+unsigned long long BgPerft::run(int passes)
+{
+	//[fPartial][doubles]
+	perftstat aaStat[2][2];
+	memset(aaStat, 0, sizeof(aaStat));
+	movelist ml;
+
+	for(unsigned int pass = 0; pass < passes; pass++)
+	{
+		for(int fPartial = 0; fPartial < 2; fPartial++)
+		{
+			for(int fDouble = 0; fDouble < 2; fDouble++)
+			{
+				perftstat& stat = aaStat[fPartial][fDouble];
+				clock_t start = clock();
+				for(size_t i = 0; i < m_corpus.size(); i++)
+				{
+					for(int n0 = 1; n0 <= 6; n0++)
+					{
+						for(int n1 = fDouble ? n0 : n0 + 1; n1 <= (fDouble ? n0 : 6); n1++)
+						{
+							int n = m_corpus[i].GenerateMoves(&ml, &m_amMoves[0], n0, n1, fPartial != 0);
+							stat.moves += n;
+							if(pass == 0)
+							{
+								for(int j = 0; j < n; j++)
+									stat.checksum += moveChecksum(m_amMoves[j]) * (n0 * 8 + n1);
+							}
+						}
+					}
+				}
+				stat.time += clock() - start;
+			}
+		}
+	}
+
+	printf("Perft: %d positions, %s generator, %d pass(es)\n", (int)m_corpus.size(), 
+		aszGenerator[BgBoard::getMoveGenerator()], passes);
+	printf("%-22s %12s %18s %10s %12s\n", "", "moves", "checksum", "ms", "moves/sec");
+
+	const char *aszMode[2][2] = {{"complete, non-doubles", "complete, doubles"}, 
+		{"partial, non-doubles", "partial, doubles"}};
+	perftstat total;
+	memset(&total, 0, sizeof(total));
+	for(int fPartial = 0; fPartial < 2; fPartial++)
+	{
+		for(int fDouble = 0; fDouble < 2; fDouble++)
+		{
+			const perftstat& stat = aaStat[fPartial][fDouble];
+			double ms = stat.time * 1000.0 / CLOCKS_PER_SEC;
+			printf("%-22s %12llu %016llx %10.0f %12.0f\n", aszMode[fPartial][fDouble], stat.moves / passes, 
+				stat.checksum, ms, ms > 0 ? stat.moves * 1000.0 / ms : 0.0);
+
+			total.moves += stat.moves;
+			total.checksum = total.checksum * 31 + stat.checksum;
+			total.time += stat.time;
+		}
+	}
+
+	double ms = total.time * 1000.0 / CLOCKS_PER_SEC;
+	printf("%-22s %12llu %016llx %10.0f %12.0f\n", "total", total.moves / passes, total.checksum,
+		ms, ms > 0 ? total.moves * 1000.0 / ms : 0.0);
+
+	return total.checksum;
+}
+
+int BgPerft::runAllRolls(int passes)
+{
+	allrollsmovelist aml;
+	movelist ml;
+	int mismatches = 0;
+
+	for(int fPartial = 0; fPartial < 2; fPartial++)
+	{
+		//same moves in the same order
+		for(size_t i = 0; i < m_corpus.size(); i++)
+		{
+			m_corpus[i].GenerateMovesAllRolls(&aml, fPartial != 0);
+			for(int iRoll = 0; iRoll < allrollsmovelist::NUM_ROLLS; iRoll++)
+			{
+				const movelist& mlAll = aml.aml[iRoll];
+				m_corpus[i].GenerateMoves(&ml, &m_amMoves[0], aml.aanRoll[iRoll][0], aml.aanRoll[iRoll][1], 
+					fPartial != 0);
+
+				bool same = ml.cMoves == mlAll.cMoves;
+				for(unsigned int j = 0; same && j < ml.cMoves; j++)
+				{
+					//only the sub-moves played are defined, the rest of anMove is stale
+					same = m_amMoves[j].cMoves == mlAll.amMoves[j].cMoves &&
+						std::equal(m_amMoves[j].anMove.begin(), m_amMoves[j].anMove.begin() + 
+							std::min(m_amMoves[j].cMoves * 2 + 1, ChequerMove::MOVE_SIZE), mlAll.amMoves[j].anMove.begin()) &&
+						m_amMoves[j].auch == mlAll.amMoves[j].auch &&
+						m_amMoves[j].backChequer == mlAll.amMoves[j].backChequer;
+				}
+
+				if(!same && mismatches++ < 10)
+				{
+					printf("All rolls mismatch %s roll %d-%d partial %d: %d vs %d moves\n", 
+						m_corpus[i].PositionID(), aml.aanRoll[iRoll][0], aml.aanRoll[iRoll][1], 
+						fPartial, ml.cMoves, mlAll.cMoves);
+				}
+			}
+		}
+
+		//alternate the two in small blocks so that drift in machine load
+		//affects both alike
+		unsigned long long moves = 0;
+		clock_t timeSingle = 0, timeAll = 0;
+		for(int pass = 0; pass < passes; pass++)
+		{
+			for(size_t block = 0; block < m_corpus.size(); block += 64)
+			{
+				size_t end = std::min(block + 64, m_corpus.size());
+				clock_t start = clock();
+				for(size_t i = block; i < end; i++)
+				{
+					for(int n0 = 1; n0 <= 6; n0++)
+						for(int n1 = n0; n1 <= 6; n1++)
+							moves += m_corpus[i].GenerateMoves(&ml, &m_amMoves[0], n0, n1, fPartial != 0);
+				}
+				timeSingle += clock() - start;
+
+				start = clock();
+				for(size_t i = block; i < end; i++)
+					m_corpus[i].GenerateMovesAllRolls(&aml, fPartial != 0);
+				timeAll += clock() - start;
+			}
+		}
+
+		double msSingle = timeSingle * 1000.0 / CLOCKS_PER_SEC;
+		double msAll = timeAll * 1000.0 / CLOCKS_PER_SEC;
+		printf("%-10s moves %llu: per roll %.0f ms, all rolls %.0f ms, %.2fx\n", 
+			fPartial ? "partial" : "complete", moves / passes, msSingle, msAll, msAll > 0 ? msSingle / msAll : 0.0);
+	}
+
+	printf("All rolls generation: %d mismatches\n", mismatches);
+	return mismatches;
+}
+
+int BgPerft::crossCheck(unsigned int numPositions, unsigned int seed)
+{
+	std::vector<bgmove> amClassic(movelist::MAX_INCOMPLETE_MOVES);
+	movelist mlClassic, mlOther;
+	movegenerator mg = BgBoard::getMoveGenerator();
+	std::mt19937 rng(seed);
+	unsigned long long totalMoves = 0;
+	int mismatches = 0;
+
+	for(unsigned int pos = 0; pos < numPositions; pos++)
+	{
+		BgBoard board;
+		randomPosition(board, rng);
+
+		for(int n0 = 1; n0 <= 6; n0++)
+		{
+			for(int n1 = n0; n1 <= 6; n1++)
+			{
+				for(int fPartial = 0; fPartial < 2; fPartial++)
+				{
+					BgBoard::setMoveGenerator(MOVEGEN_CLASSIC);
+					board.GenerateMoves(&mlClassic, &amClassic[0], n0, n1, fPartial != 0);
+					BgBoard::setMoveGenerator(MOVEGEN_BITBOARD);
+					board.GenerateMoves(&mlOther, &m_amMoves[0], n0, n1, fPartial != 0);
+					totalMoves += mlClassic.cMoves;
+
+					bool same = mlClassic.cMoves == mlOther.cMoves;
+					for(unsigned int i = 0; same && i < mlClassic.cMoves; i++)
+					{
+						same = amClassic[i].anMove == m_amMoves[i].anMove &&
+							amClassic[i].auch == m_amMoves[i].auch &&
+							amClassic[i].backChequer == m_amMoves[i].backChequer;
+					}
+
+					if(!same && mismatches++ < 10)
+					{
+						printf("Mismatch %s roll %d-%d partial %d: %d vs %d moves\n", 
+							board.PositionID(), n0, n1, fPartial, mlClassic.cMoves, mlOther.cMoves);
+					}
+				}
+			}
+		}
+	}
+
+	BgBoard::setMoveGenerator(mg);
+	printf("Move generator cross check: %d positions, %llu moves, %d mismatches\n", 
+		numPositions, totalMoves, mismatches);
+	return mismatches;
+}
+
+//the bit by bit codec BgBoard used before the table driven one
+AuchKey BgPerft::referenceKey(const char anBoard[2][25])
+{
+	AuchKey auchKey;
+	unsigned int iBit = 0;
+
+	for(int i = 0; i < 2; i++) 
+	{
+		for(int j = 0; j < 25; j++)
+		{
+			for(int nc = anBoard[i][j]; nc > 0; nc--, iBit++)
+				auchKey[iBit >> 3] |= 1 << (iBit & 7);
+			iBit++;
+		}
+	}
+
+	return auchKey;
+}
+
+void BgPerft::referenceFromKey(const AuchKey& auch, char anBoard[2][25])
+{
+	int i = 0, j = 0;
+
+	memset(anBoard, 0, 50);
+	for(unsigned int a = 0; a < AuchKey::KEY_SIZE; a++) 
+	{
+		unsigned char cur = auch[a];
+		for(int k = 0; k < 8; ++k, cur >>= 1)
+		{
+			if(cur & 0x1)
+			{
+				if(i >= 2 || j >= 25)
+					return;
+				++anBoard[i][j];
+			}
+			else if(++j == 25)
+			{
+				++i;
+				j = 0;
+			}
+		}
+	}
+}
+
+bool BgPerft::codecRoundTrip(const BgBoard& board)
+{
+	AuchKey auch = board.PositionKey();
+	if(auch != referenceKey(board.anBoard))
+		return false;
+
+	BgBoard decoded = BgBoard::PositionFromKey(auch);
+	return !memcmp(decoded.anBoard, board.anBoard, sizeof(board.anBoard));
+}
+
+int BgPerft::codecCheck(unsigned int numPositions, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::vector<BgBoard> positions(numPositions);
+	unsigned long long checked = 0;
+	int mismatches = 0;
+
+	//every position with up to 3 chequers per side (hypergammon 3)
+	std::vector<std::vector<char> > aSides;
+	for(int a = 0; a <= 25; a++)
+	{
+		for(int b = a; b <= 25; b++)
+		{
+			for(int c = b; c <= 25; c++)
+			{
+				//25 stands for "borne off"
+				std::vector<char> an(25, 0);
+				if(a < 25) an[a]++;
+				if(b < 25) an[b]++;
+				if(c < 25) an[c]++;
+				aSides.push_back(an);
+			}
+		}
+	}
+
+	for(size_t i = 0; i < aSides.size(); i++)
+	{
+		for(size_t j = 0; j < aSides.size(); j++)
+		{
+			BgBoard board;
+			memcpy(board.anBoard[0], &aSides[i][0], 25);
+			memcpy(board.anBoard[1], &aSides[j][0], 25);
+			if(!board.CheckPosition())
+				continue;
+
+			checked++;
+			if(!codecRoundTrip(board) && mismatches++ < 10)
+				printf("Codec mismatch %s\n", board.PositionID());
+		}
+	}
+
+	//every one sided bearoff position of up to 15 chequers for either side
+	for(unsigned int id = 0; id < PositionId::Combination(21, 6); id++)
+	{
+		for(int side = 0; side < 2; side++)
+		{
+			BgBoard board;
+			randomPosition(board, rng);
+			memset(board.anBoard[side], 0, 25);
+			PositionId::PositionFromBearoff(board.anBoard[side], id, 6, 15);
+			for(int i = 0; i < 6; i++)
+				board.anBoard[!side][23 - i] = 0;
+
+			checked++;
+			if(!codecRoundTrip(board) && mismatches++ < 10)
+				printf("Codec mismatch %s\n", board.PositionID());
+		}
+	}
+
+	for(unsigned int i = 0; i < numPositions; i++)
+	{
+		randomPosition(positions[i], rng);
+		checked++;
+		if(!codecRoundTrip(positions[i]) && mismatches++ < 10)
+			printf("Codec mismatch %s\n", positions[i].PositionID());
+	}
+
+	printf("Position key codec check: %llu positions, %d mismatches\n", checked, mismatches);
+
+	//throughput over a cache resident subset of the random positions, so
+	//the timing measures the codec rather than memory
+	const unsigned int numBench = numPositions < 4096 ? numPositions : 4096;
+	const unsigned int passes = numBench ? 20 * numPositions / numBench : 0;
+	numPositions = numBench;
+	std::vector<AuchKey> aKeys(numPositions);
+	unsigned int sink = 0;
+	clock_t aTime[4];
+
+	clock_t start = clock();
+	for(unsigned int pass = 0; pass < passes; pass++)
+		for(unsigned int i = 0; i < numPositions; i++)
+			aKeys[i] = referenceKey(positions[i].anBoard);
+	aTime[0] = clock() - start;
+
+	start = clock();
+	for(unsigned int pass = 0; pass < passes; pass++)
+		for(unsigned int i = 0; i < numPositions; i++)
+			aKeys[i] = positions[i].PositionKey();
+	aTime[1] = clock() - start;
+
+	start = clock();
+	for(unsigned int pass = 0; pass < passes; pass++)
+	{
+		for(unsigned int i = 0; i < numPositions; i++)
+		{
+			char anBoard[2][25];
+			referenceFromKey(aKeys[i], anBoard);
+			sink += anBoard[1][i % 25];
+		}
+	}
+	aTime[2] = clock() - start;
+
+	start = clock();
+	for(unsigned int pass = 0; pass < passes; pass++)
+	{
+		for(unsigned int i = 0; i < numPositions; i++)
+		{
+			BgBoard board = BgBoard::PositionFromKey(aKeys[i]);
+			sink += board.anBoard[1][i % 25];
+		}
+	}
+	aTime[3] = clock() - start;
+
+	double ops = (double)passes * numPositions;
+	const char *aszOp[2] = {"encode", "decode"};
+	for(int op = 0; op < 2; op++)
+	{
+		double nsRef = aTime[op * 2] * 1e9 / CLOCKS_PER_SEC / ops;
+		double nsNew = aTime[op * 2 + 1] * 1e9 / CLOCKS_PER_SEC / ops;
+		printf("%s: bit by bit %.1f ns, table %.1f ns, %.1fx\n", aszOp[op], nsRef, nsNew, 
+			nsNew > 0 ? nsRef / nsNew : 0.0);
+	}
+
+	return mismatches + (sink == 0xffffffff);
+}
+
+//the scalar loops of BackChequer, ChequersCount and PipCount before BgBoardStats
+void BgPerft::referenceStats(const BgBoard& board, int anBack[2], unsigned int anChequers[2], 
+	unsigned int anPips[2])
+{
+	for(int side = 0; side < 2; side++)
+	{
+		anBack[side] = -1;
+		for(int b = 24; b > -1; b--) 
+		{
+			if(board.anBoard[side][b] > 0) 
+			{
+				anBack[side] = b;
+				break;
+			}
+		}
+
+		anChequers[side] = anPips[side] = 0;
+		for(int i = 0; i < 25; i++) 
+		{
+			anChequers[side] += board.anBoard[side][i];
+			anPips[side] += board.anBoard[side][i] * (i + 1);
+		}
+	}
+}
+
+//the scalar over, contact and crashed tests of BgEval::ClassifyPosition
+//before BgBoardStats; any non contact position counts as a race
+positionclass BgPerft::referenceClass(const BgBoard& board)
+{
+	int nOppBack, nBack;
+
+	for(nOppBack = 24; nOppBack >= 0; --nOppBack) 
+		if(board.anBoard[0][nOppBack]) 
+			break;
+
+	for(nBack = 24; nBack >= 0; --nBack) 
+		if(board.anBoard[1][nBack]) 
+			break;
+
+	if(nBack < 0 || nOppBack < 0)
+		return CLASS_OVER;
+
+	if(nBack + nOppBack <= 22) 
+		return CLASS_RACE;
+
+	unsigned int const N = 6;
+	for(int side = 0; side < 2; ++side) 
+	{
+		unsigned int tot = 0;
+		const char* anRow = board.anBoard[side];
+
+		for(int i = 0; i < 25; ++i) 
+			tot += anRow[i];
+
+		if(tot <= N) 
+			return CLASS_CRASHED;
+		else if(anRow[0] > 1) 
+		{
+			if(tot <= (N + anRow[0])) 
+				return CLASS_CRASHED;
+			else if(anRow[1] > 1 && (1 + tot - (anRow[0] + anRow[1])) <= N) 
+				return CLASS_CRASHED;
+		} 
+		else if(tot <= (N + (anRow[1] - 1))) 
+			return CLASS_CRASHED;
+	}
+
+	return CLASS_CONTACT;
+}
+
+int BgPerft::analyticsCheck(unsigned int numPositions, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::vector<BgBoard> positions(numPositions);
+	int mismatches = 0;
+
+	for(unsigned int i = 0; i < numPositions; i++)
+	{
+		BgBoard& board = positions[i];
+		randomPosition(board, rng);
+		//empty a side now and then for game over positions
+		if(rng() % 64 == 0)
+			memset(board.anBoard[rng() % 2], 0, 25);
+
+		int anBack[2];
+		unsigned int anChequers[2], anPips[2], anPipsNew[2], anChequersNew[2];
+		referenceStats(board, anBack, anChequers, anPips);
+		board.PipCount(anPipsNew);
+		board.ChequersCount(anChequersNew);
+
+		positionclass pc = BgEval::Instance()->ClassifyPosition(&board, VARIATION_STANDARD);
+		if(pc >= CLASS_HYPERGAMMON1 && pc <= CLASS_RACE)
+			pc = CLASS_RACE;
+
+		bool same = anBack[BgBoard::SELF] == board.BackChequer() &&
+			anPips[0] == anPipsNew[0] && anPips[1] == anPipsNew[1] &&
+			anChequers[0] == anChequersNew[0] && anChequers[1] == anChequersNew[1] &&
+			pc == referenceClass(board) && 
+			(board.GameStatus(VARIATION_STANDARD) != 0) == (pc == CLASS_OVER);
+
+		if(!same && mismatches++ < 10)
+			printf("Board analytics mismatch %s\n", board.PositionID());
+	}
+
+	printf("Board analytics check: %d positions, %d mismatches\n", numPositions, mismatches);
+
+	//per candidate queries: the back chequer saved with the move, the
+	//class it is evaluated with and the pip counts, over a cache resident
+	//subset so the timing measures the code rather than memory
+	const unsigned int numBench = numPositions < 4096 ? numPositions : 4096;
+	const unsigned int passes = numBench ? 20 * numPositions / numBench : 0;
+	unsigned int sink = 0;
+
+	clock_t start = clock();
+	for(unsigned int pass = 0; pass < passes; pass++)
+	{
+		for(unsigned int i = 0; i < numBench; i++)
+		{
+			int anBack[2];
+			unsigned int anChequers[2], anPips[2];
+			referenceStats(positions[i], anBack, anChequers, anPips);
+			sink += anBack[BgBoard::SELF] + referenceClass(positions[i]) + anPips[0] + anPips[1];
+		}
+	}
+	clock_t timeRef = clock() - start;
+
+	start = clock();
+	for(unsigned int pass = 0; pass < passes; pass++)
+	{
+		for(unsigned int i = 0; i < numBench; i++)
+		{
+			BgBoardStats stats(positions[i]);
+			positionclass pc = stats.IsOver() ? CLASS_OVER : 
+				!stats.IsContact() ? CLASS_RACE : stats.IsCrashed() ? CLASS_CRASHED : CLASS_CONTACT;
+			sink += stats.BackChequer(BgBoard::SELF) + pc + stats.Pips(0) + stats.Pips(1);
+		}
+	}
+	clock_t timeNew = clock() - start;
+
+	double ops = (double)passes * numBench;
+	double nsRef = timeRef * 1e9 / CLOCKS_PER_SEC / ops;
+	double nsNew = timeNew * 1e9 / CLOCKS_PER_SEC / ops;
+	printf("per candidate: scalar %.1f ns, SSE2 %.1f ns, %.1fx\n", nsRef, nsNew, nsNew > 0 ? nsRef / nsNew : 0.0);
+
+	return mismatches + (sink == 0xffffffff);
+}
+
+int BgPerft::searchScaling(BgAgent *agent, unsigned int nPlies, int maxThreads, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	std::vector<int> anDice(2 * m_corpus.size());
+	for(size_t i = 0; i < anDice.size(); i++)
+		anDice[i] = rng() % 6 + 1;
+
+	evalcontext ec;
+	ec.nPlies = nPlies;
+	movelist ml;
+	std::vector<unsigned long long> aRef;
+	double secondsBase = 0;
+	int mismatches = 0;
+
+	if(maxThreads <= 0)
+		maxThreads = BgSearch().getThreads();
+
+	printf("Search scaling: %d positions, %s, %d-ply%s\n", (int)m_corpus.size(), agent->getFullName().c_str(), 
+		nPlies, agent->isReentrant() ? "" : ", agent is not reentrant and searches on one thread");
+	printf("%8s %10s %12s %12s %8s %10s\n", "threads", "ms", "nodes", "nodes/sec", "speedup", "mismatches");
+
+	for(int nThreads = 1; nThreads <= maxThreads; nThreads++)
+	{
+		BgSearch search;
+		search.setThreads(nThreads);
+		//every run starts cold, cached evaluations would flatter the later ones
+		agent->clearEvalCache();
+		int runMismatches = 0;
+
+		for(size_t i = 0, k = 0; i < m_corpus.size(); i++)
+		{
+			const BgBoard& board = m_corpus[i];
+			board.GenerateMoves(&ml, &m_amMoves[0], anDice[2 * i], anDice[2 * i + 1], false);
+			if(!ml.cMoves)
+				continue;
+
+			agent->setCurrentBoard(&board);
+			search.FindBestMoves(agent, &ml, ec);
+
+			unsigned long long h = 0;
+			for(unsigned int j = 0; j < ml.cMoves; j++)
+			{
+				unsigned int nScore;
+				memcpy(&nScore, &ml.amMoves[j].rScore, sizeof(nScore));
+				h = h * 31 + (moveChecksum(ml.amMoves[j]) ^ nScore);
+			}
+
+			if(nThreads == 1)
+				aRef.push_back(h);
+			else if(aRef[k] != h)
+				runMismatches++;
+			k++;
+		}
+
+		double seconds = search.getSeconds();
+		if(nThreads == 1)
+			secondsBase = seconds;
+		printf("%8d %10.0f %12llu %12.0f %7.2fx %10d\n", nThreads, seconds * 1000, search.getNodes(), 
+			seconds > 0 ? search.getNodes() / seconds : 0.0, seconds > 0 ? secondsBase / seconds : 0.0, runMismatches);
+		mismatches += runMismatches;
+	}
+
+	return mismatches;
+}
+
+int BgPerft::incrementalCheck(BgAgent *agent, int passes, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	movelist ml;
+	std::vector<BgBoard> aBoards;
+	std::vector<size_t> aiFirst;
+
+	for(size_t i = 0; i < m_corpus.size(); i++)
+	{
+		int n0 = rng() % 6 + 1, n1 = rng() % 6 + 1;
+		m_corpus[i].GenerateMoves(&ml, &m_amMoves[0], n0, n1, false);
+		const size_t iFirst = aBoards.size();
+		for(unsigned int j = 0; j < ml.cMoves; j++)
+		{
+			BgBoard board = BgBoard::PositionFromKey(ml.amMoves[j].auch);
+			if(BgEval::Instance()->ClassifyPosition(BgBoardView(board, true), VARIATION_STANDARD) == CLASS_CONTACT)
+				aBoards.push_back(board);
+		}
+		//a single candidate has no siblings
+		if(aBoards.size() - iFirst > 1)
+			aiFirst.push_back(iFirst);
+		else
+			aBoards.resize(iFirst);
+	}
+	aiFirst.push_back(aBoards.size());
+
+	std::vector<BgBoardView> aViews;
+	for(size_t i = 0; i < aBoards.size(); i++)
+		aViews.push_back(BgBoardView(aBoards[i], true));
+	std::vector<positionclass> apc(aBoards.size());
+	std::vector<BgReward> aarReward[2] = {std::vector<BgReward>(aBoards.size()), std::vector<BgReward>(aBoards.size())};
+	clock_t aTime[2] = {0, 0};
+
+	const bool fIncremental = agent->isIncrementalEval();
+	for(int pass = 0; pass < passes; pass++)
+		for(int mode = 0; mode < 2; mode++)
+		{
+			agent->setIncrementalEval(mode != 0);
+			//cached evaluations would flatter the second mode
+			agent->clearEvalCache();
+			clock_t start = clock();
+			for(size_t k = 0; k + 1 < aiFirst.size(); k++)
+			{
+				const size_t iFirst = aiFirst[k], c = aiFirst[k + 1] - iFirst;
+				std::fill(apc.begin() + iFirst, apc.begin() + iFirst + c, CLASS_CONTACT);
+				agent->evaluatePositions(&aViews[iFirst], &apc[iFirst], &aarReward[mode][iFirst], (int)c);
+			}
+			aTime[mode] += clock() - start;
+		}
+	agent->setIncrementalEval(fIncremental);
+
+	int mismatches = 0;
+	float rMaxDiff = 0;
+	for(size_t k = 0; k + 1 < aiFirst.size(); k++)
+	{
+		size_t aiBest[2] = {aiFirst[k], aiFirst[k]};
+		for(size_t i = aiFirst[k]; i < aiFirst[k + 1]; i++)
+			for(int mode = 0; mode < 2; mode++)
+			{
+				if(aarReward[mode][i].utility() > aarReward[mode][aiBest[mode]].utility())
+					aiBest[mode] = i;
+				for(int j = 0; j < NUM_OUTPUTS; j++)
+					rMaxDiff = std::max(rMaxDiff, fabsf(aarReward[0][i][j] - aarReward[1][i][j]));
+			}
+		if(aiBest[0] != aiBest[1])
+			mismatches++;
+	}
+
+	const size_t cBatches = aiFirst.size() - 1;
+	const double rFull = (double)aTime[0] / CLOCKS_PER_SEC, rIncremental = (double)aTime[1] / CLOCKS_PER_SEC;
+	printf("Incremental evaluation: %s, %d contact batches, %d positions, %d pass(es)\n", agent->getFullName().c_str(),
+		(int)cBatches, (int)aBoards.size(), passes);
+	printf("full %.0f ms, %.0f positions/s; incremental %.0f ms, %.0f positions/s; %.2fx\n",
+		rFull * 1000, rFull > 0 ? aBoards.size() * passes / rFull : 0.0, 
+		rIncremental * 1000, rIncremental > 0 ? aBoards.size() * passes / rIncremental : 0.0,
+		rIncremental > 0 ? rFull / rIncremental : 0.0);
+	printf("largest output difference %g, best candidate differs in %d batches\n", rMaxDiff, mismatches);
+	return mismatches;
+}
+
+int BgPerft::fannKernelCheck(const char *fileName, int passes, unsigned int seed)
+{
+	FANN::neural_net ann;
+	if(!ann.create_from_file(fileName))
+	{
+		fprintf(stderr, "Can't load %s\n", fileName);
+		return -1;
+	}
+	ann.select_isa();
+
+	const RawRepresentation representation(encTes92);
+	const unsigned int cInputs = (unsigned int)representation.getContactInputs();
+	const unsigned int numInput = ann.get_num_input(), numOutput = ann.get_num_output();
+	if(numInput + 1 > cInputs)
+	{
+		fprintf(stderr, "%s takes %u inputs, the raw representation has %u\n", fileName, numInput, cInputs - 1);
+		return -1;
+	}
+
+	std::mt19937 rng(seed);
+	movelist ml;
+	std::vector<float> arInput;
+	std::vector<size_t> aiFirst;
+	//the same inputs by their non-zero values, the ones the network reads
+	std::vector<unsigned int> aiIndex;
+	std::vector<float> arValue;
+	std::vector<size_t> aiSparse(1, 0);
+	int sparseMismatches = 0;
+	for(size_t i = 0; i < m_corpus.size(); i++)
+	{
+		int n0 = rng() % 6 + 1, n1 = rng() % 6 + 1;
+		m_corpus[i].GenerateMoves(&ml, &m_amMoves[0], n0, n1, false);
+		if(!ml.cMoves)
+			continue;
+		aiFirst.push_back(arInput.size() / cInputs);
+		for(unsigned int j = 0; j < ml.cMoves; j++)
+		{
+			BgBoard board = BgBoard::PositionFromKey(ml.amMoves[j].auch);
+			arInput.resize(arInput.size() + cInputs, 0);
+			representation.calculateContactInputs(BgBoardView(board, true), &arInput[arInput.size() - cInputs]);
+
+			aiIndex.resize(aiSparse.back() + cInputs);
+			arValue.resize(aiSparse.back() + cInputs);
+			int n = representation.calculateContactSparse(BgBoardView(board, true), &aiIndex[aiSparse.back()], 
+				&arValue[aiSparse.back()]);
+			std::vector<float> arDense(cInputs, 0);
+			for(int k = 0; k < n; k++)
+				arDense[aiIndex[aiSparse.back() + k]] = arValue[aiSparse.back() + k];
+			if(memcmp(&arDense[0], &arInput[arInput.size() - cInputs], cInputs * sizeof(float)))
+				sparseMismatches++;
+			while(n && aiIndex[aiSparse.back() + n - 1] >= numInput)
+				n--;
+			aiSparse.push_back(aiSparse.back() + n);
+		}
+	}
+	const size_t cPositions = arInput.size() / cInputs;
+	aiFirst.push_back(cPositions);
+
+	struct fann_context *ctx = ann.create_context();
+	struct fann_sparse *sparse = ann.create_sparse();
+	if(!ctx || !sparse)
+	{
+		fann_destroy_context(ctx);
+		fann_destroy_sparse(sparse);
+		fprintf(stderr, "Can't allocate FANN buffers\n");
+		return -1;
+	}
+
+	/* the kernels add up in other orders and the fused ones round less often,
+	   so they agree with the generic one to a tolerance; a batch has to give
+	   the outputs of single runs of its own kernel bit for bit */
+	const float rTolerance = 1e-4f;
+	//a few training steps towards targets off the outputs, then all the
+	//positions run through the trained network with the generic kernel
+	const size_t cTrain = std::min(cPositions, (size_t)256);
+	std::vector<float> arReference(cPositions * numOutput), arSingle(cPositions * numOutput);
+	std::vector<float> arBatch(cPositions * numOutput), arTrainReference, arTrained(cPositions * numOutput);
+	std::vector<float> arSparse(cPositions * numOutput);
+
+	printf("FANN kernels: %s, %d batches, %d positions, %d pass(es), CPU %s\n", fileName, 
+		(int)aiFirst.size() - 1, (int)cPositions, passes, FANN_ISA_NAMES[fann_cpu_isa()]);
+	printf("%.1f non-zero inputs per position of %u, %d differ from the dense inputs\n", 
+		cPositions ? (double)aiSparse.back() / cPositions : 0.0, numInput, sparseMismatches);
+	printf("%-8s %10s %12s %10s %12s %8s %10s %12s %10s %10s %10s %10s\n", "kernel", "single ms", "positions/s", 
+		"batch ms", "positions/s", "speedup", "sparse ms", "positions/s", "max diff", "sparse diff", "train diff", 
+		"mismatches");
+
+	int mismatches = sparseMismatches;
+	for(int isa = FANN_ISA_GENERIC; isa <= FANN_ISA_AVX512; isa++)
+	{
+		if(ann.set_isa((fann_isa_enum)isa) != isa)
+			continue;
+
+		clock_t aTime[3] = {0, 0, 0};
+		for(int pass = 0; pass < passes; pass++)
+		{
+			/* one run per candidate, the way GetReward evaluates */
+			clock_t start = clock();
+			for(size_t i = 0; i < cPositions; i++)
+				memcpy(&arSingle[i * numOutput], ann.run_dispatch(&arInput[i * cInputs], ctx), 
+					numOutput * sizeof(float));
+			aTime[0] += clock() - start;
+
+			/* the candidates of a position as one batch */
+			start = clock();
+			for(size_t k = 0; k + 1 < aiFirst.size(); k++)
+				ann.run_batch(&arInput[aiFirst[k] * cInputs], (unsigned int)(aiFirst[k + 1] - aiFirst[k]), cInputs, 
+					&arBatch[aiFirst[k] * numOutput], ctx);
+			aTime[1] += clock() - start;
+
+			/* one run per candidate from its non-zero inputs */
+			start = clock();
+			for(size_t i = 0; i < cPositions; i++)
+				memcpy(&arSparse[i * numOutput], ann.run_sparse(&aiIndex[aiSparse[i]], &arValue[aiSparse[i]], 
+					(unsigned int)(aiSparse[i + 1] - aiSparse[i]), sparse, ctx), numOutput * sizeof(float));
+			aTime[2] += clock() - start;
+		}
+		if(isa == FANN_ISA_GENERIC)
+			arReference = arSingle;
+
+		FANN::neural_net trained;
+		trained.create_from_file(fileName);
+		trained.select_isa();
+		trained.set_isa((fann_isa_enum)isa);
+		std::vector<float> arTarget(numOutput);
+		for(size_t i = 0; i < cTrain; i++)
+		{
+			for(unsigned int j = 0; j < numOutput; j++)
+				arTarget[j] = arReference[i * numOutput + j] + 0.05f;
+			trained.train_dispatch(&arInput[i * cInputs], &arTarget[0]);
+		}
+		trained.set_isa(FANN_ISA_GENERIC);
+		struct fann_context *trainedCtx = trained.create_context();
+		for(size_t i = 0; i < cPositions; i++)
+			memcpy(&arTrained[i * numOutput], trained.run_dispatch(&arInput[i * cInputs], trainedCtx), 
+				numOutput * sizeof(float));
+		fann_destroy_context(trainedCtx);
+		if(isa == FANN_ISA_GENERIC)
+			arTrainReference = arTrained;
+
+		int runMismatches = 0;
+		float rMaxDiff = 0, rSparseDiff = 0, rTrainDiff = 0;
+		for(size_t i = 0; i < cPositions; i++)
+		{
+			bool fMismatch = memcmp(&arSingle[i * numOutput], &arBatch[i * numOutput], numOutput * sizeof(float)) != 0;
+			for(unsigned int j = 0; j < numOutput; j++)
+			{
+				const float rDiff = fabsf(arSingle[i * numOutput + j] - arReference[i * numOutput + j]);
+				const float rSparse = fabsf(arSparse[i * numOutput + j] - arReference[i * numOutput + j]);
+				const float rTrain = fabsf(arTrained[i * numOutput + j] - arTrainReference[i * numOutput + j]);
+				rMaxDiff = std::max(rMaxDiff, rDiff);
+				rSparseDiff = std::max(rSparseDiff, rSparse);
+				rTrainDiff = std::max(rTrainDiff, rTrain);
+				if(rDiff > rTolerance || rSparse > rTolerance || rTrain > rTolerance)
+					fMismatch = true;
+			}
+			if(fMismatch)
+				runMismatches++;
+		}
+
+		const double rSingle = (double)aTime[0] / CLOCKS_PER_SEC, rBatch = (double)aTime[1] / CLOCKS_PER_SEC;
+		const double rSparseTime = (double)aTime[2] / CLOCKS_PER_SEC;
+		printf("%-8s %10.0f %12.0f %10.0f %12.0f %7.2fx %10.0f %12.0f %10.2g %12.2g %10.2g %10d\n", FANN_ISA_NAMES[isa], 
+			rSingle * 1000, rSingle > 0 ? cPositions * passes / rSingle : 0.0, 
+			rBatch * 1000, rBatch > 0 ? cPositions * passes / rBatch : 0.0,
+			rBatch > 0 ? rSingle / rBatch : 0.0, 
+			rSparseTime * 1000, rSparseTime > 0 ? cPositions * passes / rSparseTime : 0.0,
+			rMaxDiff, rSparseDiff, rTrainDiff, runMismatches);
+		mismatches += runMismatches;
+	}
+	fann_destroy_context(ctx);
+	fann_destroy_sparse(sparse);
+
+	return mismatches;
+}
+
+int BgPerft::quantCheck(BgAgent *agent, int passes, unsigned int seed)
+{
+	std::mt19937 rng(seed);
+	movelist ml;
+	std::vector<BgBoard> aBoards;
+	std::vector<size_t> aiFirst;
+
+	for(size_t i = 0; i < m_corpus.size(); i++)
+	{
+		int n0 = rng() % 6 + 1, n1 = rng() % 6 + 1;
+		m_corpus[i].GenerateMoves(&ml, &m_amMoves[0], n0, n1, false);
+		const size_t iFirst = aBoards.size();
+		for(unsigned int j = 0; j < ml.cMoves; j++)
+		{
+			BgBoard board = BgBoard::PositionFromKey(ml.amMoves[j].auch);
+			if(BgAgent::isNetClass(BgEval::Instance()->ClassifyPosition(BgBoardView(board, true), VARIATION_STANDARD)))
+				aBoards.push_back(board);
+		}
+		//the best of a single candidate can't change
+		if(aBoards.size() - iFirst > 1)
+			aiFirst.push_back(iFirst);
+		else
+			aBoards.resize(iFirst);
+	}
+	aiFirst.push_back(aBoards.size());
+
+	std::vector<BgBoardView> aViews;
+	std::vector<positionclass> apcNet;
+	for(size_t i = 0; i < aBoards.size(); i++)
+	{
+		aViews.push_back(BgBoardView(aBoards[i], true));
+		apcNet.push_back(BgEval::Instance()->ClassifyPosition(aViews.back(), VARIATION_STANDARD));
+	}
+
+	/* the floats the way the agent evaluates and in full, as the integer
+	   copies do, then every width with the generic kernel and the fastest
+	   one */
+	struct quantrun
+	{
+		unsigned int nBits;
+		fann_isa_enum isa;
+		bool fFull;
+	};
+	const fann_isa_enum isaLimit = fann_get_isa_limit();
+	const fann_isa_enum isaFast = fann_quant_isa();
+	const bool fIncremental = agent->isIncrementalEval(), fSparse = agent->isSparseEval();
+	std::vector<quantrun> aRuns;
+	const quantrun aFloatRuns[] = {{0, isaLimit, false}, {0, isaLimit, true}};
+	aRuns.assign(aFloatRuns, aFloatRuns + 2);
+	const unsigned int anBits[] = {16, 8};
+	for(int b = 0; b < 2; b++)
+	{
+		quantrun run = {anBits[b], FANN_ISA_GENERIC, true};
+		aRuns.push_back(run);
+		if(isaFast != FANN_ISA_GENERIC)
+		{
+			run.isa = isaFast;
+			aRuns.push_back(run);
+		}
+	}
+
+	printf("Quantized evaluation: %s, %d batches, %d positions, %d pass(es)\n", agent->getFullName().c_str(),
+		(int)aiFirst.size() - 1, (int)aBoards.size(), passes);
+	printf("%-8s %-8s %10s %12s %8s %10s %10s %12s %10s\n", "weights", "kernel", "ms", "positions/s", "speedup", 
+		"mean err", "max err", "best differs", "mismatches");
+
+	std::vector<std::vector<BgReward> > aarReward(aRuns.size(), std::vector<BgReward>(aBoards.size()));
+	std::vector<positionclass> apc(aBoards.size());
+	double rFloat = 0;
+	int mismatches = 0;
+	for(size_t r = 0; r < aRuns.size(); r++)
+	{
+		agent->setIncrementalEval(fIncremental && !aRuns[r].fFull);
+		agent->setSparseEval(fSparse && !aRuns[r].fFull);
+		fann_set_isa_limit(aRuns[r].isa);
+		if(!agent->setQuantized(aRuns[r].nBits))
+		{
+			fann_set_isa_limit(isaLimit);
+			agent->setIncrementalEval(fIncremental);
+			agent->setSparseEval(fSparse);
+			fprintf(stderr, "%s has no %u bit integer evaluation\n", agent->getFullName().c_str(), aRuns[r].nBits);
+			return -1;
+		}
+
+		clock_t time = 0;
+		for(int pass = 0; pass < passes; pass++)
+		{
+			//cached evaluations would flatter the later passes
+			agent->clearEvalCache();
+			apc = apcNet;
+			clock_t start = clock();
+			for(size_t k = 0; k + 1 < aiFirst.size(); k++)
+				agent->evaluatePositions(&aViews[aiFirst[k]], &apc[aiFirst[k]], &aarReward[r][aiFirst[k]], 
+					(int)(aiFirst[k + 1] - aiFirst[k]));
+			time += clock() - start;
+		}
+
+		/* against the floats as the agent evaluates; the integer sums are
+		   exact, so a width gives the same rewards with every kernel */
+		double rSumErr = 0;
+		float rMaxErr = 0;
+		int bestDiffers = 0, runMismatches = 0;
+		for(size_t k = 0; k + 1 < aiFirst.size(); k++)
+		{
+			size_t aiBest[2] = {aiFirst[k], aiFirst[k]};
+			for(size_t i = aiFirst[k]; i < aiFirst[k + 1]; i++)
+			{
+				const float rErr = fabsf(aarReward[r][i].utility() - aarReward[0][i].utility());
+				rSumErr += rErr;
+				rMaxErr = std::max(rMaxErr, rErr);
+				if(aarReward[0][i].utility() > aarReward[0][aiBest[0]].utility())
+					aiBest[0] = i;
+				if(aarReward[r][i].utility() > aarReward[r][aiBest[1]].utility())
+					aiBest[1] = i;
+				if(aRuns[r].nBits && aRuns[r].nBits == aRuns[r - 1].nBits && 
+					memcmp(&aarReward[r][i], &aarReward[r - 1][i], sizeof(BgReward)))
+					runMismatches++;
+			}
+			if(aiBest[0] != aiBest[1])
+				bestDiffers++;
+		}
+
+		const double rTime = (double)time / CLOCKS_PER_SEC;
+		if(!r)
+			rFloat = rTime;
+		char szWeights[16];
+		sprintf(szWeights, aRuns[r].nBits ? "int%u" : "fp32", aRuns[r].nBits);
+		printf("%-8s %-8s %10.0f %12.0f %7.2fx %10.2g %10.2g %12d %10d\n", szWeights, 
+			aRuns[r].nBits ? FANN_ISA_NAMES[aRuns[r].isa] : aRuns[r].fFull ? "full" : "default", rTime * 1000, 
+			rTime > 0 ? aBoards.size() * passes / rTime : 0.0, rTime > 0 ? rFloat / rTime : 0.0,
+			aBoards.empty() ? 0.0 : rSumErr / aBoards.size(), rMaxErr, bestDiffers, runMismatches);
+		mismatches += runMismatches;
+	}
+	fann_set_isa_limit(isaLimit);
+	agent->setIncrementalEval(fIncremental);
+	agent->setSparseEval(fSparse);
+	agent->setQuantized(0);
+	agent->clearEvalCache();
+
+	return mismatches;
+}
@@ -0,0 +1,99 @@
+#ifndef __BGPERFT_H
+#define __BGPERFT_H
+
+#pragma once
+
+#include <time.h>
+#include <vector>
+#include <random>
+#include "BgBoard.h"
+
+class BgAgent;
+
+// Move generator benchmark and regression check in the spirit of chess
+// "perft". Every position of a corpus is expanded for all 21 rolls in both
+// fPartial modes; move counts and a checksum over the resulting positions
+// identify the generator output, timings catch slowdowns.
+// The checksum does not depend on the order of the moves in a movelist.
+class BgPerft
+{
+public:
+	BgPerft();
+
+	bool loadCorpus(const char *fileName);
+	bool saveCorpus(const char *fileName) const;
+	void generateCorpus(unsigned int numPositions, unsigned int seed);
+	size_t corpusSize() const {return m_corpus.size();}
+
+	//prints the report and returns the checksum of the whole run
+	unsigned long long run(int passes);
+	//times GenerateMovesAllRolls against 21 GenerateMoves calls over the
+	//corpus and checks both give the same moves, returns the number of
+	//mismatches
+	int runAllRolls(int passes);
+	//compares the bitboard generator with the classic one move by move
+	//over random positions, returns the number of mismatches
+	int crossCheck(unsigned int numPositions, unsigned int seed);
+
+	//round trip check of the position key codec against the original bit
+	//by bit implementation plus a throughput comparison, returns the
+	//number of mismatches
+	int codecCheck(unsigned int numPositions, unsigned int seed);
+
+	//checks BgBoardStats against the scalar board loops it replaced and
+	//times the per candidate queries of both, returns the number of
+	//mismatches
+	int analyticsCheck(unsigned int numPositions, unsigned int seed);
+
+	//scores the candidates of every corpus position for a seeded roll with
+	//the n-ply search on 1..maxThreads threads (0 for all) and reports the
+	//speedup; every thread count has to give the scores and order of one
+	//thread, returns the number of positions that differ
+	int searchScaling(BgAgent *agent, unsigned int nPlies, int maxThreads, unsigned int seed);
+
+	//evaluates the contact candidates of every corpus position for a seeded
+	//roll as one batch, in full and incrementally from the first candidate,
+	//and reports the speedup; returns the number of positions where the
+	//two pick a different best candidate
+	int incrementalCheck(BgAgent *agent, int passes, unsigned int seed);
+
+	//runs the raw inputs of the candidates of every corpus position for a
+	//seeded roll through the FANN network of fileName with every kernel the
+	//CPU offers, one by one, as one batch per position and from the non-zero
+	//inputs only, and trains a copy of the network with each of them; reports
+	//the throughputs and the differences to the generic kernel, returns the
+	//number of candidates beyond the tolerance, whose batch outputs differ
+	//from the single ones or whose sparse inputs differ from the dense ones
+	int fannKernelCheck(const char *fileName, int passes, unsigned int seed);
+
+	//evaluates the candidates of every corpus position for a seeded roll
+	//with the floats, as the agent does and in full, and with 16 and 8 bit
+	//integer weights, each with the generic and the fastest integer kernel;
+	//reports the throughputs, the equity errors and how often the best
+	//candidate changes against the floats, returns the number of positions
+	//where two kernels differ
+	int quantCheck(BgAgent *agent, int passes, unsigned int seed);
+
+	static void randomPosition(BgBoard& board, std::mt19937& rng);
+
+private:
+	struct perftstat
+	{
+		unsigned long long moves;
+		unsigned long long checksum;
+		clock_t time;
+	};
+
+	std::vector<BgBoard> m_corpus;
+	std::vector<bgmove> m_amMoves;
+
+	static unsigned long long moveChecksum(const bgmove& m);
+	static AuchKey referenceKey(const char anBoard[2][25]);
+	static void referenceFromKey(const AuchKey& auch, char anBoard[2][25]);
+	static bool codecRoundTrip(const BgBoard& board);
+	static void referenceStats(const BgBoard& board, int anBack[2], unsigned int anChequers[2], 
+		unsigned int anPips[2]);
+	static positionclass referenceClass(const BgBoard& board);
+};
+
+#endif
@@ -4,7 +4,7 @@
 #pragma once
 
 #include <algorithm>
-#include <vector>
+#include <xmmintrin.h>
 #include "BgCommon.h"
 
 template <class T> T crop(T minVal, T maxVal, T val)
@@ -15,87 +15,69 @@ template <class T> T crop(T minVal, T maxVal, T val)
 	return std::min(std::max(val, minVal), maxVal);
 }
 
-class BgReward : public std::vector<float>
+// The outputs of an evaluation plus the equity, a value type of 8 floats
+// (the last two are padding) that lives on the stack and in place in
+// containers instead of on the heap. The arithmetic runs on two SSE
+// registers; the padding stays zero.
+class BG_ALIGN16 BgReward
 {
 public:
 	static const size_t NN_SIZE = NUM_OUTPUTS;
 
 	BgReward(float val = 0)
 	{
-		resize(NUM_ROLLOUT_OUTPUTS, val);
+		set(val);
 	}
 
 	BgReward(float* data)
 	{
-		resize(NUM_ROLLOUT_OUTPUTS, 0);
 		for(size_t i = 0; i < NUM_ROLLOUT_OUTPUTS; i++)
-			(*this)[i] = data[i];
+			m_ar[i] = data[i];
+		m_ar[6] = m_ar[7] = 0;
 	}
 
-	BgReward(const BgReward& src)
-	{
-		resize(NUM_ROLLOUT_OUTPUTS, 0);
-		for(size_t i = 0; i < NUM_ROLLOUT_OUTPUTS; i++)
-			(*this)[i] = src[i];
-	}
+	size_t size() const {return NUM_ROLLOUT_OUTPUTS;}
+	float& operator[](size_t i) {return m_ar[i];}
+	const float& operator[](size_t i) const {return m_ar[i];}
 
 	void reset()
 	{
-		for(size_t i = 0; i < size(); i++)
-			(*this)[i] = 0;
+		set(0);
 	}
 
 	void set(float val)
 	{
-		for(size_t i = 0; i < size(); i++)
-			(*this)[i] = val;
+		for(size_t i = 0; i < NUM_ROLLOUT_OUTPUTS; i++)
+			m_ar[i] = val;
+		m_ar[6] = m_ar[7] = 0;
 	}
 
 	BgReward operator+(const BgReward& r) const
 	{
-		BgReward res;
-		for(size_t i = 0; i < size(); i++)
-			res[i] = (*this)[i] + r[i];
-
-		return res;
+		return make(_mm_add_ps(lo(), r.lo()), _mm_add_ps(hi(), r.hi()));
 	}
 	BgReward operator-(const BgReward& r) const
 	{
-		BgReward res;
-		for(size_t i = 0; i < size(); i++)
-			res[i] = (*this)[i] - r[i];
-
-		return res;
+		return make(_mm_sub_ps(lo(), r.lo()), _mm_sub_ps(hi(), r.hi()));
 	}
 
 	BgReward operator*(const BgReward& r) const
 	{
-		BgReward res;
-		for(int i = 0; i < size(); i++)
-			res[i] = (*this)[i] * r[i];
-
-		return res;
+		return make(_mm_mul_ps(lo(), r.lo()), _mm_mul_ps(hi(), r.hi()));
 	}
 
 	BgReward operator*(const float r) const
 	{
-		BgReward res;
-		for(int i = 0; i < size(); i++)
-			res[i] = (*this)[i] * r;
-
-		return res;
+		const __m128 v = _mm_set1_ps(r);
+		return make(_mm_mul_ps(lo(), v), _mm_mul_ps(hi(), v));
 	}
 
 	BgReward clamp() const
 	{
-		const float MIN_VAL = 0.0f;
-		const float MAX_VAL = 1.0f;
+		const __m128 minVal = _mm_setzero_ps();
+		const __m128 maxVal = _mm_set1_ps(1.0f);
 
-		BgReward res;
-		for(int i = 0; i < size(); i++)
-			res[i] = crop(MIN_VAL, MAX_VAL, (*this)[i]);
-
-		return res;
+		return make(_mm_min_ps(_mm_max_ps(lo(), minVal), maxVal), _mm_min_ps(_mm_max_ps(hi(), minVal), maxVal));
 	}
 
 	// Move evaluation
@@ -104,26 +86,48 @@ public:
 	float utility() const
 	{
 		// calculate money equity
-		return (*this)[ OUTPUT_WIN ] * 2.0f - 1.0f +
-			( (*this)[ OUTPUT_WINGAMMON ] - (*this)[ OUTPUT_LOSEGAMMON ] ) +
-			( (*this)[ OUTPUT_WINBACKGAMMON ] - (*this)[ OUTPUT_LOSEBACKGAMMON ] );
+		return m_ar[ OUTPUT_WIN ] * 2.0f - 1.0f +
+			( m_ar[ OUTPUT_WINGAMMON ] - m_ar[ OUTPUT_LOSEGAMMON ] ) +
+			( m_ar[ OUTPUT_WINBACKGAMMON ] - m_ar[ OUTPUT_LOSEBACKGAMMON ] );
 	}
 
 	void invert()
 	{
 		float r;
     
-		(*this)[ OUTPUT_WIN ] = 1.0f - (*this)[ OUTPUT_WIN ];
+		m_ar[ OUTPUT_WIN ] = 1.0f - m_ar[ OUTPUT_WIN ];
 	
-		r = (*this)[ OUTPUT_WINGAMMON ];
-		(*this)[ OUTPUT_WINGAMMON ] = (*this)[ OUTPUT_LOSEGAMMON ];
-		(*this)[ OUTPUT_LOSEGAMMON ] = r;
+		r = m_ar[ OUTPUT_WINGAMMON ];
+		m_ar[ OUTPUT_WINGAMMON ] = m_ar[ OUTPUT_LOSEGAMMON ];
+		m_ar[ OUTPUT_LOSEGAMMON ] = r;
 	
-		r = (*this)[ OUTPUT_WINBACKGAMMON ];
-		(*this)[ OUTPUT_WINBACKGAMMON ] = (*this)[ OUTPUT_LOSEBACKGAMMON ];
-		(*this)[ OUTPUT_LOSEBACKGAMMON ] = r;
+		r = m_ar[ OUTPUT_WINBACKGAMMON ];
+		m_ar[ OUTPUT_WINBACKGAMMON ] = m_ar[ OUTPUT_LOSEBACKGAMMON ];
+		m_ar[ OUTPUT_LOSEBACKGAMMON ] = r;
+
+		m_ar[ OUTPUT_EQUITY ] = -m_ar[ OUTPUT_EQUITY ];
+	}
+
+private:
+	float m_ar[8];
+
+	struct NoInit {};
+	explicit BgReward(NoInit) {}
 
-		(*this)[ OUTPUT_EQUITY ] = -(*this)[ OUTPUT_EQUITY ];
+	static BgReward make(__m128 vLo, __m128 vHi)
+	{
+		BgReward res((NoInit()));
+		res.store(vLo, vHi);
+		return res;
+	}
+
+	//unaligned accesses, the 32-bit VS2010 build does not align the type
+	__m128 lo() const {return _mm_loadu_ps(m_ar);}
+	__m128 hi() const {return _mm_loadu_ps(m_ar + 4);}
+	void store(__m128 vLo, __m128 vHi)
+	{
+		_mm_storeu_ps(m_ar, vLo);
+		_mm_storeu_ps(m_ar + 4, vHi);
 	}
 };
 
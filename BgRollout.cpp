@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <math.h>
+#include <random>
+#include "BgRollout.h"
+
+BgRollout::BgRollout(BgAgent *agent, const rolloutcontext& rc)
+	: m_agent(agent), m_rc(rc)
+{
+	m_rSeconds = 0;
+	setThreads(0);
+}
+
+BgRollout::~BgRollout()
+{
+	for(size_t i = 0; i < m_aScratch.size(); i++)
+		delete m_aScratch[ i ];
+}
+
+void BgRollout::setThreads(int nThreads)
+{
+	if(nThreads <= 0)
+		nThreads = omp_get_max_threads();
+
+	while((int)m_aScratch.size() > nThreads)
+	{
+		delete m_aScratch.back();
+		m_aScratch.pop_back();
+	}
+	while((int)m_aScratch.size() < nThreads)
+	{
+		trialscratch *pts = new trialscratch();
+		//the trials themselves run in parallel, each one searches alone
+		pts->search.setThreads(1);
+		//a trial plays the best move only
+		pts->search.setTopMoves(1);
+		pts->amMoves.resize(movelist::MAX_INCOMPLETE_MOVES);
+		m_aScratch.push_back(pts);
+	}
+}
+
+void BgRollout::Rollout(const BgBoard& anBoard)
+{
+	const double rStart = omp_get_wtime();
+	const int nTrials = (int)m_rc.nTrials;
+	m_arTrial.resize(nTrials);
+
+	//a trial only writes the scratch of its thread and its own result
+	const bool fParallel = m_aScratch.size() > 1 && m_agent->isReentrant();
+	const int nThreads = (int)m_aScratch.size();
+#pragma omp parallel for schedule(dynamic) num_threads(nThreads) if(fParallel)
+	for(int i = 0; i < nTrials; i++)
+		Trial(*m_aScratch[ omp_get_thread_num() ], anBoard, i, !fParallel, m_arTrial[ i ]);
+
+	/* mean and standard error of the mean per output, summed in trial order */
+	double arSum[ NUM_ROLLOUT_OUTPUTS ] = {0}, arSumSq[ NUM_ROLLOUT_OUTPUTS ] = {0};
+	for(int i = 0; i < nTrials; i++)
+		for(int j = 0; j < NUM_ROLLOUT_OUTPUTS; j++)
+			arSum[ j ] += m_arTrial[ i ][ j ];
+
+	for(int j = 0; j < NUM_ROLLOUT_OUTPUTS; j++)
+		m_arMean[ j ] = nTrials ? (float)(arSum[ j ] / nTrials) : 0.0f;
+
+	for(int i = 0; i < nTrials; i++)
+		for(int j = 0; j < NUM_ROLLOUT_OUTPUTS; j++)
+		{
+			double r = m_arTrial[ i ][ j ] - m_arMean[ j ];
+			arSumSq[ j ] += r * r;
+		}
+
+	for(int j = 0; j < NUM_ROLLOUT_OUTPUTS; j++)
+		m_arStdErr[ j ] = nTrials > 1 ? (float)sqrt(arSumSq[ j ] / (nTrials - 1) / nTrials) : 0.0f;
+
+	m_rSeconds = omp_get_wtime() - rStart;
+}
+
+void BgRollout::Trial(trialscratch& ts, const BgBoard& anBoard, unsigned int iTrial, bool fSetBoard,
+	BgReward& arResult) const
+{
+	/* the dice stream of the trial, from the seed and the trial number
+	   mixed by splitmix64 */
+	unsigned long long h = ((unsigned long long)m_rc.nSeed << 32) + iTrial + 0x9E3779B97F4A7C15ull;
+	h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ull;
+	h = (h ^ (h >> 27)) * 0x94D049BB133111EBull;
+	h ^= h >> 31;
+	std::mt19937 rng((unsigned int)(h ^ (h >> 32)));
+
+	const evalcontext ec;
+	movelist ml;
+	BgBoard board(anBoard);
+	BgReward arLuck;
+
+	for(unsigned int iPly = 0; ; iPly++)
+	{
+		//board has the side on roll as SELF, anBoardMoved the side that
+		//moved last, the way positions are evaluated
+		BgBoard anBoardMoved(board);
+		anBoardMoved.SwapSides();
+
+		positionclass pc = BgEval::Instance()->ClassifyPosition(&board, VARIATION_STANDARD);
+		if(pc <= CLASS_PERFECT || (m_rc.nTruncate && iPly == m_rc.nTruncate))
+		{
+			ts.search.EvaluatePosition(m_agent, anBoardMoved, 0, arResult, pc);
+			//from the side that moved last, which is the side on roll in
+			//anBoard after an odd number of plies
+			if(!(iPly & 1))
+				arResult.invert();
+			break;
+		}
+
+		int n0, n1;
+		if(m_rc.fRotate && iPly < 2)
+		{
+			/* the first roll runs through the 36 rolls, the second through
+			   the 36 rolls for every first one */
+			unsigned int k = (iPly ? iTrial / 36 : iTrial) % 36;
+			n0 = k / 6 + 1;
+			n1 = k % 6 + 1;
+		}
+		else
+		{
+			n0 = rng() % 6 + 1;
+			n1 = rng() % 6 + 1;
+		}
+
+		if(m_rc.fVarRedn && ts.search.BestReplies(m_agent, anBoardMoved, ts.aBoards, ts.arEval))
+		{
+			/* luck: the evaluation after the best move of this roll less the
+			   average over all rolls, from the side on roll in anBoard */
+			BgReward arMean;
+			int r = 0;
+			for(int i0 = 1; i0 <= 6; i0++)
+				for(int i1 = i0; i1 <= 6; i1++, r++)
+					arMean = arMean + ts.arEval[ r ] * (i0 == i1 ? 1.0f : 2.0f);
+			arMean = arMean * (1.0f / 36.0f);
+
+			r = allrollsmovelist::RollIndex(n0, n1);
+			BgReward arRoll(ts.arEval[ r ]);
+			if(iPly & 1)
+			{
+				arRoll.invert();
+				arMean.invert();
+			}
+			arLuck = arLuck + (arRoll - arMean);
+		}
+
+		//the move played does not depend on the variance reduction
+		if(fSetBoard)
+			m_agent->setCurrentBoard(&board);
+		board.GenerateMoves(&ml, &ts.amMoves[ 0 ], n0, n1, false);
+		if(ml.cMoves)
+		{
+			ts.search.FindBestMoves(m_agent, &ml, ec);
+			board = BgBoard::PositionFromKey(ml.amMoves[ 0 ].auch);
+		}
+		board.SwapSides();
+	}
+
+	if(m_rc.fVarRedn)
+		arResult = arResult - arLuck;
+}
+
+void BgRollout::printResults() const
+{
+	printf("%-8s %8s %8s %8s %8s %8s %8s\n", "", "win", "win(g)", "win(bg)", "lose(g)", "lose(bg)", "equity");
+	printf("%-8s", "mean");
+	for(int j = 0; j < NUM_ROLLOUT_OUTPUTS; j++)
+		printf(" %8.4f", m_arMean[ j ]);
+	printf("\n%-8s", "std err");
+	for(int j = 0; j < NUM_ROLLOUT_OUTPUTS; j++)
+		printf(" %8.4f", m_arStdErr[ j ]);
+	printf("\n%d trials in %.2f s, %.0f trials/s, %d thread(s)\n", (int)m_rc.nTrials, m_rSeconds,
+		m_rSeconds > 0 ? m_rc.nTrials / m_rSeconds : 0.0,
+		m_agent->isReentrant() ? (int)m_aScratch.size() : 1);
+}
@@ -0,0 +1,61 @@
+#ifndef __BGROLLOUT_H
+#define __BGROLLOUT_H
+
+#pragma once
+
+#include "BgBoard.h"
+#include "BgSearch.h"
+
+// Cubeless rollouts after gnubg's rollout.c: the agent plays both sides at
+// 0 ply from the position for nTrials games, to the end or for nTruncate
+// plies, and stops early at exact classes (bearoff databases).
+// Every trial has its own dice stream seeded from nSeed and the trial
+// number; with fRotate the first two rolls run through the 36 x 36 ordered
+// rolls over the trials instead. With fVarRedn the luck of every roll, its
+// best move's evaluation less the average over all 21 rolls, is taken off
+// the result; the moves played are the same with or without it. Trials
+// run on OpenMP threads for reentrant agents and are summed in trial
+// order, so results do not depend on the thread count.
+// All results are from the side on roll in the rolled out position.
+class BgRollout
+{
+public:
+	BgRollout(BgAgent *agent, const rolloutcontext& rc);
+	~BgRollout();
+
+	//0 means all the threads OpenMP offers
+	void setThreads(int nThreads);
+
+	//anBoard has the side on roll as SELF
+	void Rollout(const BgBoard& anBoard);
+	void printResults() const;
+
+	const BgReward& getMean() const {return m_arMean;}
+	const BgReward& getStdErr() const {return m_arStdErr;}
+	double getSeconds() const {return m_rSeconds;}
+
+private:
+	//everything one thread writes while it plays trials
+	struct trialscratch
+	{
+		BgSearch search;
+		std::vector<bgmove> amMoves;
+		BgBoard aBoards[ allrollsmovelist::NUM_ROLLS ];
+		BgReward arEval[ allrollsmovelist::NUM_ROLLS ];
+	};
+
+	BgAgent *m_agent;
+	rolloutcontext m_rc;
+	std::vector<trialscratch *> m_aScratch;
+	std::vector<BgReward> m_arTrial;
+	BgReward m_arMean, m_arStdErr;
+	double m_rSeconds;
+
+	void Trial(trialscratch& ts, const BgBoard& anBoard, unsigned int iTrial, bool fSetBoard,
+		BgReward& arResult) const;
+
+	BgRollout(const BgRollout&);
+	BgRollout& operator=(const BgRollout&);
+};
+
+#endif
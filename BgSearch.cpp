@@ -0,0 +1,495 @@
+#include <float.h>
+#include <string.h>
+#include <algorithm>
+#include "BgSearch.h"
+
+/* gnubg's "normal" move filters: keep the best 0 ply move and up to 8 more
+   within 0.16 of it, at 3 ply keep the best 2 ply move and up to 2 more
+   within 0.04 of it */
+movefilter defaultFilters[MAX_FILTER_PLIES][MAX_FILTER_PLIES] =
+{
+	{ { 0, 8, 0.16f }, {  0, 0, 0.0f }, { 0, 0, 0.0f  }, {  0, 0, 0.0f } },
+	{ { 0, 8, 0.16f }, { -1, 0, 0.0f }, { 0, 0, 0.0f  }, {  0, 0, 0.0f } },
+	{ { 0, 8, 0.16f }, { -1, 0, 0.0f }, { 0, 2, 0.04f }, {  0, 0, 0.0f } },
+	{ { 0, 8, 0.16f }, { -1, 0, 0.0f }, { 0, 2, 0.04f }, { -1, 0, 0.0f } },
+};
+
+/* gnubg keeps 5 moves after the pruning nets; here up to 11 more within
+   the 0 ply filter's threshold */
+static const movefilter pruneFilter = { 5, 11, 0.16f };
+
+BgSearch::BgSearch()
+{
+	m_rSeconds = 0;
+	m_mfPrune = pruneFilter;
+	m_fPruneAudit = false;
+	m_nTop = 0;
+	memset(&m_pruneStats, 0, sizeof(m_pruneStats));
+	setThreads(0);
+}
+
+BgSearch::~BgSearch()
+{
+	for(size_t i = 0; i < m_aScratch.size(); i++)
+		delete m_aScratch[ i ];
+}
+
+void BgSearch::setThreads(int nThreads)
+{
+	if(nThreads <= 0)
+		nThreads = omp_get_max_threads();
+
+	while((int)m_aScratch.size() > nThreads)
+	{
+		delete m_aScratch.back();
+		m_aScratch.pop_back();
+	}
+	while((int)m_aScratch.size() < nThreads)
+	{
+		m_aScratch.push_back(new threadscratch());
+		m_aScratch.back()->nNodes = 0;
+	}
+}
+
+unsigned long long BgSearch::getNodes() const
+{
+	unsigned long long nNodes = 0;
+	for(size_t i = 0; i < m_aScratch.size(); i++)
+		nNodes += m_aScratch[ i ]->nNodes;
+	return nNodes;
+}
+
+//the scratch of the calling thread inside the parallel regions of
+//ScoreMoves; one that runs on a single thread gets the first one
+BgSearch::threadscratch& BgSearch::Scratch()
+{
+	return *m_aScratch[ omp_get_thread_num() ];
+}
+
+void BgSearch::FindBestMoves(BgAgent *agent, movelist *pml, const evalcontext& ec)
+{
+	const double rStart = omp_get_wtime();
+	const unsigned int nPlies = std::min(ec.nPlies, (unsigned int)MAX_FILTER_PLIES);
+
+	if(ec.fUsePrune && agent->hasPruning() && pml->cMoves > (unsigned int)std::max(m_mfPrune.Accept, 0))
+		PruneMoves(agent, pml);
+
+	for(unsigned int iPly = 0; iPly < nPlies; iPly++)
+	{
+		const movefilter& mf = defaultFilters[ nPlies - 1 ][ iPly ];
+		if(mf.Accept < 0)
+			continue;
+
+		/* keep the best Accept moves and up to Extra more that are within
+		   Threshold of the best one; only those need to be in order */
+		ScoreMoves(agent, pml, iPly);
+		const unsigned int k = pml->cMoves;
+		SelectMoves(pml, std::min(k, (unsigned int)std::max(mf.Accept + mf.Extra, 1)));
+		pml->cMoves = std::min((unsigned int)mf.Accept, k);
+		const unsigned int limit = std::min(k, pml->cMoves + mf.Extra);
+		for(; pml->cMoves < limit; pml->cMoves++)
+			if(pml->amMoves[ pml->cMoves ].rScore < pml->amMoves[ 0 ].rScore - mf.Threshold)
+				break;
+	}
+
+	ScoreMoves(agent, pml, nPlies);
+	SelectMoves(pml, m_nTop ? std::min(m_nTop, pml->cMoves) : pml->cMoves);
+	pml->iMoveBest = 0;
+
+	m_rSeconds += omp_get_wtime() - rStart;
+}
+
+void BgSearch::SelectMoves(movelist *pml, unsigned int n)
+{
+	const unsigned int cMoves = pml->cMoves;
+	if(n > cMoves)
+		n = cMoves;
+	if(n == 0)
+		return;
+
+	if(n == 1)
+	{
+		/* a running argmax, the candidates stay where they are but the best */
+		unsigned int iBest = 0;
+		for(unsigned int i = 1; i < cMoves; i++)
+			if(pml->amMoves[ i ] < pml->amMoves[ iBest ])
+				iBest = i;
+		if(iBest)
+			std::swap(pml->amMoves[ 0 ], pml->amMoves[ iBest ]);
+		return;
+	}
+
+	/* rank the compact keys, then swap only the n winners into place */
+	if(m_aRank.size() < cMoves)
+	{
+		m_aRank.resize(cMoves);
+		m_aiAt.resize(cMoves);
+		m_aiWho.resize(cMoves);
+	}
+	for(unsigned int i = 0; i < cMoves; i++)
+	{
+		m_aRank[ i ].rScore = pml->amMoves[ i ].rScore;
+		m_aRank[ i ].backChequer = pml->amMoves[ i ].backChequer;
+		m_aRank[ i ].i = i;
+		m_aiAt[ i ] = m_aiWho[ i ] = i;
+	}
+	if(n < cMoves)
+		std::partial_sort(m_aRank.begin(), m_aRank.begin() + n, m_aRank.begin() + cMoves);
+	else
+		std::sort(m_aRank.begin(), m_aRank.begin() + cMoves);
+
+	for(unsigned int j = 0; j < n; j++)
+	{
+		const unsigned int iMove = m_aRank[ j ].i, iFrom = m_aiAt[ iMove ];
+		if(iFrom == j)
+			continue;
+		std::swap(pml->amMoves[ j ], pml->amMoves[ iFrom ]);
+		const unsigned int iOther = m_aiWho[ j ];
+		m_aiWho[ iFrom ] = iOther;
+		m_aiAt[ iOther ] = iFrom;
+		m_aiWho[ j ] = iMove;
+		m_aiAt[ iMove ] = j;
+	}
+}
+
+namespace
+{
+	struct higherScore
+	{
+		const float *ar;
+		higherScore(const float *ar_) : ar(ar_) {}
+		bool operator()(unsigned int i, unsigned int j) const {return ar[ i ] > ar[ j ];}
+	};
+}
+
+//cuts the candidates of pml by their cheap scores; the kept ones stay in
+//generation order and the cut ones follow them past pml->cMoves
+void BgSearch::PruneMoves(BgAgent *agent, movelist *pml)
+{
+	const unsigned int cMoves = pml->cMoves;
+	unsigned int iBest = 0;
+	float rBest = 0;
+	if(m_fPruneAudit)
+	{
+		//the audit's full evaluations are not part of the search time
+		const double rStart = omp_get_wtime();
+		ScoreMoves(agent, pml, 0);
+		iBest = pml->iMoveBest;
+		rBest = pml->rBestScore;
+		m_rSeconds -= omp_get_wtime() - rStart;
+	}
+
+	threadscratch& ts = *m_aScratch[ 0 ];
+	plybuffers& ply = ts.aPly[ 0 ];
+	if(ply.aBoards.size() < cMoves)
+	{
+		ply.aBoards.resize(cMoves);
+		ply.apc.resize(cMoves);
+		ply.arEval.resize(cMoves);
+	}
+	if(m_arPrune.size() < cMoves)
+	{
+		m_arPrune.resize(cMoves);
+		m_aiPrune.resize(cMoves);
+		m_amPrune.resize(cMoves);
+	}
+
+	ply.aViews.clear();
+	for(unsigned int i = 0; i < cMoves; i++)
+	{
+		ply.aBoards[ i ] = BgBoard::PositionFromKey(pml->amMoves[ i ].auch);
+		ply.aViews.push_back(BgBoardView(ply.aBoards[ i ], true));
+		ply.apc[ i ] = BgEval::Instance()->ClassifyPosition(ply.aViews[ i ], VARIATION_STANDARD);
+		m_arPrune[ i ] = FLT_MAX;
+		m_aiPrune[ i ] = i;
+	}
+	agent->prunePositions(&ply.aViews[ 0 ], &ply.apc[ 0 ], &m_arPrune[ 0 ], cMoves);
+
+	/* rank by the cheap score, ties in generation order; the positions that
+	   were not scored rank first and do not set the best score */
+	std::stable_sort(m_aiPrune.begin(), m_aiPrune.begin() + cMoves, higherScore(&m_arPrune[ 0 ]));
+
+	unsigned int cKept = 0;
+	while(cKept < cMoves && m_arPrune[ m_aiPrune[ cKept ] ] == FLT_MAX)
+		cKept++;
+	const unsigned int cExact = cKept;
+	const float rTop = cKept < cMoves ? m_arPrune[ m_aiPrune[ cKept ] ] : 0.0f;
+	cKept = std::min(cMoves, cExact + (unsigned int)m_mfPrune.Accept);
+	const unsigned int limit = std::min(cMoves, cKept + (unsigned int)std::max(m_mfPrune.Extra, 0));
+	for(; cKept < limit; cKept++)
+		if(m_arPrune[ m_aiPrune[ cKept ] ] < rTop - m_mfPrune.Threshold)
+			break;
+
+	//the kept flags reuse the scores, a kept move gets FLT_MAX
+	for(unsigned int i = 0; i < cKept; i++)
+		m_arPrune[ m_aiPrune[ i ] ] = FLT_MAX;
+	unsigned int iKept = 0, iCut = cKept;
+	for(unsigned int i = 0; i < cMoves; i++)
+		m_amPrune[ m_arPrune[ i ] == FLT_MAX ? iKept++ : iCut++ ] = pml->amMoves[ i ];
+	std::copy(m_amPrune.begin(), m_amPrune.begin() + cMoves, pml->amMoves);
+
+	if(m_fPruneAudit)
+	{
+		float rKept = -99999.9f;
+		for(unsigned int i = 0; i < cKept; i++)
+			rKept = std::max(rKept, pml->amMoves[ i ].rScore);
+		m_pruneStats.nAudited++;
+		if(m_arPrune[ iBest ] != FLT_MAX)
+		{
+			m_pruneStats.nBestPruned++;
+			m_pruneStats.rEquityLost += rBest - rKept;
+		}
+	}
+
+	pml->cMoves = cKept;
+	m_pruneStats.nDecisions++;
+	m_pruneStats.nCandidates += cMoves;
+	m_pruneStats.nKept += cKept;
+}
+
+void BgSearch::ScoreMoves(BgAgent *agent, movelist *pml, unsigned int nPlies)
+{
+	const unsigned int cMoves = pml->cMoves;
+	pml->rBestScore = -99999.9f;
+
+	if(!cMoves)
+		return;
+
+	if(!nPlies)
+	{
+		//all candidates are classified first and handed to the agent in one
+		//batch, so agents with a batch evaluator run one pass per position class
+		threadscratch& ts = *m_aScratch[ 0 ];
+		plybuffers& ply = ts.aPly[ 0 ];
+		if(ply.aBoards.size() < cMoves)
+			ply.aBoards.resize(cMoves);
+		for(unsigned int i = 0; i < cMoves; i++)
+			ply.aBoards[ i ] = BgBoard::PositionFromKey(pml->amMoves[ i ].auch);
+		EvaluateStatic(ts, agent, ply, cMoves);
+
+		for(unsigned int i = 0; i < cMoves; i++)
+		{
+			pml->amMoves[ i ].pc = ply.apc[ i ];
+			pml->amMoves[ i ].arEvalMove = ply.arEval[ i ];
+		}
+	}
+	else
+	{
+		if(m_aRoot.size() < cMoves)
+			m_aRoot.resize(cMoves);
+
+		//the threads only write their own scratch and the slots of m_aRoot
+		//they were handed, the scores are combined below in a fixed order
+		const bool fParallel = m_aScratch.size() > 1 && agent->isReentrant();
+		const int nThreads = (int)m_aScratch.size();
+		int n = (int)cMoves;
+#pragma omp parallel for schedule(dynamic) num_threads(nThreads) if(fParallel)
+		for(int i = 0; i < n; i++)
+			Expand(Scratch(), agent, BgBoard::PositionFromKey(pml->amMoves[ i ].auch), nPlies, m_aRoot[ i ]);
+
+		if(nPlies > 1)
+		{
+			n = (int)cMoves * allrollsmovelist::NUM_ROLLS;
+#pragma omp parallel for schedule(dynamic) num_threads(nThreads) if(fParallel)
+			for(int i = 0; i < n; i++)
+			{
+				expansion& e = m_aRoot[ i / allrollsmovelist::NUM_ROLLS ];
+				const int r = i % allrollsmovelist::NUM_ROLLS;
+				positionclass pc;
+				if(!e.fLeaf)
+					EvaluatePositionFull(Scratch(), agent, e.aBoards[ r ], nPlies - 1, e.arEval[ r ], pc);
+			}
+		}
+
+		for(unsigned int i = 0; i < cMoves; i++)
+		{
+			const expansion& e = m_aRoot[ i ];
+			bgmove& pm = pml->amMoves[ i ];
+			pm.pc = e.pc;
+			if(e.fLeaf)
+				pm.arEvalMove = e.arOutput;
+			else
+				Average(e, pm.arEvalMove);
+		}
+	}
+
+	for(unsigned int i = 0; i < cMoves; i++)
+	{
+		bgmove& pm = pml->amMoves[ i ];
+		pm.rScore = pm.arEvalMove[ OUTPUT_EQUITY ];
+
+		if(pm.rScore > pml->rBestScore)
+		{
+			pml->iMoveBest = i;
+			pml->rBestScore = pm.rScore;
+		}
+	}
+}
+
+void BgSearch::EvaluatePosition(BgAgent *agent, const BgBoard& anBoard, unsigned int nPlies,
+	BgReward& arOutput, positionclass& pc)
+{
+	EvaluatePositionFull(*m_aScratch[ 0 ], agent, anBoard, std::min(nPlies, (unsigned int)MAX_FILTER_PLIES), arOutput, pc);
+}
+
+bool BgSearch::BestReplies(BgAgent *agent, const BgBoard& anBoard, 
+	BgBoard aBoards[ allrollsmovelist::NUM_ROLLS ], BgReward arEval[ allrollsmovelist::NUM_ROLLS ])
+{
+	expansion& e = m_aScratch[ 0 ]->aExpansion[ 1 ];
+	Expand(*m_aScratch[ 0 ], agent, anBoard, 1, e);
+	if(e.fLeaf)
+		return false;
+
+	for(int r = 0; r < allrollsmovelist::NUM_ROLLS; r++)
+	{
+		aBoards[ r ] = e.aBoards[ r ];
+		arEval[ r ] = e.arEval[ r ];
+	}
+	return true;
+}
+
+//evaluates ply.aBoards, positions right after a move, from the side of the
+//opponent who is on roll and returns the rewards from the side that moved
+void BgSearch::EvaluateStatic(threadscratch& ts, BgAgent *agent, plybuffers& ply, unsigned int cPositions)
+{
+	if(ply.arEval.size() < cPositions)
+	{
+		ply.arEval.resize(cPositions);
+		ply.apc.resize(cPositions);
+		ply.aViews.reserve(cPositions);
+	}
+
+	ply.aViews.clear();
+	for(unsigned int i = 0; i < cPositions; i++)
+	{
+		ply.aViews.push_back(BgBoardView(ply.aBoards[ i ], true));
+		ply.apc[ i ] = BgEval::Instance()->ClassifyPosition(ply.aViews[ i ], VARIATION_STANDARD);
+		ply.arEval[ i ].reset();
+	}
+
+	agent->evaluatePositions(&ply.aViews[ 0 ], &ply.apc[ 0 ], &ply.arEval[ 0 ], cPositions);
+
+	for(unsigned int i = 0; i < cPositions; i++)
+	{
+		BgReward& arEval = ply.arEval[ i ];
+		const positionclass pc = ply.apc[ i ];
+		if(pc > CLASS_PERFECT && agent->supportsSanityCheck() && !agent->isLearnMode())
+		{
+			/* no sanity check needed for exact evaluations */
+			BgEval::Instance()->SanityCheck(ply.aViews[ i ], arEval);
+		}
+		arEval[ OUTPUT_EQUITY ] = arEval.utility();
+
+		if(agent->needsInvertedEval())
+			arEval.invert();
+		else
+		if(pc != CLASS_CONTACT && pc != CLASS_CRASHED && pc != CLASS_RACE)
+			arEval.invert();
+	}
+
+	ts.nNodes += cPositions;
+}
+
+void BgSearch::EvaluateLeaf(threadscratch& ts, BgAgent *agent, const BgBoard& anBoard,
+	BgReward& arOutput, positionclass& pc)
+{
+	plybuffers& leaf = ts.aPly[ 0 ];
+	if(leaf.aBoards.empty())
+		leaf.aBoards.resize(1);
+	leaf.aBoards[ 0 ] = anBoard;
+	EvaluateStatic(ts, agent, leaf, 1);
+	arOutput = leaf.arEval[ 0 ];
+	pc = leaf.apc[ 0 ];
+}
+
+void BgSearch::Expand(threadscratch& ts, BgAgent *agent, const BgBoard& anBoard, unsigned int nPlies, expansion& e)
+{
+	e.pc = BgEval::Instance()->ClassifyPosition(BgBoardView(anBoard, true), VARIATION_STANDARD);
+	e.fLeaf = e.pc <= CLASS_PERFECT;
+	if(e.fLeaf)
+	{
+		/* exact evaluation; use static evaluation */
+		EvaluateLeaf(ts, agent, anBoard, e.arOutput, e.pc);
+		return;
+	}
+
+	/* the opponent plays each roll; all moves of all rolls are evaluated
+	   in one batch and the best one of each roll is kept */
+	plybuffers& ply = ts.aPly[ nPlies ];
+	BgBoard anBoardOpp(anBoard);
+	anBoardOpp.SwapSides();
+	anBoardOpp.GenerateMovesAllRolls(&ply.aml, false);
+
+	unsigned int aiFirst[ allrollsmovelist::NUM_ROLLS + 1 ];
+	unsigned int cPositions = 0;
+	for(int r = 0; r < allrollsmovelist::NUM_ROLLS; r++)
+		cPositions += std::max(ply.aml.aml[ r ].cMoves, 1u);
+	if(ply.aBoards.size() < cPositions)
+		ply.aBoards.resize(cPositions);
+
+	cPositions = 0;
+	for(int r = 0; r < allrollsmovelist::NUM_ROLLS; r++)
+	{
+		const movelist& ml = ply.aml.aml[ r ];
+		aiFirst[ r ] = cPositions;
+		//no legal move, the board stays as it is
+		if(!ml.cMoves)
+			ply.aBoards[ cPositions++ ] = anBoardOpp;
+		for(unsigned int i = 0; i < ml.cMoves; i++)
+			ply.aBoards[ cPositions++ ] = BgBoard::PositionFromKey(ml.amMoves[ i ].auch);
+	}
+	aiFirst[ allrollsmovelist::NUM_ROLLS ] = cPositions;
+
+	EvaluateStatic(ts, agent, ply, cPositions);
+
+	for(int r = 0; r < allrollsmovelist::NUM_ROLLS; r++)
+	{
+		unsigned int iBest = aiFirst[ r ];
+		for(unsigned int i = iBest + 1; i < aiFirst[ r + 1 ]; i++)
+			if(ply.arEval[ i ][ OUTPUT_EQUITY ] > ply.arEval[ iBest ][ OUTPUT_EQUITY ])
+				iBest = i;
+
+		e.aBoards[ r ] = ply.aBoards[ iBest ];
+		e.arEval[ r ] = ply.arEval[ iBest ];
+		e.arWeight[ r ] = (float)ply.aml.Weight(r);
+	}
+}
+
+/* average over the 36 rolls and turn it to the side that moved */
+void BgSearch::Average(const expansion& e, BgReward& arOutput)
+{
+	BgReward arSum;
+	for(int r = 0; r < allrollsmovelist::NUM_ROLLS; r++)
+		arSum = arSum + e.arEval[ r ] * e.arWeight[ r ];
+
+	arOutput = arSum * (1.0f / 36.0f);
+	arOutput.invert();
+}
+
+void BgSearch::EvaluatePositionFull(threadscratch& ts, BgAgent *agent, const BgBoard& anBoard, unsigned int nPlies,
+	BgReward& arOutput, positionclass& pc)
+{
+	if(!nPlies)
+	{
+		/* at leaf node; use static evaluation */
+		EvaluateLeaf(ts, agent, anBoard, arOutput, pc);
+		return;
+	}
+
+	expansion& e = ts.aExpansion[ nPlies ];
+	Expand(ts, agent, anBoard, nPlies, e);
+	pc = e.pc;
+	if(e.fLeaf)
+	{
+		arOutput = e.arOutput;
+		return;
+	}
+
+	if(nPlies > 1)
+	{
+		positionclass pcChild;
+		for(int r = 0; r < allrollsmovelist::NUM_ROLLS; r++)
+			EvaluatePositionFull(ts, agent, e.aBoards[ r ], nPlies - 1, e.arEval[ r ], pcChild);
+	}
+	Average(e, arOutput);
+}
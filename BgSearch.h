@@ -0,0 +1,159 @@
+#ifndef __BGSEARCH_H
+#define __BGSEARCH_H
+
+#pragma once
+
+#include <vector>
+#include "BgBoard.h"
+#include "Agent/BgAgent.h"
+
+// n-ply expectiminimax over the 21 rolls after gnubg's FindnSaveBestMoves
+// and EvaluatePositionFull. The candidates of a move are scored at 0 ply
+// and pruned by the move filters before every deeper ply. At an inner node
+// the side on roll plays its best 0 ply move for each roll and the chosen
+// positions are searched one ply less; exact classes (game over and the
+// bearoff databases) are not searched. All evaluations are from the side
+// that made the move leading to the position.
+// With ec.fUsePrune and an agent with a pruning evaluator the candidates
+// are cut first by their cheap scores with the prune filter; positions the
+// cheap evaluator does not cover are always kept. The audit scores the cut
+// candidates too, to count how often the best 0 ply move was among them.
+// With a reentrant agent the candidates, and below 1 ply every roll of
+// every candidate, are spread over OpenMP threads. Each thread searches in
+// its own scratch and every value is combined in a fixed order, so the
+// scores do not depend on the number of threads. The scratch only grows,
+// the search stops allocating once it has warmed up.
+class BgSearch
+{
+public:
+	BgSearch();
+	~BgSearch();
+
+	//scores the candidates of pml at ec.nPlies plies and puts the best
+	//getTopMoves() of them, or all, first in bgmove order
+	void FindBestMoves(BgAgent *agent, movelist *pml, const evalcontext& ec);
+	//scores the candidates of pml at nPlies plies, unsorted
+	void ScoreMoves(BgAgent *agent, movelist *pml, unsigned int nPlies);
+
+	//evaluates anBoard, a position right after a move, at nPlies plies
+	//from the side that made the move
+	void EvaluatePosition(BgAgent *agent, const BgBoard& anBoard, unsigned int nPlies,
+		BgReward& arOutput, positionclass& pc);
+	//the best 0 ply reply to anBoard, a position right after a move, for
+	//every roll in allrollsmovelist order, evaluated from the side of the
+	//replier; false for an exact class, which is not expanded
+	bool BestReplies(BgAgent *agent, const BgBoard& anBoard, 
+		BgBoard aBoards[ allrollsmovelist::NUM_ROLLS ], BgReward arEval[ allrollsmovelist::NUM_ROLLS ]);
+
+	//keep the Accept best candidates by the cheap score and up to Extra more
+	//within Threshold of the best one
+	void setPruneFilter(const movefilter& mf) {m_mfPrune = mf;}
+	const movefilter& getPruneFilter() const {return m_mfPrune;}
+	void setPruneAudit(bool fAudit) {m_fPruneAudit = fAudit;}
+
+	struct prunestats
+	{
+		unsigned long long nDecisions, nCandidates, nKept;
+		//audited decisions, those where the best 0 ply move was cut and the
+		//equity it cost in total
+		unsigned long long nAudited, nBestPruned;
+		double rEquityLost;
+	};
+	const prunestats& getPruneStats() const {return m_pruneStats;}
+
+	//how many candidates FindBestMoves puts in order at the front of the
+	//list, the others follow unordered; 0 orders all of them
+	void setTopMoves(unsigned int nTop) {m_nTop = nTop;}
+	unsigned int getTopMoves() const {return m_nTop;}
+	//moves the best n candidates of pml to its front in bgmove order, equal
+	//ones in list order; n = pml->cMoves sorts the whole list
+	void SelectMoves(movelist *pml, unsigned int n);
+
+	//0 means all the threads OpenMP offers
+	void setThreads(int nThreads);
+	int getThreads() const {return (int)m_aScratch.size();}
+
+	//positions evaluated or expanded so far and the wall time spent on it
+	unsigned long long getNodes() const;
+	double getSeconds() const {return m_rSeconds;}
+
+private:
+	struct plybuffers
+	{
+		allrollsmovelist aml;
+		std::vector<BgBoard> aBoards;
+		std::vector<BgBoardView> aViews;
+		std::vector<positionclass> apc;
+		std::vector<BgReward> arEval;
+	};
+
+	//a position and the best reply for each roll with its evaluation from
+	//the side of the replier; an exact class is not expanded
+	struct expansion
+	{
+		positionclass pc;
+		bool fLeaf;
+		BgReward arOutput;
+		BgBoard aBoards[ allrollsmovelist::NUM_ROLLS ];
+		BgReward arEval[ allrollsmovelist::NUM_ROLLS ];
+		float arWeight[ allrollsmovelist::NUM_ROLLS ];
+	};
+
+	//everything one thread writes while it searches:
+	//aPly[ 0 ] serves static evaluations, aPly[ n ] and aExpansion[ n ]
+	//the expansion of an n ply node
+	struct threadscratch
+	{
+		plybuffers aPly[ MAX_FILTER_PLIES + 1 ];
+		expansion aExpansion[ MAX_FILTER_PLIES + 1 ];
+		unsigned long long nNodes;
+	};
+
+	std::vector<threadscratch *> m_aScratch;
+	//expansions of the candidates being scored
+	std::vector<expansion> m_aRoot;
+	double m_rSeconds;
+
+	movefilter m_mfPrune;
+	bool m_fPruneAudit;
+	prunestats m_pruneStats;
+	std::vector<float> m_arPrune;
+	std::vector<unsigned int> m_aiPrune;
+	std::vector<bgmove> m_amPrune;
+
+	//a candidate's sort key, ordered like bgmove and then by list position
+	struct moverank
+	{
+		float rScore;
+		int backChequer;
+		unsigned int i;
+
+		bool operator < (const moverank& r) const
+		{
+			if(rScore != r.rScore)
+				return rScore > r.rScore;
+			if(backChequer != r.backChequer)
+				return backChequer < r.backChequer;
+			return i < r.i;
+		}
+	};
+	unsigned int m_nTop;
+	std::vector<moverank> m_aRank;
+	//where each candidate is while SelectMoves swaps them, and which is where
+	std::vector<unsigned int> m_aiAt, m_aiWho;
+
+	threadscratch& Scratch();
+	void PruneMoves(BgAgent *agent, movelist *pml);
+	void EvaluateStatic(threadscratch& ts, BgAgent *agent, plybuffers& ply, unsigned int cPositions);
+	void EvaluateLeaf(threadscratch& ts, BgAgent *agent, const BgBoard& anBoard,
+		BgReward& arOutput, positionclass& pc);
+	void Expand(threadscratch& ts, BgAgent *agent, const BgBoard& anBoard, unsigned int nPlies, expansion& e);
+	static void Average(const expansion& e, BgReward& arOutput);
+	void EvaluatePositionFull(threadscratch& ts, BgAgent *agent, const BgBoard& anBoard, unsigned int nPlies,
+		BgReward& arOutput, positionclass& pc);
+
+	BgSearch(const BgSearch&);
+	BgSearch& operator=(const BgSearch&);
+};
+
+#endif
@@ -177,9 +177,10 @@ void runTest()
 int main(int argc, char **argv)
 {
 	BgDispatcher *dispatcher = new BgDispatcher();
+	int status = 0;
 	if(dispatcher->init(argc, argv))
 	{
-		dispatcher->run();
+		status = dispatcher->run() ? 0 : 1;
 	}
 
 	//perfTest();
@@ -189,5 +190,5 @@ int main(int argc, char **argv)
 	BgEval::Destroy();
 
 	getchar();
-	return 0;
+	return status;
 }
@@ -55,7 +55,7 @@
 #define g_return_val_if_fail(cond, ret) if(!(cond)) return (ret);
 #endif
 
-static int setGammonProb(const BgBoard * anBoard, unsigned int bp0, unsigned int bp1, float* g0, float* g1)
+static int setGammonProb(const BgBoardView& anBoard, unsigned int bp0, unsigned int bp1, float* g0, float* g1)
 {
   int i;
   unsigned short int prob[32];
@@ -64,8 +64,8 @@ static int setGammonProb(const BgBoard * anBoard, unsigned int bp0, unsigned int
   unsigned int tot1 = 0;
   
   for(i = 5; i >= 0; --i) {
-    tot0 += anBoard->anBoard[0][i];
-    tot1 += anBoard->anBoard[1][i];
+    tot0 += anBoard.anBoard[0][i];
+    tot1 += anBoard.anBoard[1][i];
   }
 
   { assert( tot0 == 15 || tot1 == 15 ); }
@@ -74,7 +74,7 @@ static int setGammonProb(const BgBoard * anBoard, unsigned int bp0, unsigned int
   *g1 = 0.0;
 
   if( tot0 == 15 ) {
-    struct GammonProbs* gp = getBearoffGammonProbs(anBoard->anBoard[0]);
+    struct GammonProbs* gp = getBearoffGammonProbs(anBoard.anBoard[0]);
     double make[3];
 
     if (BearoffDist ( BgEval::Instance()->pbc1, bp1, NULL, NULL, NULL, prob, NULL ))
@@ -91,7 +91,7 @@ static int setGammonProb(const BgBoard * anBoard, unsigned int bp0, unsigned int
   }
 
   if( tot1 == 15 ) {
-    struct GammonProbs* gp = getBearoffGammonProbs(anBoard->anBoard[1]);
+    struct GammonProbs* gp = getBearoffGammonProbs(anBoard.anBoard[1]);
     double make[3];
 
     if (BearoffDist ( BgEval::Instance()->pbc1, bp0, NULL, NULL, NULL, prob, NULL ))
@@ -342,10 +342,10 @@ extern int BearoffCubeful(const bearoffcontext * pbc, const unsigned int iPos, f
 }
 
 static int
-BearoffEvalTwoSided ( const bearoffcontext *pbc, const BgBoard * anBoard, BgReward& arOutput ) 
+BearoffEvalTwoSided ( const bearoffcontext *pbc, const BgBoardView& anBoard, BgReward& arOutput ) 
 {
-	unsigned int nUs = PositionId::PositionBearoff ( anBoard->anBoard[ 1 ], pbc->nPoints, pbc->nChequers );
-	unsigned int nThem = PositionId::PositionBearoff ( anBoard->anBoard[ 0 ], pbc->nPoints, pbc->nChequers );
+	unsigned int nUs = PositionId::PositionBearoff ( anBoard.anBoard[ 1 ], pbc->nPoints, pbc->nChequers );
+	unsigned int nThem = PositionId::PositionBearoff ( anBoard.anBoard[ 0 ], pbc->nPoints, pbc->nChequers );
 	unsigned int n = PositionId::Combination ( pbc->nPoints + pbc->nChequers, pbc->nPoints );
 	unsigned int iPos = nUs * n + nThem;
 	float ar[ 4 ];
@@ -399,7 +399,7 @@ ReadHypergammon( const bearoffcontext *pbc,
 	return 0;
 }
 
-static int BearoffEvalOneSided ( const bearoffcontext *pbc, const BgBoard *anBoard, BgReward& arOutput )
+static int BearoffEvalOneSided ( const bearoffcontext *pbc, const BgBoardView& anBoard, BgReward& arOutput )
 {
 	int i, j;
 	float aarProb[ 2 ][ 32 ];
@@ -413,7 +413,7 @@ static int BearoffEvalOneSided ( const bearoffcontext *pbc, const BgBoard *anBoa
 
 	for ( i = 0; i < 2; ++i ) 
 	{
-		an[ i ] = PositionId::PositionBearoff ( anBoard->anBoard[ i ], pbc->nPoints, pbc->nChequers );
+		an[ i ] = PositionId::PositionBearoff ( anBoard.anBoard[ i ], pbc->nPoints, pbc->nChequers );
 		if ( BearoffDist ( pbc, an[ i ], aarProb[ i ], 
 			aarGammonProb[ i ], ar [ i ], NULL, NULL ) )
 		return -1;
@@ -430,7 +430,7 @@ static int BearoffEvalOneSided ( const bearoffcontext *pbc, const BgBoard *anBoa
 	// calculate gammon chances
 	for ( i = 0; i < 2; ++i )
 		for ( j = 0, anOn[ i ] = 0; j < 25; ++j )
-			anOn[ i ] += anBoard->anBoard[ i ][ j ];
+			anOn[ i ] += anBoard.anBoard[ i ][ j ];
 
 	if ( anOn[ 0 ] == 15 || anOn[ 1 ] == 15 ) 
 	{
@@ -488,17 +488,17 @@ BearoffHyper( const bearoffcontext *pbc,
 
 static int
 BearoffEvalHypergammon ( const bearoffcontext *pbc, 
-                         const BgBoard * anBoard, BgReward& arOutput ) 
+                         const BgBoardView& anBoard, BgReward& arOutput ) 
 {
-	unsigned int nUs = PositionId::PositionBearoff ( anBoard->anBoard[ 1 ], pbc->nPoints, pbc->nChequers );
-	unsigned int nThem = PositionId::PositionBearoff ( anBoard->anBoard[ 0 ], pbc->nPoints, pbc->nChequers );
+	unsigned int nUs = PositionId::PositionBearoff ( anBoard.anBoard[ 1 ], pbc->nPoints, pbc->nChequers );
+	unsigned int nThem = PositionId::PositionBearoff ( anBoard.anBoard[ 0 ], pbc->nPoints, pbc->nChequers );
 	unsigned int n = PositionId::Combination ( pbc->nPoints + pbc->nChequers, pbc->nPoints );
 	unsigned int iPos = nUs * n + nThem;
 
 	return ReadHypergammon ( pbc, iPos, arOutput, NULL );
 }
 
-int BearoffEval(const bearoffcontext * pbc, const BgBoard * anBoard, BgReward& arOutput)
+int BearoffEval(const bearoffcontext * pbc, const BgBoardView& anBoard, BgReward& arOutput)
 {
 	if(!pbc) return 0;
 
@@ -1256,7 +1256,7 @@ extern int BearoffDist(const bearoffcontext * pbc, const unsigned int nPosID,
 		return ReadBearoffOneSidedExact(pbc, nPosID, arProb, arGammonProb, ar, ausProb, ausGammonProb);
 }
 
-bool isBearoff(const bearoffcontext *pbc, const BgBoard * anBoard)
+bool isBearoff(const bearoffcontext *pbc, const BgBoardView& anBoard)
 {
   unsigned int i, nOppBack, nBack;
   unsigned int n = 0, nOpp = 0;
@@ -1265,15 +1265,15 @@ bool isBearoff(const bearoffcontext *pbc, const BgBoard * anBoard)
 
   for (nOppBack = 24; nOppBack > 0; nOppBack--)
   {
-    if (anBoard->anBoard[0][nOppBack])
+    if (anBoard.anBoard[0][nOppBack])
       break;
   }
   for (nBack = 24; nBack > 0; nBack--)
   {
-    if (anBoard->anBoard[1][nBack])
+    if (anBoard.anBoard[1][nBack])
       break;
   }
-  if (!anBoard->anBoard[0][nOppBack] || !anBoard->anBoard[1][nBack])
+  if (!anBoard.anBoard[0][nOppBack] || !anBoard.anBoard[1][nBack])
     /* the game is over */
     return false;
 
@@ -1282,10 +1282,10 @@ bool isBearoff(const bearoffcontext *pbc, const BgBoard * anBoard)
     return false;
 
   for ( i = 0; i <= nOppBack; ++i )
-    nOpp += anBoard->anBoard[ 0 ][ i ];
+    nOpp += anBoard.anBoard[ 0 ][ i ];
 
   for ( i = 0; i <= nBack; ++i )
-    n += anBoard->anBoard[ 1 ][ i ];
+    n += anBoard.anBoard[ 1 ][ i ];
 
   if ( n <= pbc->nChequers && nOpp <= pbc->nChequers &&
        nBack < pbc->nPoints && nOppBack < pbc->nPoints )
@@ -78,11 +78,12 @@ enum _bearoffoptions
 
 
 class BgBoard;
+class BgBoardView;
 bearoffcontext *BearoffInit ( const char *szFilename, const int bo, void (*p)(unsigned int) );
 
 //bearoffcontext *BearoffInitBuiltin ( void );
 
-int BearoffEval ( const bearoffcontext *pbc, const BgBoard * anBoard, BgReward& arOutput );
+int BearoffEval ( const bearoffcontext *pbc, const BgBoardView& anBoard, BgReward& arOutput );
 
 extern void
 BearoffStatus ( const bearoffcontext *pbc, char *sz );
@@ -104,7 +105,7 @@ BearoffCubeful ( const bearoffcontext *pbc,
 
 extern void BearoffClose ( bearoffcontext *ppbc );
 
-bool isBearoff ( const bearoffcontext *pbc, const BgBoard * anBoard );
+bool isBearoff ( const bearoffcontext *pbc, const BgBoardView& anBoard );
 
 extern float
 fnd ( const float x, const float mu, const float sigma  );
@@ -203,26 +203,102 @@ FANN_EXTERNAL struct fann *FANN_API fann_create_standard_array(unsigned int num_
 
 FANN_EXTERNAL fann_type *FANN_API fann_run(struct fann * ann, const fann_type * input)
 {
-	struct fann_neuron *neuron_it, *last_neuron, *neurons;
-	unsigned int i, num_connections, num_input, num_output;
-	fann_type neuron_sum, *output;
-	fann_type *weights;
+	struct fann_context ctx;
+	fann_own_context(ann, &ctx);
+	return fann_run_context(ann, &ctx, input);
+}
+
+/* INTERNAL FUNCTION
+   The buffers of the network itself as a context; training reads the sums
+   and values of the last run from there.
+ */
+void fann_own_context(struct fann *ann, struct fann_context *ctx)
+{
+	ctx->total_neurons = ann->total_neurons;
+	ctx->num_output = ann->num_output;
+	ctx->sum = ann->first_layer->sum;
+	ctx->value = ann->first_layer->value;
+	ctx->output = ann->output;
+	ctx->batch = NULL;
+	ctx->batch_size = 0;
+	ctx->quant_values = NULL;
+	ctx->quant_sums = NULL;
+	ctx->quant_size = 0;
+}
+
+/* INTERNAL FUNCTION
+   The batch buffer of ctx for num_data inputs, NULL without memory.
+ */
+fann_type *fann_context_batch(struct fann_context *ctx, unsigned int num_data)
+{
+	if(num_data > ctx->batch_size)
+	{
+		fann_safe_free(ctx->batch);
+		ctx->batch_size = 0;
+		ctx->batch = (fann_type *) fann_malloc((size_t)num_data * ctx->total_neurons * sizeof(fann_type));
+		if(ctx->batch == NULL)
+			return NULL;
+		ctx->batch_size = num_data;
+	}
+	return ctx->batch;
+}
+
+FANN_EXTERNAL struct fann_context *FANN_API fann_create_context(const struct fann *ann)
+{
+	struct fann_context *ctx = (struct fann_context *) fann_calloc(1, sizeof(struct fann_context));
+	if(ctx == NULL)
+		return NULL;
+
+	ctx->total_neurons = ann->total_neurons;
+	ctx->num_output = ann->num_output;
+	/* aligned like the network's own buffers for the SSE and AVX runs */
+	ctx->sum = (fann_type *) fann_calloc(ann->total_neurons, sizeof(fann_type));
+	ctx->value = (fann_type *) fann_calloc(ann->total_neurons, sizeof(fann_type));
+	ctx->output = (fann_type *) fann_calloc(ann->num_output, sizeof(fann_type));
+	if(ctx->sum == NULL || ctx->value == NULL || ctx->output == NULL)
+	{
+		fann_destroy_context(ctx);
+		return NULL;
+	}
+	return ctx;
+}
+
+FANN_EXTERNAL void FANN_API fann_destroy_context(struct fann_context *ctx)
+{
+	if(ctx == NULL)
+		return;
+	fann_safe_free(ctx->sum);
+	fann_safe_free(ctx->value);
+	fann_safe_free(ctx->output);
+	fann_safe_free(ctx->batch);
+	fann_safe_free(ctx->quant_values);
+	fann_safe_free(ctx->quant_sums);
+	fann_free(ctx);
+}
+
+FANN_EXTERNAL fann_type *FANN_API fann_run_context(const struct fann * ann, struct fann_context * ctx, 
+	const fann_type * input)
+{
+	struct fann_neuron *neuron_it, *last_neuron;
+	unsigned int i, k, num_connections, num_input, num_output;
+	fann_type neuron_sum, *sums, *values;
+	const fann_type *weights, *prev_values;
 	struct fann_layer *layer_it, *last_layer;
 	unsigned int activation_function;
 	fann_type steepness;
 
 	/* store some variabels local for fast access */
-	struct fann_neuron *first_neuron = ann->first_layer->first_neuron;
+	const struct fann_neuron *first_neuron = ann->first_layer->first_neuron;
 	fann_type max_sum;	
 
 	/* first set the input */
 	num_input = ann->num_input;
 	for(i = 0; i != num_input; i++)
 	{
-		*first_neuron[i].valuePtr = input[i];
+		ctx->value[i] = input[i];
 	}
 	/* Set the bias neuron in the input layer */
-	*(ann->first_layer->last_neuron - 1)->valuePtr = 1;
+	ctx->value[ann->first_layer->last_neuron - 1 - first_neuron] = 1;
 
 	last_layer = ann->last_layer;
 	for(layer_it = ann->first_layer + 1; layer_it != last_layer; layer_it++)
@@ -230,13 +306,18 @@ FANN_EXTERNAL fann_type *FANN_API fann_run(struct fann * ann, const fann_type *
 		activation_function = layer_it->activation_function;
 		steepness = layer_it->activation_steepness;
 
+		/* the neurons of the layer and of the one before in the context */
+		sums = ctx->sum + (layer_it->first_neuron - first_neuron);
+		values = ctx->value + (layer_it->first_neuron - first_neuron);
+		prev_values = ctx->value + ((layer_it - 1)->first_neuron - first_neuron);
+
 		last_neuron = layer_it->last_neuron;
-		for(neuron_it = layer_it->first_neuron; neuron_it != last_neuron; neuron_it++)
+		for(neuron_it = layer_it->first_neuron, k = 0; neuron_it != last_neuron; neuron_it++, k++)
 		{
 			if(neuron_it->first_con == neuron_it->last_con)
 			{
 				/* bias neurons */
-				*neuron_it->valuePtr = 1;
+				values[k] = 1;
 				continue;
 			}
 
@@ -244,38 +325,29 @@ FANN_EXTERNAL fann_type *FANN_API fann_run(struct fann * ann, const fann_type *
 			num_connections = neuron_it->last_con - neuron_it->first_con;
 			weights = ann->weights + neuron_it->first_con;
 
-			neurons = (layer_it - 1)->first_neuron;
-
 			/* unrolled loop start */
 			i = num_connections & 3;	/* same as modulo 4 */
 			switch (i)
 			{
 				case 3:
-					neuron_sum += fann_mult(weights[2], *neurons[2].valuePtr);
+					neuron_sum += fann_mult(weights[2], prev_values[2]);
 				case 2:
-					neuron_sum += fann_mult(weights[1], *neurons[1].valuePtr);
+					neuron_sum += fann_mult(weights[1], prev_values[1]);
 				case 1:
-					neuron_sum += fann_mult(weights[0], *neurons[0].valuePtr);
+					neuron_sum += fann_mult(weights[0], prev_values[0]);
 				case 0:
 					break;
 			}
 			for(; i != num_connections; i += 4)
 			{
 				neuron_sum +=
-					fann_mult(weights[i], *neurons[i].valuePtr) +
-					fann_mult(weights[i + 1], *neurons[i + 1].valuePtr) +
-					fann_mult(weights[i + 2], *neurons[i + 2].valuePtr) +
-					fann_mult(weights[i + 3], *neurons[i + 3].valuePtr);
+					fann_mult(weights[i], prev_values[i]) +
+					fann_mult(weights[i + 1], prev_values[i + 1]) +
+					fann_mult(weights[i + 2], prev_values[i + 2]) +
+					fann_mult(weights[i + 3], prev_values[i + 3]);
 			}
 			/* unrolled loop end */
 
-			/*
-			 * for(i = 0;i != num_connections; i++){
-			 * printf("%f += %f*%f, ", neuron_sum, weights[i], neurons[i].value);
-			 * neuron_sum += fann_mult(weights[i], neurons[i].value);
-			 * }
-			 */
-
 			neuron_sum = fann_mult(steepness, neuron_sum);
 			
 			max_sum = 150/steepness;
@@ -284,21 +356,323 @@ FANN_EXTERNAL fann_type *FANN_API fann_run(struct fann * ann, const fann_type *
 			else if(neuron_sum < -max_sum)
 				neuron_sum = -max_sum;
 			
-			*neuron_it->sumPtr = neuron_sum;
+			sums[k] = neuron_sum;
 
-			fann_activation_switch(activation_function, neuron_sum, *neuron_it->valuePtr);
+			fann_activation_switch(activation_function, neuron_sum, values[k]);
 		}
 	}
 
 	/* set the output */
-	output = ann->output;
 	num_output = ann->num_output;
-	neurons = (ann->last_layer - 1)->first_neuron;
+	values = ctx->value + ((ann->last_layer - 1)->first_neuron - first_neuron);
 	for(i = 0; i != num_output; i++)
 	{
-		output[i] = *neurons[i].valuePtr;
+		ctx->output[i] = values[i];
+	}
+	return ctx->output;
+}
+
+FANN_EXTERNAL void FANN_API fann_run_batch(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type *input, unsigned int num_data, unsigned int input_stride, fann_type *output)
+{
+	unsigned int i;
+	for(i = 0; i != num_data; i++)
+	{
+		memcpy(output + i * ann->num_output, fann_run_context(ann, ctx, input + i * input_stride), 
+			ann->num_output * sizeof(fann_type));
+	}
+}
+
+/* the incremental run needs every input connected to every hidden neuron */
+static bool fann_incremental_ok(const struct fann * ann)
+{
+	const struct fann_neuron *neuron_it;
+	const unsigned int num_connections = (unsigned int)(ann->first_layer->last_neuron - ann->first_layer->first_neuron);
+
+	if(ann->last_layer - ann->first_layer != 3)
+		return false;
+
+	for(neuron_it = (ann->first_layer + 1)->first_neuron; neuron_it != (ann->first_layer + 1)->last_neuron - 1; neuron_it++)
+		if(neuron_it->last_con - neuron_it->first_con != num_connections)
+			return false;
+	return true;
+}
+
+FANN_EXTERNAL struct fann_incremental *FANN_API fann_create_incremental(const struct fann *ann)
+{
+	struct fann_incremental *inc = (struct fann_incremental *) fann_calloc(1, sizeof(struct fann_incremental));
+	if(inc == NULL)
+		return NULL;
+
+	inc->num_input = ann->num_input;
+	/* without the bias neuron */
+	inc->num_hidden = fann_incremental_ok(ann) ? 
+		(unsigned int)((ann->first_layer + 1)->last_neuron - (ann->first_layer + 1)->first_neuron) - 1 : 0;
+	inc->saved = 0;
+	inc->input = (fann_type *) fann_calloc(inc->num_input, sizeof(fann_type));
+	inc->diff = (fann_type *) fann_calloc(inc->num_input, sizeof(fann_type));
+	inc->changed = (unsigned int *) fann_calloc(inc->num_input, sizeof(unsigned int));
+	inc->sum = (fann_type *) fann_calloc(inc->num_hidden + 1, sizeof(fann_type));
+	inc->ctx = fann_create_context(ann);
+	if(inc->input == NULL || inc->diff == NULL || inc->changed == NULL || inc->sum == NULL || inc->ctx == NULL)
+	{
+		fann_destroy_incremental(inc);
+		return NULL;
 	}
-	return ann->output;
+	return inc;
+}
+
+FANN_EXTERNAL void FANN_API fann_destroy_incremental(struct fann_incremental *inc)
+{
+	if(inc == NULL)
+		return;
+	fann_safe_free(inc->input);
+	fann_safe_free(inc->diff);
+	fann_safe_free(inc->changed);
+	fann_safe_free(inc->sum);
+	fann_destroy_context(inc->ctx);
+	fann_free(inc);
+}
+
+/* steepness, the sum limits and the activation of the num_neurons sums of
+   the first layer after the input, in place in ctx */
+static void fann_activate_first(const struct fann * ann, struct fann_context * ctx, unsigned int num_neurons)
+{
+	const struct fann_layer *layer_it = ann->first_layer + 1;
+	const unsigned int activation_function = layer_it->activation_function;
+	const fann_type steepness = layer_it->activation_steepness;
+	const fann_type max_sum = 150/steepness;
+	const unsigned int offset = (unsigned int)(layer_it->first_neuron - ann->first_layer->first_neuron);
+	fann_type *sums = ctx->sum + offset, *values = ctx->value + offset;
+	fann_type neuron_sum;
+	unsigned int k;
+
+	for(k = 0; k != num_neurons; k++)
+	{
+		neuron_sum = fann_mult(steepness, sums[k]);
+		if(neuron_sum > max_sum)
+			neuron_sum = max_sum;
+		else if(neuron_sum < -max_sum)
+			neuron_sum = -max_sum;
+
+		sums[k] = neuron_sum;
+		fann_activation_switch(activation_function, neuron_sum, values[k]);
+	}
+	/* the bias neuron of the layer */
+	values[k] = 1;
+}
+
+/* the output layer as in fann_run, over the hidden values in ctx */
+static fann_type *fann_run_output_layer(const struct fann * ann, struct fann_context * ctx)
+{
+	const struct fann_neuron *neuron_it;
+	const struct fann_layer *layer_it = ann->first_layer + 2;
+	const struct fann_neuron *first_neuron = ann->first_layer->first_neuron;
+	const unsigned int activation_function = layer_it->activation_function;
+	const fann_type steepness = layer_it->activation_steepness;
+	const fann_type max_sum = 150/steepness;
+	const fann_type *prev_values = ctx->value + ((layer_it - 1)->first_neuron - first_neuron);
+	fann_type *sums = ctx->sum + (layer_it->first_neuron - first_neuron);
+	fann_type *values = ctx->value + (layer_it->first_neuron - first_neuron);
+	const fann_type *weights;
+	fann_type neuron_sum;
+	unsigned int i, k, num_connections;
+
+	for(neuron_it = layer_it->first_neuron, k = 0; neuron_it != layer_it->last_neuron; neuron_it++, k++)
+	{
+		if(neuron_it->first_con == neuron_it->last_con)
+		{
+			/* bias neurons */
+			values[k] = 1;
+			continue;
+		}
+
+		neuron_sum = 0;
+		num_connections = neuron_it->last_con - neuron_it->first_con;
+		weights = ann->weights + neuron_it->first_con;
+		for(i = 0; i != num_connections; i++)
+			neuron_sum += fann_mult(weights[i], prev_values[i]);
+
+		neuron_sum = fann_mult(steepness, neuron_sum);
+		if(neuron_sum > max_sum)
+			neuron_sum = max_sum;
+		else if(neuron_sum < -max_sum)
+			neuron_sum = -max_sum;
+
+		sums[k] = neuron_sum;
+		fann_activation_switch(activation_function, neuron_sum, values[k]);
+	}
+
+	for(i = 0; i != ann->num_output; i++)
+		ctx->output[i] = values[i];
+	return ctx->output;
+}
+
+FANN_EXTERNAL fann_type *FANN_API fann_run_incremental(const struct fann * ann, const fann_type * input, 
+	struct fann_incremental *inc)
+{
+	const struct fann_neuron *neuron_it, *last_neuron;
+	const struct fann_layer *layer_it;
+	unsigned int i, k, num_changed;
+	fann_type neuron_sum;
+	fann_type *sums;
+	const fann_type *weights;
+	struct fann_context *ctx = inc->ctx;
+	const struct fann_neuron *first_neuron = ann->first_layer->first_neuron;
+
+	if(!inc->num_hidden)
+		return fann_run_context(ann, ctx, input);
+
+	/* the hidden sums, from the inputs or from the saved base */
+	layer_it = ann->first_layer + 1;
+	last_neuron = layer_it->last_neuron - 1;
+	if(!inc->saved)
+	{
+		const unsigned int num_input = ann->num_input;
+		for(neuron_it = layer_it->first_neuron, k = 0; neuron_it != last_neuron; neuron_it++, k++)
+		{
+			weights = ann->weights + neuron_it->first_con;
+			/* the bias */
+			neuron_sum = weights[num_input];
+			for(i = 0; i != num_input; i++)
+				if(input[i] != 0)
+					neuron_sum += fann_mult(weights[i], input[i]);
+			inc->sum[k] = neuron_sum;
+		}
+		memcpy(inc->input, input, ann->num_input * sizeof(fann_type));
+		inc->saved = 1;
+	}
+
+	for(i = 0, num_changed = 0; i != ann->num_input; i++)
+		if(input[i] != inc->input[i])
+		{
+			inc->changed[num_changed] = i;
+			inc->diff[num_changed++] = input[i] - inc->input[i];
+		}
+
+	sums = ctx->sum + (layer_it->first_neuron - first_neuron);
+	for(neuron_it = layer_it->first_neuron, k = 0; neuron_it != last_neuron; neuron_it++, k++)
+	{
+		weights = ann->weights + neuron_it->first_con;
+		neuron_sum = inc->sum[k];
+		for(i = 0; i != num_changed; i++)
+			neuron_sum += fann_mult(weights[inc->changed[i]], inc->diff[i]);
+		sums[k] = neuron_sum;
+	}
+	fann_activate_first(ann, ctx, inc->num_hidden);
+
+	return fann_run_output_layer(ann, ctx);
+}
+
+/* the sparse run needs every input connected to every neuron of the first
+   layer after it, which may be the output layer */
+static bool fann_sparse_ok(const struct fann * ann)
+{
+	const struct fann_neuron *neuron_it;
+	const unsigned int num_connections = (unsigned int)(ann->first_layer->last_neuron - ann->first_layer->first_neuron);
+
+	if(ann->last_layer - ann->first_layer != 2 && ann->last_layer - ann->first_layer != 3)
+		return false;
+
+	for(neuron_it = (ann->first_layer + 1)->first_neuron; neuron_it != (ann->first_layer + 1)->last_neuron - 1; neuron_it++)
+		if(neuron_it->last_con - neuron_it->first_con != num_connections)
+			return false;
+	return true;
+}
+
+FANN_EXTERNAL struct fann_sparse *FANN_API fann_create_sparse(const struct fann *ann)
+{
+	struct fann_sparse *sparse = (struct fann_sparse *) fann_calloc(1, sizeof(struct fann_sparse));
+	if(sparse == NULL)
+		return NULL;
+
+	sparse->num_input = ann->num_input;
+	if(fann_sparse_ok(ann))
+	{
+		/* without the bias neuron */
+		sparse->num_neurons = 
+			(unsigned int)((ann->first_layer + 1)->last_neuron - (ann->first_layer + 1)->first_neuron) - 1;
+		/* whole 8 lane rows, the bias neuron and the padding stay 0 */
+		sparse->stride = (sparse->num_neurons + 1 + 7) & ~7u;
+		/* a row for every input and the bias row */
+		sparse->weights = (fann_type *) fann_calloc((size_t)(sparse->num_input + 1) * sparse->stride, 
+			sizeof(fann_type));
+		if(sparse->weights == NULL)
+		{
+			fann_destroy_sparse(sparse);
+			return NULL;
+		}
+		fann_update_sparse(ann, sparse);
+	}
+	return sparse;
+}
+
+FANN_EXTERNAL void FANN_API fann_update_sparse(const struct fann *ann, struct fann_sparse *sparse)
+{
+	const struct fann_neuron *neuron_it;
+	const fann_type *weights;
+	unsigned int i, k;
+
+	/* row i holds the weights of input i, in the order of the neurons */
+	neuron_it = (ann->first_layer + 1)->first_neuron;
+	for(k = 0; k != sparse->num_neurons; k++, neuron_it++)
+	{
+		weights = ann->weights + neuron_it->first_con;
+		for(i = 0; i <= sparse->num_input; i++)
+			sparse->weights[(size_t)i * sparse->stride + k] = weights[i];
+	}
+}
+
+FANN_EXTERNAL void FANN_API fann_destroy_sparse(struct fann_sparse *sparse)
+{
+	if(sparse == NULL)
+		return;
+	fann_safe_free(sparse->weights);
+	fann_free(sparse);
+}
+
+FANN_EXTERNAL fann_type *FANN_API fann_run_sparse(const struct fann *ann, const struct fann_sparse *sparse, 
+	struct fann_context *ctx, const unsigned int *index, const fann_type *value, unsigned int count)
+{
+	const fann_type *row;
+	fann_type *sums;
+	unsigned int i, k;
+
+	if(!sparse->num_neurons)
+	{
+		/* the dense inputs, in the input neurons the run copies them to */
+		for(i = 0; i != ann->num_input; i++)
+			ctx->value[i] = 0;
+		for(i = 0; i != count; i++)
+			ctx->value[index[i]] = value[i];
+		return fann_run_context(ann, ctx, ctx->value);
+	}
+
+	/* the bias row and then the rows of the non-zero inputs, 1s are added */
+	sums = ctx->sum + ((ann->first_layer + 1)->first_neuron - ann->first_layer->first_neuron);
+	row = sparse->weights + (size_t)sparse->num_input * sparse->stride;
+	for(k = 0; k != sparse->num_neurons; k++)
+		sums[k] = row[k];
+	for(i = 0; i != count; i++)
+	{
+		row = sparse->weights + (size_t)index[i] * sparse->stride;
+		if(value[i] == 1)
+			for(k = 0; k != sparse->num_neurons; k++)
+				sums[k] += row[k];
+		else
+			for(k = 0; k != sparse->num_neurons; k++)
+				sums[k] += fann_mult(row[k], value[i]);
+	}
+	fann_activate_first(ann, ctx, sparse->num_neurons);
+
+	if(ann->last_layer - ann->first_layer == 3)
+		return fann_run_output_layer(ann, ctx);
+
+	/* the first layer is the output layer */
+	sums = ctx->value + ((ann->first_layer + 1)->first_neuron - ann->first_layer->first_neuron);
+	for(i = 0; i != ann->num_output; i++)
+		ctx->output[i] = sums[i];
+	return ctx->output;
 }
 
 FANN_EXTERNAL void FANN_API fann_destroy(struct fann *ann)
@@ -714,6 +1088,7 @@ struct fann *fann_allocate_structure(unsigned int num_layers)
 
 	ann->can_use_sse = false;
 	ann->can_use_avx = false;
+	ann->isa = FANN_ISA_GENERIC;
 	
 	fann_init_error_data((struct fann_error *) ann);
 
@@ -92,85 +92,83 @@ float __inline __fastcall fann_hadd256_ps(const __m256& arg)
 	//return _mm_cvtss_f32(_mm_add_ss(_mm256_extractf128_ps(temp, 0), _mm256_extractf128_ps(temp,1)));
 }
 
-FANN_EXTERNAL fann_type *FANN_API fann_run_avx(struct fann * ann, const fann_type * input)
+void fann_activate_avx(const struct fann_layer *layer, fann_type *sums, fann_type *values, 
+	unsigned int num_neurons)
 {
-	unsigned int i, num_connections, num_input, num_output;
-	fann_type *output;
-	fann_type *weights;
-	struct fann_layer *layer_it, *last_layer;
+	fann_activationfunc_enum activation_function = layer->activation_function;
+	__m256 steepness_v = _mm256_set1_ps(layer->activation_steepness);
+	__m256 max_sum = _mm256_div_ps(pos_limit256.ps, steepness_v); // 150/steepness
+	__m256 min_sum = _mm256_div_ps(neg_limit256.ps, steepness_v); //-150/steepness
+	for(unsigned int k = 0; k < num_neurons; k += 8)
+	{
+		__m256 neuron_sum = _mm256_mul_ps(steepness_v, _mm256_load_ps(sums + k));
+		neuron_sum = _mm256_min_ps(max_sum, _mm256_max_ps(min_sum, neuron_sum));
 
-	/* store some variabels local for fast access */
-	struct fann_neuron *first_neuron = ann->first_layer->first_neuron;
+		_mm256_store_ps(sums + k, neuron_sum);
+		__m256 activationResult;
+		fann256_activation_switch_ps(activation_function, neuron_sum, activationResult);
+		_mm256_store_ps(values + k, activationResult);
+	}
+}
 
-	/* make crash if used improperly */
-	assert(ann->can_use_avx);
+FANN_EXTERNAL fann_type *FANN_API fann_run_avx(struct fann * ann, const fann_type * input)
+{
+	struct fann_context ctx;
+	fann_own_context(ann, &ctx);
+	return fann_run_avx_context(ann, &ctx, input);
+}
 
-	/* first set the input */
-	num_input = ann->num_input;
-	for(i = 0; i != num_input; i++)
+/* the sums of the num_neurons neurons of a layer over prev_values, 8 lanes
+   added up with fann_hadd256_ps */
+static void fann_layer_sums_avx(const fann_type *weights, const struct fann_neuron *neurons, 
+	unsigned int num_neurons, const fann_type *prev_values, fann_type *sums)
+{
+	unsigned int i, k, num_connections;
+	for(k = 0; k < num_neurons; k++)
 	{
-		*first_neuron[i].valuePtr = input[i];
+		const fann_neuron *neuron_it = neurons + k;
+		const fann_type *neuron_weights = weights + neuron_it->first_con;
+		num_connections = neuron_it->last_con - neuron_it->first_con;
+
+		__m256 neuron_sum_v = _mm256_setzero_ps();
+		for(i = 0; i < num_connections; i += 8)
+		{
+			__m256 weight_v = _mm256_load_ps(neuron_weights + i); 
+			__m256 value_v = _mm256_load_ps(prev_values + i);
+			neuron_sum_v = _mm256_add_ps(neuron_sum_v, _mm256_mul_ps(weight_v, value_v));
+		}
+	
+		sums[k] = fann_hadd256_ps(neuron_sum_v);
 	}
-	// Set the bias neuron in the input layer
-	*(ann->first_layer->last_neuron - 1)->valuePtr = 1;
+}
+
+/* the layers from first_run on, over the values of the layer before it in ctx */
+static fann_type *fann_run_from_avx(const struct fann * ann, struct fann_context * ctx, 
+	const struct fann_layer *first_run, fann_layer_sums_fn layer_sums)
+{
+	unsigned int i, k, num_output;
+	const fann_type *prev_values;
+	fann_type *sums, *values;
+	const struct fann_layer *layer_it, *last_layer;
+
+	/* store some variabels local for fast access */
+	const struct fann_neuron *first_neuron = ann->first_layer->first_neuron;
 	last_layer = ann->last_layer;
 
 	//hidden layers
-	for(layer_it = ann->first_layer + 1; layer_it != last_layer - 1; layer_it++)
+	for(layer_it = first_run; layer_it != last_layer - 1; layer_it++)
 	{
-		fann_activationfunc_enum activation_function = layer_it->activation_function;
-		fann_type steepness = layer_it->activation_steepness;
-		fann_neuron *last_neuron = layer_it->last_neuron;
-		fann_neuron *neurons = (layer_it - 1)->first_neuron;
+		const unsigned int num_neurons = (unsigned int)(layer_it->last_neuron - layer_it->first_neuron);
+		sums = ctx->sum + (layer_it->first_neuron - first_neuron);
+		values = ctx->value + (layer_it->first_neuron - first_neuron);
+		prev_values = ctx->value + ((layer_it - 1)->first_neuron - first_neuron);
 
-		for(fann_neuron *neuron_it = layer_it->first_neuron; neuron_it < last_neuron; neuron_it++)
-		{
-			num_connections = neuron_it->last_con - neuron_it->first_con;
-			weights = ann->weights + neuron_it->first_con;
-
-			__m256 neuron_sum_v = _mm256_setzero_ps(); /* sets it to {0, 0, 0, 0} vector */
-			
-			for(i = 0; i < num_connections; i += 8)
-			{
-				__m256 weight_v = _mm256_load_ps(weights + i); 
-				__m256 value_v = _mm256_load_ps(neurons[i].valuePtr);
-				neuron_sum_v = _mm256_add_ps(neuron_sum_v, _mm256_mul_ps(weight_v, value_v));
-				//neuron_sum +=
-				//	fann_mult(weights[i], *neurons[i].valuePtr) +
-				//	fann_mult(weights[i + 1], *neurons[i + 1].valuePtr) +
-				//	fann_mult(weights[i + 2], *neurons[i + 2].valuePtr) +
-				//	fann_mult(weights[i + 3], *neurons[i + 3].valuePtr);
-			}
-		
-			*neuron_it->sumPtr = fann_hadd256_ps(neuron_sum_v);
-			//neuron_sum = neuron_sum_v.m128_f32[0] + neuron_sum_v.m128_f32[1]
-			//	+ neuron_sum_v.m128_f32[2] + neuron_sum_v.m128_f32[3];
-		}
-
-		__m256 steepness_v = _mm256_set1_ps(steepness);
-		__m256 max_sum = _mm256_div_ps(pos_limit256.ps, steepness_v); // 150/steepness
-		__m256 min_sum = _mm256_div_ps(neg_limit256.ps, steepness_v); //-150/steepness
-		for(fann_neuron *neuron_it = layer_it->first_neuron; neuron_it < last_neuron; neuron_it += 8)
-		{
-			__m256 neuron_sum = _mm256_mul_ps(steepness_v, _mm256_load_ps(neuron_it->sumPtr));
-			neuron_sum = _mm256_min_ps(max_sum, _mm256_max_ps(min_sum, neuron_sum));
-			//if(neuron_sum > max_sum)
-			//	neuron_sum = max_sum;
-			//else if(neuron_sum < min_sum)
-			//	neuron_sum = min_sum;
-
-			_mm256_store_ps(neuron_it->sumPtr, neuron_sum);
-			//_mm256_stream_ps(neuron_it->sumPtr, neuron_sum);
-			//*neuron_it->sumPtr = neuron_sum;
-			__m256 activationResult;
-			fann256_activation_switch_ps(activation_function, neuron_sum, activationResult);
-			_mm256_store_ps(neuron_it->valuePtr, activationResult);
-			//fann_activation_switch(activation_function, neuron_sum, *neuron_it->valuePtr);
-		}
+		layer_sums(ann->weights, layer_it->first_neuron, num_neurons, prev_values, sums);
+		fann_activate_avx(layer_it, sums, values, num_neurons);
 
 		//bias
-		*(last_neuron-1)->sumPtr = 0;
-		*(last_neuron-1)->valuePtr = 1;
+		sums[num_neurons - 1] = 0;
+		values[num_neurons - 1] = 1;
 	}
 
 	//Output layer
@@ -178,32 +176,15 @@ FANN_EXTERNAL fann_type *FANN_API fann_run_avx(struct fann * ann, const fann_typ
 	{
 		fann_activationfunc_enum activation_function = layer_it->activation_function;
 		fann_type steepness = layer_it->activation_steepness;
-		fann_neuron *neurons = (layer_it - 1)->first_neuron;
-		fann_neuron *last_neuron = layer_it->last_neuron;
-		for(fann_neuron *neuron_it = layer_it->first_neuron; neuron_it != last_neuron; neuron_it++)
-		{
-			fann_type neuron_sum = 0;
-			num_connections = neuron_it->last_con - neuron_it->first_con;
-			weights = ann->weights + neuron_it->first_con;
-			__m256 neuron_sum_v = _mm256_setzero_ps(); /* sets it to {0, 0, 0, 0} vector */
-			
-			for(i = 0; i < num_connections; i += 8)
-			{
-				__m256 weight_v = _mm256_load_ps(weights + i); 
-				__m256 value_v = _mm256_load_ps(neurons[i].valuePtr);
-				neuron_sum_v = _mm256_add_ps(neuron_sum_v, _mm256_mul_ps(weight_v, value_v));
-				//neuron_sum +=
-				//	fann_mult(weights[i], *neurons[i].valuePtr) +
-				//	fann_mult(weights[i + 1], *neurons[i + 1].valuePtr) +
-				//	fann_mult(weights[i + 2], *neurons[i + 2].valuePtr) +
-				//	fann_mult(weights[i + 3], *neurons[i + 3].valuePtr);
-			}
-		
-			neuron_sum = fann_hadd256_ps(neuron_sum_v);
-			//neuron_sum = neuron_sum_v.m128_f32[0] + neuron_sum_v.m128_f32[1]
-			//	+ neuron_sum_v.m128_f32[2] + neuron_sum_v.m128_f32[3];
+		const unsigned int num_neurons = (unsigned int)(layer_it->last_neuron - layer_it->first_neuron);
+		sums = ctx->sum + (layer_it->first_neuron - first_neuron);
+		values = ctx->value + (layer_it->first_neuron - first_neuron);
+		prev_values = ctx->value + ((layer_it - 1)->first_neuron - first_neuron);
 
-			neuron_sum = steepness * neuron_sum;
+		layer_sums(ann->weights, layer_it->first_neuron, num_neurons, prev_values, sums);
+		for(k = 0; k < num_neurons; k++)
+		{
+			fann_type neuron_sum = steepness * sums[k];
 			
 			fann_type max_sum = 150/steepness;
 			if(neuron_sum > max_sum)
@@ -211,24 +192,276 @@ FANN_EXTERNAL fann_type *FANN_API fann_run_avx(struct fann * ann, const fann_typ
 			else if(neuron_sum < -max_sum)
 				neuron_sum = -max_sum;
 			
-			*neuron_it->sumPtr = neuron_sum;
-			fann_activation_switch(activation_function, neuron_sum, *neuron_it->valuePtr);
+			sums[k] = neuron_sum;
+			fann_activation_switch(activation_function, neuron_sum, values[k]);
 		}
 
 		//bias
-		*(last_neuron-1)->sumPtr = 0;
-		*(last_neuron-1)->valuePtr = 1;
+		sums[num_neurons - 1] = 0;
+		values[num_neurons - 1] = 1;
 	}
 
 	/* set the output */
-	output = ann->output;
 	num_output = ann->num_output;
-	fann_neuron *neurons = (ann->last_layer - 1)->first_neuron;
 	for(i = 0; i != num_output; i++)
 	{
-		output[i] = *neurons[i].valuePtr;
+		ctx->output[i] = values[i];
+	}
+	return ctx->output;
+}
+
+fann_type *fann_run_layers_avx(const struct fann * ann, struct fann_context * ctx, 
+	const fann_type * input, fann_layer_sums_fn layer_sums)
+{
+	unsigned int i, num_input;
+	const struct fann_neuron *first_neuron = ann->first_layer->first_neuron;
+
+	/* make crash if used improperly */
+	assert(ann->can_use_avx);
+	assert(fann_sse_aligned(ctx->sum) && fann_sse_aligned(ctx->value));
+
+	/* first set the input */
+	num_input = ann->num_input;
+	for(i = 0; i != num_input; i++)
+	{
+		ctx->value[i] = input[i];
+	}
+	// Set the bias neuron in the input layer
+	ctx->value[ann->first_layer->last_neuron - 1 - first_neuron] = 1;
+
+	return fann_run_from_avx(ann, ctx, ann->first_layer + 1, layer_sums);
+}
+
+FANN_EXTERNAL fann_type *FANN_API fann_run_avx_context(const struct fann * ann, struct fann_context * ctx, 
+	const fann_type * input)
+{
+	return fann_run_layers_avx(ann, ctx, input, fann_layer_sums_avx);
+}
+
+/* the hidden sums of fann_run_sparse 8 lanes at a time: a block of 32 sums
+   stays in 4 registers while the rows of all the inputs go by */
+#define FANN_SPARSE_BLOCK(VECTORS) \
+	{ \
+		__m256 acc_v[VECTORS]; \
+		for(v = 0; v < VECTORS; v++) \
+			acc_v[v] = _mm256_load_ps(bias + k + 8 * v); \
+		for(i = 0; i != count; i++) \
+		{ \
+			const fann_type *row = sparse->weights + (size_t)index[i] * sparse->stride + k; \
+			if(value[i] == 1) \
+				for(v = 0; v < VECTORS; v++) \
+					acc_v[v] = _mm256_add_ps(acc_v[v], _mm256_load_ps(row + 8 * v)); \
+			else \
+			{ \
+				const __m256 value_v = _mm256_set1_ps(value[i]); \
+				for(v = 0; v < VECTORS; v++) \
+					acc_v[v] = _mm256_add_ps(acc_v[v], _mm256_mul_ps(_mm256_load_ps(row + 8 * v), value_v)); \
+			} \
+		} \
+		for(v = 0; v < VECTORS; v++) \
+			_mm256_store_ps(sums + k + 8 * v, acc_v[v]); \
+	}
+
+FANN_EXTERNAL fann_type *FANN_API fann_run_sparse_avx(const struct fann *ann, const struct fann_sparse *sparse, 
+	struct fann_context *ctx, const unsigned int *index, const fann_type *value, unsigned int count)
+{
+	unsigned int i, k, v;
+	const struct fann_layer *hidden = ann->first_layer + 1;
+	const unsigned int num_neurons = (unsigned int)(hidden->last_neuron - hidden->first_neuron);
+	const fann_type *bias;
+	fann_type *sums, *values;
+
+	if(!sparse->num_neurons || !ann->can_use_avx || ann->last_layer - ann->first_layer != 3)
+		return fann_run_sparse(ann, sparse, ctx, index, value, count);
+
+	/* the rows are as wide as the hidden layer with its bias neuron */
+	assert(sparse->stride == num_neurons);
+	assert(fann_sse_aligned(ctx->sum) && fann_sse_aligned(ctx->value) && fann_sse_aligned(sparse->weights));
+
+	sums = ctx->sum + (hidden->first_neuron - ann->first_layer->first_neuron);
+	values = ctx->value + (hidden->first_neuron - ann->first_layer->first_neuron);
+	bias = sparse->weights + (size_t)sparse->num_input * sparse->stride;
+	for(k = 0; k + 32 <= num_neurons; k += 32)
+		FANN_SPARSE_BLOCK(4)
+	for(; k < num_neurons; k += 8)
+		FANN_SPARSE_BLOCK(1)
+
+	fann_activate_avx(hidden, sums, values, num_neurons);
+	//bias
+	sums[num_neurons - 1] = 0;
+	values[num_neurons - 1] = 1;
+
+	return fann_run_from_avx(ann, ctx, hidden + 1, fann_layer_sums_avx);
+}
+
+#undef FANN_SPARSE_BLOCK
+
+/* The batch kernel: a block of FANN_BATCH_NEURONS neurons stays in the cache
+   while all the inputs go by, and 4 inputs times 2 neurons share their
+   loads. Every sum adds up in the lanes and order of fann_run_avx, so the batch
+   gives its outputs bit for bit. */
+#define FANN_BATCH_NEURONS 16
+
+static void fann_batch_sums_avx(const fann_type *weights, const struct fann_neuron *neurons, 
+	unsigned int num_neurons, const fann_type *in, unsigned int in_width, fann_type *out, 
+	unsigned int out_width, unsigned int num_data)
+{
+	unsigned int jb, je, j, r, i;
+
+	for(jb = 0; jb < num_neurons; jb = je)
+	{
+		je = jb + FANN_BATCH_NEURONS < num_neurons ? jb + FANN_BATCH_NEURONS : num_neurons;
+		for(r = 0; r + 4 <= num_data; r += 4)
+		{
+			const fann_type *in0 = in + r * in_width, *in1 = in0 + in_width;
+			const fann_type *in2 = in1 + in_width, *in3 = in2 + in_width;
+			fann_type *out0 = out + r * out_width;
+			for(j = jb; j + 2 <= je; j += 2)
+			{
+				const fann_type *w0 = weights + neurons[j].first_con, *w1 = weights + neurons[j + 1].first_con;
+				__m256 s00 = _mm256_setzero_ps(), s01 = _mm256_setzero_ps(), s10 = _mm256_setzero_ps(), s11 = _mm256_setzero_ps();
+				__m256 s20 = _mm256_setzero_ps(), s21 = _mm256_setzero_ps(), s30 = _mm256_setzero_ps(), s31 = _mm256_setzero_ps();
+				for(i = 0; i < in_width; i += 8)
+				{
+					__m256 a0 = _mm256_load_ps(w0 + i), a1 = _mm256_load_ps(w1 + i), v;
+					v = _mm256_load_ps(in0 + i);
+					s00 = _mm256_add_ps(s00, _mm256_mul_ps(a0, v));
+					s01 = _mm256_add_ps(s01, _mm256_mul_ps(a1, v));
+					v = _mm256_load_ps(in1 + i);
+					s10 = _mm256_add_ps(s10, _mm256_mul_ps(a0, v));
+					s11 = _mm256_add_ps(s11, _mm256_mul_ps(a1, v));
+					v = _mm256_load_ps(in2 + i);
+					s20 = _mm256_add_ps(s20, _mm256_mul_ps(a0, v));
+					s21 = _mm256_add_ps(s21, _mm256_mul_ps(a1, v));
+					v = _mm256_load_ps(in3 + i);
+					s30 = _mm256_add_ps(s30, _mm256_mul_ps(a0, v));
+					s31 = _mm256_add_ps(s31, _mm256_mul_ps(a1, v));
+				}
+				out0[j] = fann_hadd256_ps(s00);
+				out0[j + 1] = fann_hadd256_ps(s01);
+				out0[out_width + j] = fann_hadd256_ps(s10);
+				out0[out_width + j + 1] = fann_hadd256_ps(s11);
+				out0[2 * out_width + j] = fann_hadd256_ps(s20);
+				out0[2 * out_width + j + 1] = fann_hadd256_ps(s21);
+				out0[3 * out_width + j] = fann_hadd256_ps(s30);
+				out0[3 * out_width + j + 1] = fann_hadd256_ps(s31);
+			}
+			for(; j < je; j++)
+			{
+				const fann_type *w0 = weights + neurons[j].first_con;
+				__m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps(), s2 = _mm256_setzero_ps(), s3 = _mm256_setzero_ps();
+				for(i = 0; i < in_width; i += 8)
+				{
+					__m256 a0 = _mm256_load_ps(w0 + i);
+					s0 = _mm256_add_ps(s0, _mm256_mul_ps(a0, _mm256_load_ps(in0 + i)));
+					s1 = _mm256_add_ps(s1, _mm256_mul_ps(a0, _mm256_load_ps(in1 + i)));
+					s2 = _mm256_add_ps(s2, _mm256_mul_ps(a0, _mm256_load_ps(in2 + i)));
+					s3 = _mm256_add_ps(s3, _mm256_mul_ps(a0, _mm256_load_ps(in3 + i)));
+				}
+				out0[j] = fann_hadd256_ps(s0);
+				out0[out_width + j] = fann_hadd256_ps(s1);
+				out0[2 * out_width + j] = fann_hadd256_ps(s2);
+				out0[3 * out_width + j] = fann_hadd256_ps(s3);
+			}
+		}
+		for(; r < num_data; r++)
+		{
+			const fann_type *in0 = in + r * in_width;
+			for(j = jb; j < je; j++)
+			{
+				const fann_type *w0 = weights + neurons[j].first_con;
+				__m256 s0 = _mm256_setzero_ps();
+				for(i = 0; i < in_width; i += 8)
+					s0 = _mm256_add_ps(s0, _mm256_mul_ps(_mm256_load_ps(w0 + i), _mm256_load_ps(in0 + i)));
+				out[r * out_width + j] = fann_hadd256_ps(s0);
+			}
+		}
 	}
-	return ann->output;
+}
+
+void fann_run_batch_layers_avx(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type *input, unsigned int num_data, unsigned int input_stride, fann_type *output, 
+	fann_batch_sums_fn batch_sums, fann_run_context_fn run_context)
+{
+	struct fann_layer *layer_it;
+	const struct fann_neuron *first_neuron = ann->first_layer->first_neuron;
+	const unsigned int num_output = ann->num_output;
+	fann_type *batch = fann_context_batch(ctx, num_data);
+	fann_type *values;
+	const fann_type *prev_values;
+	unsigned int j, r, width, prev_width;
+
+	/* make crash if used improperly */
+	assert(ann->can_use_avx);
+
+	if(batch == NULL)
+	{
+		/* without the memory for the batch one input after the other */
+		for(r = 0; r != num_data; r++)
+			memcpy(output + r * num_output, run_context(ann, ctx, input + r * input_stride), 
+				num_output * sizeof(fann_type));
+		return;
+	}
+
+	/* the input layer with its bias neuron, one row per input */
+	prev_width = (unsigned int)(ann->first_layer->last_neuron - ann->first_layer->first_neuron);
+	values = batch;
+	for(r = 0; r != num_data; r++)
+	{
+		memcpy(values + r * prev_width, input + r * input_stride, ann->num_input * sizeof(fann_type));
+		values[r * prev_width + prev_width - 1] = 1;
+	}
+	prev_values = values;
+
+	for(layer_it = ann->first_layer + 1; layer_it != ann->last_layer; layer_it++)
+	{
+		width = (unsigned int)(layer_it->last_neuron - layer_it->first_neuron);
+		values = batch + num_data * (unsigned int)(layer_it->first_neuron - first_neuron);
+
+		/* the sums of all the neurons but the bias one */
+		batch_sums(ann->weights, layer_it->first_neuron, width - 1, prev_values, prev_width, 
+			values, width, num_data);
+
+		if(layer_it != ann->last_layer - 1)
+		{
+			/* the activation as in the hidden layers of fann_run_avx */
+			for(r = 0; r != num_data; r++)
+			{
+				fann_type *row = values + r * width;
+				row[width - 1] = 0;
+				fann_activate_avx(layer_it, row, row, width);
+				//bias
+				row[width - 1] = 1;
+			}
+		}
+		else
+		{
+			/* the outputs as in fann_run_avx */
+			fann_activationfunc_enum activation_function = layer_it->activation_function;
+			fann_type steepness = layer_it->activation_steepness;
+			fann_type max_sum = 150/steepness;
+			for(r = 0; r != num_data; r++)
+				for(j = 0; j != num_output; j++)
+				{
+					fann_type neuron_sum = steepness * values[r * width + j];
+					if(neuron_sum > max_sum)
+						neuron_sum = max_sum;
+					else if(neuron_sum < -max_sum)
+						neuron_sum = -max_sum;
+					fann_activation_switch(activation_function, neuron_sum, output[r * num_output + j]);
+				}
+		}
+
+		prev_values = values;
+		prev_width = width;
+	}
+}
+
+FANN_EXTERNAL void FANN_API fann_run_batch_avx(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type *input, unsigned int num_data, unsigned int input_stride, fann_type *output)
+{
+	fann_run_batch_layers_avx(ann, ctx, input, num_data, input_stride, output, 
+		fann_batch_sums_avx, fann_run_avx_context);
 }
 
 static const union PS_vec 
@@ -0,0 +1,264 @@
+/*
+Fast Artificial Neural Network Library (fann)
+Copyright (C) 2003 Steffen Nissen (lukesky@diku.dk)
+Copyright (C) 2011 Alex Koshterek (koshterek@gmail.com)
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/  
+
+
+#include <assert.h>
+#include "fann_cpu.h"
+#include "fann_sse.h"
+#include "fann_avx.h"
+#include "fann_fma.h"
+#include "fann_avx512.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+static void fann_cpuid(int info[4], int leaf)
+{
+#ifdef _MSC_VER
+	__cpuidex(info, leaf, 0);
+#else
+	__cpuid_count(leaf, 0, info[0], info[1], info[2], info[3]);
+#endif
+}
+
+/* the register state the operating system saves on a task switch */
+static unsigned long long fann_xgetbv(void)
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	unsigned int eax, edx;
+	__asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+
+/* a bit 1 << isa for every instruction set of the CPU and the build */
+static unsigned int fann_detect_isas(void)
+{
+	int info[4];
+	unsigned int isas = 1 << FANN_ISA_GENERIC;
+
+	fann_cpuid(info, 0);
+	const int max_leaf = info[0];
+	fann_cpuid(info, 1);
+	const bool sse41 = (info[2] & (1 << 19)) != 0;
+	const bool fma = (info[2] & (1 << 12)) != 0;
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+	bool avx2 = false, avx512f = false;
+	if(max_leaf >= 7)
+	{
+		fann_cpuid(info, 7);
+		avx2 = (info[1] & (1 << 5)) != 0;
+		avx512f = (info[1] & (1 << 16)) != 0;
+	}
+	/* XMM and YMM, then the opmask and ZMM registers */
+	const unsigned long long xcr0 = osxsave ? fann_xgetbv() : 0;
+	const bool ymm = (xcr0 & 0x06) == 0x06, zmm = (xcr0 & 0xe6) == 0xe6;
+
+#if defined FANN_USE_SSE
+	if(sse41)
+		isas |= 1 << FANN_ISA_SSE;
+#endif
+#if defined FANN_USE_AVX
+	if(avx && ymm)
+		isas |= 1 << FANN_ISA_AVX;
+#endif
+#if defined FANN_USE_AVX && defined FANN_USE_FMA
+	if(avx && ymm && avx2 && fma)
+		isas |= 1 << FANN_ISA_FMA;
+#endif
+#if defined FANN_USE_AVX && defined FANN_USE_AVX512
+	if(avx && ymm && avx512f && zmm)
+		isas |= 1 << FANN_ISA_AVX512;
+#endif
+	return isas;
+}
+
+static unsigned int fann_cpu_isas(void)
+{
+	/* every thread finds the same, a race only repeats the question */
+	static unsigned int isas = 0;
+	if(!isas)
+		isas = fann_detect_isas();
+	return isas;
+}
+
+FANN_EXTERNAL enum fann_isa_enum FANN_API fann_cpu_isa(void)
+{
+	const unsigned int isas = fann_cpu_isas();
+	int isa = FANN_ISA_AVX512;
+	while(!(isas & (1 << isa)))
+		isa--;
+	return (enum fann_isa_enum)isa;
+}
+
+FANN_EXTERNAL int FANN_API fann_cpu_has_isa(enum fann_isa_enum isa)
+{
+	return (fann_cpu_isas() & (1 << isa)) != 0;
+}
+
+static enum fann_isa_enum fann_isa_limit = FANN_ISA_AVX512;
+
+FANN_EXTERNAL void FANN_API fann_set_isa_limit(enum fann_isa_enum isa)
+{
+	fann_isa_limit = isa;
+}
+
+FANN_EXTERNAL enum fann_isa_enum FANN_API fann_get_isa_limit(void)
+{
+	return fann_isa_limit;
+}
+
+/* the fastest of the instruction sets up to isa the CPU and the network take */
+static enum fann_isa_enum fann_allowed_isa(const struct fann *ann, enum fann_isa_enum isa)
+{
+	const unsigned int isas = fann_cpu_isas();
+	int i = isa > FANN_ISA_AVX512 ? FANN_ISA_AVX512 : isa;
+	for(; i > FANN_ISA_GENERIC; i--)
+	{
+		if(!(isas & (1 << i)))
+			continue;
+		/* FMA and AVX-512 take the networks of AVX */
+		if(i >= FANN_ISA_AVX ? ann->can_use_avx : ann->can_use_sse)
+			break;
+	}
+	return (enum fann_isa_enum)i;
+}
+
+FANN_EXTERNAL enum fann_isa_enum FANN_API fann_select_isa(struct fann *ann)
+{
+	if(ann == NULL)
+		return FANN_ISA_GENERIC;
+
+	fann_can_use_sse(ann);
+	fann_can_use_avx(ann);
+	ann->isa = fann_allowed_isa(ann, fann_isa_limit);
+	return ann->isa;
+}
+
+FANN_EXTERNAL enum fann_isa_enum FANN_API fann_set_isa(struct fann *ann, enum fann_isa_enum isa)
+{
+	if(ann == NULL)
+		return FANN_ISA_GENERIC;
+
+	ann->isa = fann_allowed_isa(ann, isa);
+	return ann->isa;
+}
+
+FANN_EXTERNAL fann_type *FANN_API fann_run_dispatch(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type * input)
+{
+	switch(ann->isa)
+	{
+#if defined FLOATFANN && defined FANN_USE_AVX && defined FANN_USE_AVX512
+	case FANN_ISA_AVX512:
+		return fann_run_avx512_context(ann, ctx, input);
+#endif
+#if defined FLOATFANN && defined FANN_USE_AVX && defined FANN_USE_FMA
+	case FANN_ISA_FMA:
+		return fann_run_fma_context(ann, ctx, input);
+#endif
+#if defined FLOATFANN && defined FANN_USE_AVX
+	case FANN_ISA_AVX:
+		return fann_run_avx_context(ann, ctx, input);
+#endif
+#if defined FLOATFANN && defined FANN_USE_SSE
+	case FANN_ISA_SSE:
+		return fann_run_sse_context(ann, ctx, input);
+#endif
+	default:
+		return fann_run_context(ann, ctx, input);
+	}
+}
+
+FANN_EXTERNAL void FANN_API fann_run_batch_dispatch(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type *input, unsigned int num_data, unsigned int input_stride, fann_type *output)
+{
+	switch(ann->isa)
+	{
+#if defined FLOATFANN && defined FANN_USE_AVX && defined FANN_USE_AVX512
+	case FANN_ISA_AVX512:
+		fann_run_batch_avx512(ann, ctx, input, num_data, input_stride, output);
+		break;
+#endif
+#if defined FLOATFANN && defined FANN_USE_AVX && defined FANN_USE_FMA
+	case FANN_ISA_FMA:
+		fann_run_batch_fma(ann, ctx, input, num_data, input_stride, output);
+		break;
+#endif
+#if defined FLOATFANN && defined FANN_USE_AVX
+	case FANN_ISA_AVX:
+		fann_run_batch_avx(ann, ctx, input, num_data, input_stride, output);
+		break;
+#endif
+#if defined FLOATFANN && defined FANN_USE_SSE
+	case FANN_ISA_SSE:
+		fann_run_batch_sse(ann, ctx, input, num_data, input_stride, output);
+		break;
+#endif
+	default:
+		fann_run_batch(ann, ctx, input, num_data, input_stride, output);
+	}
+}
+
+FANN_EXTERNAL fann_type *FANN_API fann_run_sparse_dispatch(const struct fann *ann, 
+	const struct fann_sparse *sparse, struct fann_context *ctx, const unsigned int *index, 
+	const fann_type *value, unsigned int count)
+{
+#if defined FLOATFANN && defined FANN_USE_AVX
+	if(ann->isa >= FANN_ISA_AVX)
+		return fann_run_sparse_avx(ann, sparse, ctx, index, value, count);
+#endif
+	return fann_run_sparse(ann, sparse, ctx, index, value, count);
+}
+
+FANN_EXTERNAL void FANN_API fann_train_dispatch(struct fann *ann, const fann_type * input, 
+	const fann_type * desired_output)
+{
+	switch(ann->isa)
+	{
+#if defined FLOATFANN && defined FANN_USE_AVX && defined FANN_USE_AVX512
+	case FANN_ISA_AVX512:
+		fann_train_avx512(ann, input, desired_output);
+		break;
+#endif
+#if defined FLOATFANN && defined FANN_USE_AVX && defined FANN_USE_FMA
+	case FANN_ISA_FMA:
+		fann_train_fma(ann, input, desired_output);
+		break;
+#endif
+#if defined FANN_USE_AVX
+	case FANN_ISA_AVX:
+		fann_train_avx(ann, input, desired_output);
+		break;
+#endif
+#if defined FANN_USE_SSE
+	case FANN_ISA_SSE:
+		fann_train_sse(ann, input, desired_output);
+		break;
+#endif
+	default:
+		fann_train(ann, input, desired_output);
+	}
+}
@@ -0,0 +1,176 @@
+/*
+Fast Artificial Neural Network Library (fann)
+Copyright (C) 2003 Steffen Nissen (lukesky@diku.dk)
+Copyright (C) 2011 Alex Koshterek (koshterek@gmail.com)
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/  
+
+#include <assert.h>
+#include "fann_fma.h"
+#include "fann_avx.h"
+#include <intrin.h>
+#include <immintrin.h>
+
+#if defined FLOATFANN && defined FANN_USE_AVX && defined FANN_USE_FMA
+
+/* the lanes added up as fann_run_avx does */
+static __inline float __fastcall fann_hadd256_ps(const __m256& arg)
+{
+	__m256 temp = _mm256_add_ps(arg, _mm256_permute_ps(arg, 0xee));
+	temp = _mm256_add_ps(temp, _mm256_movehdup_ps(temp));
+	return _mm_cvtss_f32(_mm_add_ss(_mm256_castps256_ps128(temp), _mm256_extractf128_ps(temp,1)));
+}
+
+/* the sums of the num_neurons neurons of a layer over prev_values with
+   8 wide fused multiply adds */
+static void fann_layer_sums_fma(const fann_type *weights, const struct fann_neuron *neurons, 
+	unsigned int num_neurons, const fann_type *prev_values, fann_type *sums)
+{
+	unsigned int i, k, num_connections;
+	for(k = 0; k < num_neurons; k++)
+	{
+		const fann_neuron *neuron_it = neurons + k;
+		const fann_type *neuron_weights = weights + neuron_it->first_con;
+		num_connections = neuron_it->last_con - neuron_it->first_con;
+
+		__m256 neuron_sum_v = _mm256_setzero_ps();
+		for(i = 0; i < num_connections; i += 8)
+		{
+			neuron_sum_v = _mm256_fmadd_ps(_mm256_load_ps(neuron_weights + i), 
+				_mm256_load_ps(prev_values + i), neuron_sum_v);
+		}
+	
+		sums[k] = fann_hadd256_ps(neuron_sum_v);
+	}
+}
+
+/* The batch kernel of fann_run_batch_avx: a block of FANN_BATCH_NEURONS
+   neurons stays in the cache while all the inputs go by, and 4 inputs times
+   2 neurons share their loads. The sums add up as in fann_layer_sums_fma. */
+#define FANN_BATCH_NEURONS 16
+
+static void fann_batch_sums_fma(const fann_type *weights, const struct fann_neuron *neurons, 
+	unsigned int num_neurons, const fann_type *in, unsigned int in_width, fann_type *out, 
+	unsigned int out_width, unsigned int num_data)
+{
+	unsigned int jb, je, j, r, i;
+
+	for(jb = 0; jb < num_neurons; jb = je)
+	{
+		je = jb + FANN_BATCH_NEURONS < num_neurons ? jb + FANN_BATCH_NEURONS : num_neurons;
+		for(r = 0; r + 4 <= num_data; r += 4)
+		{
+			const fann_type *in0 = in + r * in_width, *in1 = in0 + in_width;
+			const fann_type *in2 = in1 + in_width, *in3 = in2 + in_width;
+			fann_type *out0 = out + r * out_width;
+			for(j = jb; j + 2 <= je; j += 2)
+			{
+				const fann_type *w0 = weights + neurons[j].first_con, *w1 = weights + neurons[j + 1].first_con;
+				__m256 s00 = _mm256_setzero_ps(), s01 = _mm256_setzero_ps(), s10 = _mm256_setzero_ps(), s11 = _mm256_setzero_ps();
+				__m256 s20 = _mm256_setzero_ps(), s21 = _mm256_setzero_ps(), s30 = _mm256_setzero_ps(), s31 = _mm256_setzero_ps();
+				for(i = 0; i < in_width; i += 8)
+				{
+					
+					__m256 a0 = _mm256_load_ps(w0 + i), a1 = _mm256_load_ps(w1 + i), v;
+					v = _mm256_load_ps(in0 + i);
+					s00 = _mm256_fmadd_ps(a0, v, s00);
+					s01 = _mm256_fmadd_ps(a1, v, s01);
+					v = _mm256_load_ps(in1 + i);
+					s10 = _mm256_fmadd_ps(a0, v, s10);
+					s11 = _mm256_fmadd_ps(a1, v, s11);
+					v = _mm256_load_ps(in2 + i);
+					s20 = _mm256_fmadd_ps(a0, v, s20);
+					s21 = _mm256_fmadd_ps(a1, v, s21);
+					v = _mm256_load_ps(in3 + i);
+					s30 = _mm256_fmadd_ps(a0, v, s30);
+					s31 = _mm256_fmadd_ps(a1, v, s31);
+				}
+				out0[j] = fann_hadd256_ps(s00);
+				out0[j + 1] = fann_hadd256_ps(s01);
+				out0[out_width + j] = fann_hadd256_ps(s10);
+				out0[out_width + j + 1] = fann_hadd256_ps(s11);
+				out0[2 * out_width + j] = fann_hadd256_ps(s20);
+				out0[2 * out_width + j + 1] = fann_hadd256_ps(s21);
+				out0[3 * out_width + j] = fann_hadd256_ps(s30);
+				out0[3 * out_width + j + 1] = fann_hadd256_ps(s31);
+			}
+			for(; j < je; j++)
+			{
+				const fann_type *w0 = weights + neurons[j].first_con;
+				__m256 s0 = _mm256_setzero_ps(), s1 = _mm256_setzero_ps(), s2 = _mm256_setzero_ps(), s3 = _mm256_setzero_ps();
+				for(i = 0; i < in_width; i += 8)
+				{
+					
+					__m256 a0 = _mm256_load_ps(w0 + i);
+					s0 = _mm256_fmadd_ps(a0, _mm256_load_ps(in0 + i), s0);
+					s1 = _mm256_fmadd_ps(a0, _mm256_load_ps(in1 + i), s1);
+					s2 = _mm256_fmadd_ps(a0, _mm256_load_ps(in2 + i), s2);
+					s3 = _mm256_fmadd_ps(a0, _mm256_load_ps(in3 + i), s3);
+				}
+				out0[j] = fann_hadd256_ps(s0);
+				out0[out_width + j] = fann_hadd256_ps(s1);
+				out0[2 * out_width + j] = fann_hadd256_ps(s2);
+				out0[3 * out_width + j] = fann_hadd256_ps(s3);
+			}
+		}
+		for(; r < num_data; r++)
+		{
+			const fann_type *in0 = in + r * in_width;
+			for(j = jb; j < je; j++)
+			{
+				const fann_type *w0 = weights + neurons[j].first_con;
+				__m256 s0 = _mm256_setzero_ps();
+				for(i = 0; i < in_width; i += 8)
+				{
+					
+					s0 = _mm256_fmadd_ps(_mm256_load_ps(w0 + i), _mm256_load_ps(in0 + i), s0);
+				}
+				out[r * out_width + j] = fann_hadd256_ps(s0);
+			}
+		}
+	}
+}
+
+FANN_EXTERNAL fann_type *FANN_API fann_run_fma_context(const struct fann * ann, struct fann_context * ctx, 
+	const fann_type * input)
+{
+	return fann_run_layers_avx(ann, ctx, input, fann_layer_sums_fma);
+}
+
+FANN_EXTERNAL fann_type *FANN_API fann_run_fma(struct fann * ann, const fann_type * input)
+{
+	struct fann_context ctx;
+	fann_own_context(ann, &ctx);
+	return fann_run_fma_context(ann, &ctx, input);
+}
+
+FANN_EXTERNAL void FANN_API fann_run_batch_fma(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type *input, unsigned int num_data, unsigned int input_stride, fann_type *output)
+{
+	fann_run_batch_layers_avx(ann, ctx, input, num_data, input_stride, output, 
+		fann_batch_sums_fma, fann_run_fma_context);
+}
+
+//the backward pass is the one of AVX, its multiplies and adds stay apart
+FANN_EXTERNAL void FANN_API fann_train_fma(struct fann *ann, const fann_type * input, const fann_type * desired_output)
+{
+	fann_run_fma(ann, input);
+	fann_compute_MSE(ann, desired_output);
+	fann_backpropagate_MSE_avx(ann);
+	fann_update_weights_avx(ann);
+}
+
+#endif
@@ -0,0 +1,487 @@
+/*
+Fast Artificial Neural Network Library (fann)
+Copyright (C) 2003 Steffen Nissen (lukesky@diku.dk)
+Copyright (C) 2011 Alex Koshterek (koshterek@gmail.com)
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <math.h>
+#include <assert.h>
+#include "fann_quant.h"
+#include "fann_cpu.h"
+#include <intrin.h>
+#include <immintrin.h>
+
+#if defined FLOATFANN
+
+static int fann_quant_round(fann_type value)
+{
+	return (int)(value >= 0 ? value + 0.5f : value - 0.5f);
+}
+
+FANN_EXTERNAL fann_type FANN_API fann_quant_matrix(const fann_type *weights, unsigned int num_rows,
+	unsigned int num_cols, unsigned int row_step, unsigned int col_step, unsigned int weight_bits,
+	void *out, unsigned int out_cols)
+{
+	const double max_quant = weight_bits == 8 ? 127.0 : 32767.0;
+	double max_weight = 0, max_row = 0, scale;
+	unsigned int r, c;
+
+	for(r = 0; r != num_rows; r++)
+	{
+		double row = 0;
+		for(c = 0; c != num_cols; c++)
+		{
+			const double weight = fabs(weights[r * row_step + c * col_step]);
+			row += weight;
+			if(weight > max_weight)
+				max_weight = weight;
+		}
+		if(row > max_row)
+			max_row = row;
+	}
+
+	scale = max_weight > 0 ? max_quant / max_weight : 1;
+	/* the sum of a row times the largest value, with half a unit of
+	   rounding per weight, stays below 2^31 */
+	if((max_row * scale + num_cols * 0.5) * FANN_QUANT_RANGE > 2147483647.0)
+		scale = (2147483647.0 / FANN_QUANT_RANGE - num_cols * 0.5) / max_row;
+
+	for(r = 0; r != num_rows; r++)
+		for(c = 0; c != out_cols; c++)
+		{
+			const int quant = c < num_cols ?
+				fann_quant_round((fann_type)(weights[r * row_step + c * col_step] * scale)) : 0;
+			if(weight_bits == 8)
+				((signed char *)out)[(size_t)r * out_cols + c] = (signed char)quant;
+			else
+				((short *)out)[(size_t)r * out_cols + c] = (short)quant;
+		}
+	return (fann_type)scale;
+}
+
+static void fann_quant_values_generic(const fann_type *values, unsigned int count,
+	unsigned int padded, fann_type scale, short *out)
+{
+	unsigned int i;
+	for(i = 0; i != count; i++)
+	{
+		fann_type value = values[i] * scale;
+		if(value > FANN_QUANT_RANGE)
+			value = FANN_QUANT_RANGE;
+		else if(value < -FANN_QUANT_RANGE)
+			value = -FANN_QUANT_RANGE;
+		out[i] = (short)fann_quant_round(value);
+	}
+	for(; i < padded; i++)
+		out[i] = 0;
+}
+
+#if defined FANN_USE_AVX && defined FANN_USE_FMA
+/* the operations of fann_quant_values_generic 16 values at a time */
+static void fann_quant_values_avx2(const fann_type *values, unsigned int count,
+	unsigned int padded, fann_type scale, short *out)
+{
+	const __m256 scale_v = _mm256_set1_ps(scale), half_v = _mm256_set1_ps(0.5f), sign_v = _mm256_set1_ps(-0.0f);
+	const __m256 max_v = _mm256_set1_ps(FANN_QUANT_RANGE), min_v = _mm256_set1_ps(-FANN_QUANT_RANGE);
+	unsigned int i;
+	for(i = 0; i + 16 <= count; i += 16)
+	{
+		__m256 value0 = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(values + i), scale_v), min_v), max_v);
+		__m256 value1 = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(values + i + 8), scale_v), min_v), max_v);
+		value0 = _mm256_add_ps(value0, _mm256_or_ps(_mm256_and_ps(value0, sign_v), half_v));
+		value1 = _mm256_add_ps(value1, _mm256_or_ps(_mm256_and_ps(value1, sign_v), half_v));
+		/* the pack works within the halves */
+		const __m256i quant = _mm256_packs_epi32(_mm256_cvttps_epi32(value0), _mm256_cvttps_epi32(value1));
+		_mm256_storeu_si256((__m256i *)(out + i), _mm256_permute4x64_epi64(quant, 0xD8));
+	}
+	fann_quant_values_generic(values + i, count - i, padded - i, scale, out + i);
+}
+#endif
+
+FANN_EXTERNAL void FANN_API fann_quant_values(enum fann_isa_enum isa, const fann_type *values,
+	unsigned int count, unsigned int padded, fann_type scale, short *out)
+{
+#if defined FANN_USE_AVX && defined FANN_USE_FMA
+	if(isa >= FANN_ISA_FMA)
+	{
+		fann_quant_values_avx2(values, count, padded, scale, out);
+		return;
+	}
+#endif
+	fann_quant_values_generic(values, count, padded, scale, out);
+}
+
+FANN_EXTERNAL enum fann_isa_enum FANN_API fann_quant_isa(void)
+{
+#if defined FANN_USE_AVX && defined FANN_USE_FMA
+	if(fann_get_isa_limit() >= FANN_ISA_FMA && fann_cpu_has_isa(FANN_ISA_FMA))
+		return FANN_ISA_FMA;
+#endif
+	return FANN_ISA_GENERIC;
+}
+
+static void fann_quant_dot_generic(unsigned int weight_bits, const void *weights, unsigned int num_rows,
+	unsigned int num_cols, const short *values, int *sums)
+{
+	unsigned int r, c;
+	for(r = 0; r != num_rows; r++)
+	{
+		int sum = 0;
+		if(weight_bits == 8)
+		{
+			const signed char *row = (const signed char *)weights + (size_t)r * num_cols;
+			for(c = 0; c != num_cols; c++)
+				sum += row[c] * values[c];
+		}
+		else
+		{
+			const short *row = (const short *)weights + (size_t)r * num_cols;
+			for(c = 0; c != num_cols; c++)
+				sum += row[c] * values[c];
+		}
+		sums[r] = sum;
+	}
+}
+
+#if defined FANN_USE_AVX && defined FANN_USE_FMA
+/* 16 weights as 16 bit integers */
+template<unsigned int BITS>
+static __inline __m256i fann_quant_load_avx2(const void *weights, size_t at)
+{
+	if(BITS == 8)
+		return _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)((const signed char *)weights + at)));
+	return _mm256_loadu_si256((const __m256i *)((const short *)weights + at));
+}
+
+/* pmaddwd adds the products of neighbouring pairs into 8 lanes of 32 bits;
+   4 rows share the loads of the values */
+template<unsigned int BITS>
+static void fann_quant_dot_avx2(const void *weights, unsigned int num_rows, unsigned int num_cols,
+	const short *values, int *sums)
+{
+	unsigned int r = 0, c;
+	for(; r + 4 <= num_rows; r += 4)
+	{
+		__m256i sum0 = _mm256_setzero_si256(), sum1 = _mm256_setzero_si256();
+		__m256i sum2 = _mm256_setzero_si256(), sum3 = _mm256_setzero_si256();
+		for(c = 0; c < num_cols; c += 16)
+		{
+			const __m256i value_v = _mm256_loadu_si256((const __m256i *)(values + c));
+			/* most of the inputs of a board are zeros */
+			if(_mm256_testz_si256(value_v, value_v))
+				continue;
+			const size_t at = (size_t)r * num_cols + c;
+			sum0 = _mm256_add_epi32(sum0, _mm256_madd_epi16(fann_quant_load_avx2<BITS>(weights, at), value_v));
+			sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(fann_quant_load_avx2<BITS>(weights, at + num_cols), value_v));
+			sum2 = _mm256_add_epi32(sum2, _mm256_madd_epi16(fann_quant_load_avx2<BITS>(weights, at + 2 * num_cols), value_v));
+			sum3 = _mm256_add_epi32(sum3, _mm256_madd_epi16(fann_quant_load_avx2<BITS>(weights, at + 3 * num_cols), value_v));
+		}
+		/* the lanes of each row added up, the 4 rows side by side */
+		const __m256i sum = _mm256_hadd_epi32(_mm256_hadd_epi32(sum0, sum1), _mm256_hadd_epi32(sum2, sum3));
+		_mm_storeu_si128((__m128i *)(sums + r),
+			_mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1)));
+	}
+	for(; r < num_rows; r++)
+	{
+		__m256i sum_v = _mm256_setzero_si256();
+		for(c = 0; c < num_cols; c += 16)
+			sum_v = _mm256_add_epi32(sum_v, _mm256_madd_epi16(
+				fann_quant_load_avx2<BITS>(weights, (size_t)r * num_cols + c),
+				_mm256_loadu_si256((const __m256i *)(values + c))));
+		__m128i sum = _mm_add_epi32(_mm256_castsi256_si128(sum_v), _mm256_extracti128_si256(sum_v, 1));
+		sum = _mm_hadd_epi32(sum, sum);
+		sum = _mm_hadd_epi32(sum, sum);
+		sums[r] = _mm_cvtsi128_si32(sum);
+	}
+}
+#endif
+
+#if defined FANN_USE_AVX && defined FANN_USE_FMA
+/* 4 rows of values against one row of weights at a time */
+template<unsigned int BITS>
+static void fann_quant_dot_batch_avx2(const void *weights, unsigned int num_rows, unsigned int num_cols,
+	const short *values, unsigned int values_stride, unsigned int num_data, int *sums)
+{
+	unsigned int d = 0, r, c;
+	for(; d + 4 <= num_data; d += 4)
+	{
+		const short *values0 = values + (size_t)d * values_stride, *values1 = values0 + values_stride;
+		const short *values2 = values1 + values_stride, *values3 = values2 + values_stride;
+		int *sums0 = sums + (size_t)d * num_rows;
+		for(r = 0; r != num_rows; r++)
+		{
+			__m256i sum0 = _mm256_setzero_si256(), sum1 = _mm256_setzero_si256();
+			__m256i sum2 = _mm256_setzero_si256(), sum3 = _mm256_setzero_si256();
+			for(c = 0; c < num_cols; c += 16)
+			{
+				const __m256i value0 = _mm256_loadu_si256((const __m256i *)(values0 + c));
+				const __m256i value1 = _mm256_loadu_si256((const __m256i *)(values1 + c));
+				const __m256i value2 = _mm256_loadu_si256((const __m256i *)(values2 + c));
+				const __m256i value3 = _mm256_loadu_si256((const __m256i *)(values3 + c));
+				const __m256i any_v = _mm256_or_si256(_mm256_or_si256(value0, value1), _mm256_or_si256(value2, value3));
+				if(_mm256_testz_si256(any_v, any_v))
+					continue;
+				const __m256i weight_v = fann_quant_load_avx2<BITS>(weights, (size_t)r * num_cols + c);
+				sum0 = _mm256_add_epi32(sum0, _mm256_madd_epi16(weight_v, value0));
+				sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(weight_v, value1));
+				sum2 = _mm256_add_epi32(sum2, _mm256_madd_epi16(weight_v, value2));
+				sum3 = _mm256_add_epi32(sum3, _mm256_madd_epi16(weight_v, value3));
+			}
+			const __m256i sum = _mm256_hadd_epi32(_mm256_hadd_epi32(sum0, sum1), _mm256_hadd_epi32(sum2, sum3));
+			const __m128i sum_v = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+			sums0[r] = _mm_cvtsi128_si32(sum_v);
+			sums0[num_rows + r] = _mm_extract_epi32(sum_v, 1);
+			sums0[2 * num_rows + r] = _mm_extract_epi32(sum_v, 2);
+			sums0[3 * num_rows + r] = _mm_extract_epi32(sum_v, 3);
+		}
+	}
+	for(; d < num_data; d++)
+		fann_quant_dot_avx2<BITS>(weights, num_rows, num_cols, values + (size_t)d * values_stride, 
+			sums + (size_t)d * num_rows);
+}
+#endif
+
+FANN_EXTERNAL void FANN_API fann_quant_dot_batch(enum fann_isa_enum isa, unsigned int weight_bits,
+	const void *weights, unsigned int num_rows, unsigned int num_cols, const short *values,
+	unsigned int values_stride, unsigned int num_data, int *sums)
+{
+	unsigned int d;
+	assert(num_cols % FANN_QUANT_ALIGN == 0);
+#if defined FANN_USE_AVX && defined FANN_USE_FMA
+	if(isa >= FANN_ISA_FMA)
+	{
+		if(weight_bits == 8)
+			fann_quant_dot_batch_avx2<8>(weights, num_rows, num_cols, values, values_stride, num_data, sums);
+		else
+			fann_quant_dot_batch_avx2<16>(weights, num_rows, num_cols, values, values_stride, num_data, sums);
+		return;
+	}
+#endif
+	for(d = 0; d != num_data; d++)
+		fann_quant_dot_generic(weight_bits, weights, num_rows, num_cols, values + (size_t)d * values_stride,
+			sums + (size_t)d * num_rows);
+}
+
+FANN_EXTERNAL void FANN_API fann_quant_dot(enum fann_isa_enum isa, unsigned int weight_bits,
+	const void *weights, unsigned int num_rows, unsigned int num_cols, const short *values, int *sums)
+{
+	assert(num_cols % FANN_QUANT_ALIGN == 0);
+#if defined FANN_USE_AVX && defined FANN_USE_FMA
+	if(isa >= FANN_ISA_FMA)
+	{
+		if(weight_bits == 8)
+			fann_quant_dot_avx2<8>(weights, num_rows, num_cols, values, sums);
+		else
+			fann_quant_dot_avx2<16>(weights, num_rows, num_cols, values, sums);
+		return;
+	}
+#endif
+	fann_quant_dot_generic(weight_bits, weights, num_rows, num_cols, values, sums);
+}
+
+/* activations whose values the hidden scale takes */
+static bool fann_quant_bounded(unsigned int activation_function)
+{
+	switch(activation_function)
+	{
+	case FANN_SIGMOID:
+	case FANN_SIGMOID_STEPWISE:
+	case FANN_SIGMOID_SYMMETRIC:
+	case FANN_SIGMOID_SYMMETRIC_STEPWISE:
+	case FANN_ELLIOT:
+	case FANN_ELLIOT_SYMMETRIC:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* every neuron of layer_it takes all the values of the layer before, the
+   connections of one after those of the other */
+static bool fann_quant_connected(const struct fann *ann, const struct fann_layer *layer_it)
+{
+	const struct fann_neuron *neuron_it;
+	const unsigned int num_connections = (unsigned int)((layer_it - 1)->last_neuron - (layer_it - 1)->first_neuron);
+	unsigned int first_con = layer_it->first_neuron->first_con;
+
+	for(neuron_it = layer_it->first_neuron; neuron_it != layer_it->last_neuron - 1; neuron_it++)
+	{
+		if(neuron_it->first_con != first_con || neuron_it->last_con - neuron_it->first_con != num_connections)
+			return false;
+		first_con += num_connections;
+	}
+	return true;
+}
+
+FANN_EXTERNAL struct fann_quant *FANN_API fann_create_quant(const struct fann *ann,
+	unsigned int weight_bits, fann_type max_input)
+{
+	struct fann_quant *quant;
+	const struct fann_layer *layer_it;
+	unsigned int l, k;
+	const unsigned int num_layers = (unsigned int)(ann->last_layer - ann->first_layer) - 1;
+
+	if((weight_bits != 8 && weight_bits != 16) || (num_layers != 1 && num_layers != 2) || max_input <= 0)
+		return NULL;
+	for(layer_it = ann->first_layer + 1; layer_it != ann->last_layer; layer_it++)
+		if(!fann_quant_connected(ann, layer_it))
+			return NULL;
+	if(num_layers == 2 && !fann_quant_bounded((ann->first_layer + 1)->activation_function))
+		return NULL;
+
+	quant = (struct fann_quant *) fann_calloc(1, sizeof(struct fann_quant));
+	if(quant == NULL)
+		return NULL;
+
+	quant->weight_bits = weight_bits;
+	quant->isa = fann_quant_isa();
+	quant->max_input = max_input;
+	quant->input_scale = 1;
+	while(max_input * quant->input_scale * 2 <= FANN_QUANT_RANGE)
+		quant->input_scale *= 2;
+	while(max_input * quant->input_scale > FANN_QUANT_RANGE)
+		quant->input_scale /= 2;
+	/* the hidden values are within [-1, 1] */
+	quant->hidden_scale = FANN_QUANT_RANGE;
+	quant->num_layers = num_layers;
+
+	for(l = 0; l != num_layers; l++)
+	{
+		struct fann_quant_layer *layer = quant->layers + l;
+		const fann_type *weights;
+		unsigned int num_prev;
+
+		layer_it = ann->first_layer + 1 + l;
+		/* without the bias neurons */
+		num_prev = (unsigned int)((layer_it - 1)->last_neuron - (layer_it - 1)->first_neuron) - 1;
+		layer->num_neurons = (unsigned int)(layer_it->last_neuron - layer_it->first_neuron) - 1;
+		layer->num_cols = (num_prev + FANN_QUANT_ALIGN - 1) / FANN_QUANT_ALIGN * FANN_QUANT_ALIGN;
+		layer->weights = fann_calloc((size_t)layer->num_neurons * layer->num_cols, weight_bits / 8);
+		layer->bias = (fann_type *) fann_calloc(layer->num_neurons, sizeof(fann_type));
+		if(layer->weights == NULL || layer->bias == NULL)
+		{
+			fann_destroy_quant(quant);
+			return NULL;
+		}
+
+		weights = ann->weights + layer_it->first_neuron->first_con;
+		layer->weight_scale = fann_quant_matrix(weights, layer->num_neurons, num_prev, num_prev + 1, 1,
+			weight_bits, layer->weights, layer->num_cols);
+		for(k = 0; k != layer->num_neurons; k++)
+			layer->bias[k] = weights[k * (num_prev + 1) + num_prev];
+		layer->step = 1 / (layer->weight_scale * (l ? quant->hidden_scale : quant->input_scale));
+	}
+	return quant;
+}
+
+FANN_EXTERNAL void FANN_API fann_destroy_quant(struct fann_quant *quant)
+{
+	unsigned int l;
+	if(quant == NULL)
+		return;
+	for(l = 0; l != 2; l++)
+	{
+		fann_safe_free(quant->layers[l].weights);
+		fann_safe_free(quant->layers[l].bias);
+	}
+	fann_free(quant);
+}
+
+FANN_EXTERNAL enum fann_isa_enum FANN_API fann_set_quant_isa(struct fann_quant *quant,
+	enum fann_isa_enum isa)
+{
+#if defined FANN_USE_AVX && defined FANN_USE_FMA
+	if(isa >= FANN_ISA_FMA && fann_cpu_has_isa(FANN_ISA_FMA))
+	{
+		quant->isa = FANN_ISA_FMA;
+		return quant->isa;
+	}
+#endif
+	quant->isa = FANN_ISA_GENERIC;
+	return quant->isa;
+}
+
+FANN_EXTERNAL fann_type *FANN_API fann_run_quant(const struct fann *ann, const struct fann_quant *quant,
+	struct fann_context *ctx, const fann_type * input)
+{
+	const struct fann_neuron *first_neuron = ann->first_layer->first_neuron;
+	const unsigned int num_values = quant->layers[0].num_cols +
+		(quant->num_layers == 2 ? quant->layers[1].num_cols : 0);
+	short *values_q;
+	fann_type neuron_sum, *sums, *values = NULL;
+	unsigned int i, k, l;
+
+	if(num_values > ctx->quant_size)
+	{
+		fann_safe_free(ctx->quant_values);
+		ctx->quant_size = 0;
+		ctx->quant_values = (short *) fann_malloc(num_values * sizeof(short));
+		if(ctx->quant_values == NULL)
+			return NULL;
+		ctx->quant_size = num_values;
+	}
+	if(ctx->quant_sums == NULL)
+	{
+		ctx->quant_sums = (int *) fann_malloc(ctx->total_neurons * sizeof(int));
+		if(ctx->quant_sums == NULL)
+			return NULL;
+	}
+
+	values_q = ctx->quant_values;
+	fann_quant_values(quant->isa, input, ann->num_input, quant->layers[0].num_cols, quant->input_scale, values_q);
+	for(l = 0; l != quant->num_layers; l++)
+	{
+		const struct fann_quant_layer *layer = quant->layers + l;
+		const struct fann_layer *layer_it = ann->first_layer + 1 + l;
+		const unsigned int activation_function = layer_it->activation_function;
+		const fann_type steepness = layer_it->activation_steepness;
+		const fann_type max_sum = 150/steepness;
+
+		fann_quant_dot(quant->isa, quant->weight_bits, layer->weights, layer->num_neurons, layer->num_cols,
+			values_q, ctx->quant_sums);
+
+		sums = ctx->sum + (layer_it->first_neuron - first_neuron);
+		values = ctx->value + (layer_it->first_neuron - first_neuron);
+		for(k = 0; k != layer->num_neurons; k++)
+		{
+			neuron_sum = layer->bias[k] + layer->step * ctx->quant_sums[k];
+			neuron_sum = fann_mult(steepness, neuron_sum);
+			if(neuron_sum > max_sum)
+				neuron_sum = max_sum;
+			else if(neuron_sum < -max_sum)
+				neuron_sum = -max_sum;
+
+			sums[k] = neuron_sum;
+			fann_activation_switch(activation_function, neuron_sum, values[k]);
+		}
+		/* the bias neuron */
+		values[k] = 1;
+
+		if(l + 1 != quant->num_layers)
+		{
+			values_q += layer->num_cols;
+			fann_quant_values(quant->isa, values, layer->num_neurons, quant->layers[l + 1].num_cols, quant->hidden_scale,
+				values_q);
+		}
+	}
+
+	for(i = 0; i != ann->num_output; i++)
+		ctx->output[i] = values[i];
+	return ctx->output;
+}
+
+#endif
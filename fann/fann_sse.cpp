@@ -107,25 +107,34 @@ float __inline __fastcall fann_hadd_ps(const __m128& arg)
 
 FANN_EXTERNAL fann_type *FANN_API fann_run_sse(struct fann * ann, const fann_type * input)
 {
-	unsigned int i, num_connections, num_input, num_output;
-	fann_type *output;
-	fann_type *weights;
+	struct fann_context ctx;
+	fann_own_context(ann, &ctx);
+	return fann_run_sse_context(ann, &ctx, input);
+}
+
+FANN_EXTERNAL fann_type *FANN_API fann_run_sse_context(const struct fann * ann, struct fann_context * ctx, 
+	const fann_type * input)
+{
+	unsigned int i, k, num_connections, num_input, num_output;
+	const fann_type *weights, *prev_values;
+	fann_type *sums, *values;
 	struct fann_layer *layer_it, *last_layer;
 
 	/* store some variabels local for fast access */
-	struct fann_neuron *first_neuron = ann->first_layer->first_neuron;
+	const struct fann_neuron *first_neuron = ann->first_layer->first_neuron;
 
 	/* make crash if used improperly */
 	assert(ann->can_use_sse);
+	assert(fann_sse_aligned(ctx->sum) && fann_sse_aligned(ctx->value));
 
 	/* first set the input */
 	num_input = ann->num_input;
 	for(i = 0; i != num_input; i++)
 	{
-		*first_neuron[i].valuePtr = input[i];
+		ctx->value[i] = input[i];
 	}
 	// Set the bias neuron in the input layer
-	*(ann->first_layer->last_neuron - 1)->valuePtr = 1;
+	ctx->value[ann->first_layer->last_neuron - 1 - first_neuron] = 1;
 	last_layer = ann->last_layer;
 
 	//hidden layers
@@ -134,55 +143,46 @@ FANN_EXTERNAL fann_type *FANN_API fann_run_sse(struct fann * ann, const fann_typ
 		fann_activationfunc_enum activation_function = layer_it->activation_function;
 		fann_type steepness = layer_it->activation_steepness;
 		fann_neuron *last_neuron = layer_it->last_neuron;
-		fann_neuron *neurons = (layer_it - 1)->first_neuron;
+		const unsigned int num_neurons = (unsigned int)(last_neuron - layer_it->first_neuron);
+		sums = ctx->sum + (layer_it->first_neuron - first_neuron);
+		values = ctx->value + (layer_it->first_neuron - first_neuron);
+		prev_values = ctx->value + ((layer_it - 1)->first_neuron - first_neuron);
 
-		for(fann_neuron *neuron_it = layer_it->first_neuron; neuron_it < last_neuron; neuron_it++)
+		for(k = 0; k < num_neurons; k++)
 		{
+			const fann_neuron *neuron_it = layer_it->first_neuron + k;
 			num_connections = neuron_it->last_con - neuron_it->first_con;
 			weights = ann->weights + neuron_it->first_con;
 
-			__m128 neuron_sum_v = _mm_setzero_ps(); /* sets it to {0, 0, 0, 0} vector */
+			__m128 neuron_sum_v = _mm_setzero_ps();
 			
 			for(i = 0; i < num_connections; i += 4)
 			{
 				__m128 weight_v = _mm_load_ps(weights + i); 
-				__m128 value_v = _mm_load_ps(neurons[i].valuePtr);
+				__m128 value_v = _mm_load_ps(prev_values + i);
 				neuron_sum_v = _mm_add_ps(neuron_sum_v, _mm_mul_ps(weight_v, value_v));
-				//neuron_sum +=
-				//	fann_mult(weights[i], *neurons[i].valuePtr) +
-				//	fann_mult(weights[i + 1], *neurons[i + 1].valuePtr) +
-				//	fann_mult(weights[i + 2], *neurons[i + 2].valuePtr) +
-				//	fann_mult(weights[i + 3], *neurons[i + 3].valuePtr);
 			}
 		
-			*neuron_it->sumPtr = fann_hadd_ps(neuron_sum_v);
-			//neuron_sum = neuron_sum_v.m128_f32[0] + neuron_sum_v.m128_f32[1]
-			//	+ neuron_sum_v.m128_f32[2] + neuron_sum_v.m128_f32[3];
+			sums[k] = fann_hadd_ps(neuron_sum_v);
 		}
 
 		__m128 steepness_v = _mm_load_ps1(&steepness);
 		__m128 max_sum = _mm_div_ps(pos_limit.ps, steepness_v); // 150/steepness
 		__m128 min_sum = _mm_div_ps(neg_limit.ps, steepness_v); //-150/steepness
-		for(fann_neuron *neuron_it = layer_it->first_neuron; neuron_it < last_neuron; neuron_it += 4)
+		for(k = 0; k < num_neurons; k += 4)
 		{
-			__m128 neuron_sum = _mm_mul_ps(steepness_v, _mm_load_ps(neuron_it->sumPtr));
+			__m128 neuron_sum = _mm_mul_ps(steepness_v, _mm_load_ps(sums + k));
 			neuron_sum = _mm_min_ps(max_sum, _mm_max_ps(min_sum, neuron_sum));
-			//if(neuron_sum > max_sum)
-			//	neuron_sum = max_sum;
-			//else if(neuron_sum < min_sum)
-			//	neuron_sum = min_sum;
 
-			_mm_store_ps(neuron_it->sumPtr, neuron_sum);
-			//*neuron_it->sumPtr = neuron_sum;
+			_mm_store_ps(sums + k, neuron_sum);
 			__m128 activationResult;
 			fann_activation_switch_ps(activation_function, neuron_sum, activationResult);
-			_mm_store_ps(neuron_it->valuePtr, activationResult);
-			//fann_activation_switch(activation_function, neuron_sum, *neuron_it->valuePtr);
+			_mm_store_ps(values + k, activationResult);
 		}
 
 		//bias
-		*(last_neuron-1)->sumPtr = 0;
-		*(last_neuron-1)->valuePtr = 1;
+		sums[num_neurons - 1] = 0;
+		values[num_neurons - 1] = 1;
 	}
 
 	//Output layer
@@ -190,30 +190,26 @@ FANN_EXTERNAL fann_type *FANN_API fann_run_sse(struct fann * ann, const fann_typ
 	{
 		fann_activationfunc_enum activation_function = layer_it->activation_function;
 		fann_type steepness = layer_it->activation_steepness;
-		fann_neuron *neurons = (layer_it - 1)->first_neuron;
-		fann_neuron *last_neuron = layer_it->last_neuron;
-		for(fann_neuron *neuron_it = layer_it->first_neuron; neuron_it != last_neuron; neuron_it++)
+		const unsigned int num_neurons = (unsigned int)(layer_it->last_neuron - layer_it->first_neuron);
+		sums = ctx->sum + (layer_it->first_neuron - first_neuron);
+		values = ctx->value + (layer_it->first_neuron - first_neuron);
+		prev_values = ctx->value + ((layer_it - 1)->first_neuron - first_neuron);
+		for(k = 0; k < num_neurons; k++)
 		{
+			const fann_neuron *neuron_it = layer_it->first_neuron + k;
 			fann_type neuron_sum = 0;
 			num_connections = neuron_it->last_con - neuron_it->first_con;
 			weights = ann->weights + neuron_it->first_con;
-			__m128 neuron_sum_v = _mm_setzero_ps(); /* sets it to {0, 0, 0, 0} vector */
+			__m128 neuron_sum_v = _mm_setzero_ps();
 			
 			for(i = 0; i < num_connections; i += 4)
 			{
 				__m128 weight_v = _mm_load_ps(weights + i); 
-				__m128 value_v = _mm_load_ps(neurons[i].valuePtr);
+				__m128 value_v = _mm_load_ps(prev_values + i);
 				neuron_sum_v = _mm_add_ps(neuron_sum_v, _mm_mul_ps(weight_v, value_v));
-				//neuron_sum +=
-				//	fann_mult(weights[i], *neurons[i].valuePtr) +
-				//	fann_mult(weights[i + 1], *neurons[i + 1].valuePtr) +
-				//	fann_mult(weights[i + 2], *neurons[i + 2].valuePtr) +
-				//	fann_mult(weights[i + 3], *neurons[i + 3].valuePtr);
 			}
 		
 			neuron_sum = fann_hadd_ps(neuron_sum_v);
-			//neuron_sum = neuron_sum_v.m128_f32[0] + neuron_sum_v.m128_f32[1]
-			//	+ neuron_sum_v.m128_f32[2] + neuron_sum_v.m128_f32[3];
 
 			neuron_sum = steepness * neuron_sum;
 			
@@ -223,24 +219,192 @@ FANN_EXTERNAL fann_type *FANN_API fann_run_sse(struct fann * ann, const fann_typ
 			else if(neuron_sum < -max_sum)
 				neuron_sum = -max_sum;
 			
-			*neuron_it->sumPtr = neuron_sum;
-			fann_activation_switch(activation_function, neuron_sum, *neuron_it->valuePtr);
+			sums[k] = neuron_sum;
+			fann_activation_switch(activation_function, neuron_sum, values[k]);
 		}
 
 		//bias
-		*(last_neuron-1)->sumPtr = 0;
-		*(last_neuron-1)->valuePtr = 1;
+		sums[num_neurons - 1] = 0;
+		values[num_neurons - 1] = 1;
 	}
 
 	/* set the output */
-	output = ann->output;
 	num_output = ann->num_output;
-	fann_neuron *neurons = (ann->last_layer - 1)->first_neuron;
 	for(i = 0; i != num_output; i++)
 	{
-		output[i] = *neurons[i].valuePtr;
+		ctx->output[i] = values[i];
+	}
+	return ctx->output;
+}
+
+/* The batch kernel: a block of FANN_BATCH_NEURONS neurons stays in the cache
+   while all the inputs go by, and 4 inputs times 2 neurons share their
+   loads. Every sum adds up in the lanes and order of fann_run_sse, so the batch
+   gives its outputs bit for bit. */
+#define FANN_BATCH_NEURONS 16
+
+static void fann_batch_sums_sse(const fann_type *weights, const struct fann_neuron *neurons, 
+	unsigned int num_neurons, const fann_type *in, unsigned int in_width, fann_type *out, 
+	unsigned int out_width, unsigned int num_data)
+{
+	unsigned int jb, je, j, r, i;
+
+	for(jb = 0; jb < num_neurons; jb = je)
+	{
+		je = jb + FANN_BATCH_NEURONS < num_neurons ? jb + FANN_BATCH_NEURONS : num_neurons;
+		for(r = 0; r + 4 <= num_data; r += 4)
+		{
+			const fann_type *in0 = in + r * in_width, *in1 = in0 + in_width;
+			const fann_type *in2 = in1 + in_width, *in3 = in2 + in_width;
+			fann_type *out0 = out + r * out_width;
+			for(j = jb; j + 2 <= je; j += 2)
+			{
+				const fann_type *w0 = weights + neurons[j].first_con, *w1 = weights + neurons[j + 1].first_con;
+				__m128 s00 = _mm_setzero_ps(), s01 = _mm_setzero_ps(), s10 = _mm_setzero_ps(), s11 = _mm_setzero_ps();
+				__m128 s20 = _mm_setzero_ps(), s21 = _mm_setzero_ps(), s30 = _mm_setzero_ps(), s31 = _mm_setzero_ps();
+				for(i = 0; i < in_width; i += 4)
+				{
+					__m128 a0 = _mm_load_ps(w0 + i), a1 = _mm_load_ps(w1 + i), v;
+					v = _mm_load_ps(in0 + i);
+					s00 = _mm_add_ps(s00, _mm_mul_ps(a0, v));
+					s01 = _mm_add_ps(s01, _mm_mul_ps(a1, v));
+					v = _mm_load_ps(in1 + i);
+					s10 = _mm_add_ps(s10, _mm_mul_ps(a0, v));
+					s11 = _mm_add_ps(s11, _mm_mul_ps(a1, v));
+					v = _mm_load_ps(in2 + i);
+					s20 = _mm_add_ps(s20, _mm_mul_ps(a0, v));
+					s21 = _mm_add_ps(s21, _mm_mul_ps(a1, v));
+					v = _mm_load_ps(in3 + i);
+					s30 = _mm_add_ps(s30, _mm_mul_ps(a0, v));
+					s31 = _mm_add_ps(s31, _mm_mul_ps(a1, v));
+				}
+				out0[j] = fann_hadd_ps(s00);
+				out0[j + 1] = fann_hadd_ps(s01);
+				out0[out_width + j] = fann_hadd_ps(s10);
+				out0[out_width + j + 1] = fann_hadd_ps(s11);
+				out0[2 * out_width + j] = fann_hadd_ps(s20);
+				out0[2 * out_width + j + 1] = fann_hadd_ps(s21);
+				out0[3 * out_width + j] = fann_hadd_ps(s30);
+				out0[3 * out_width + j + 1] = fann_hadd_ps(s31);
+			}
+			for(; j < je; j++)
+			{
+				const fann_type *w0 = weights + neurons[j].first_con;
+				__m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps(), s2 = _mm_setzero_ps(), s3 = _mm_setzero_ps();
+				for(i = 0; i < in_width; i += 4)
+				{
+					__m128 a0 = _mm_load_ps(w0 + i);
+					s0 = _mm_add_ps(s0, _mm_mul_ps(a0, _mm_load_ps(in0 + i)));
+					s1 = _mm_add_ps(s1, _mm_mul_ps(a0, _mm_load_ps(in1 + i)));
+					s2 = _mm_add_ps(s2, _mm_mul_ps(a0, _mm_load_ps(in2 + i)));
+					s3 = _mm_add_ps(s3, _mm_mul_ps(a0, _mm_load_ps(in3 + i)));
+				}
+				out0[j] = fann_hadd_ps(s0);
+				out0[out_width + j] = fann_hadd_ps(s1);
+				out0[2 * out_width + j] = fann_hadd_ps(s2);
+				out0[3 * out_width + j] = fann_hadd_ps(s3);
+			}
+		}
+		for(; r < num_data; r++)
+		{
+			const fann_type *in0 = in + r * in_width;
+			for(j = jb; j < je; j++)
+			{
+				const fann_type *w0 = weights + neurons[j].first_con;
+				__m128 s0 = _mm_setzero_ps();
+				for(i = 0; i < in_width; i += 4)
+					s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_load_ps(w0 + i), _mm_load_ps(in0 + i)));
+				out[r * out_width + j] = fann_hadd_ps(s0);
+			}
+		}
+	}
+}
+
+FANN_EXTERNAL void FANN_API fann_run_batch_sse(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type *input, unsigned int num_data, unsigned int input_stride, fann_type *output)
+{
+	struct fann_layer *layer_it;
+	const struct fann_neuron *first_neuron = ann->first_layer->first_neuron;
+	const unsigned int num_output = ann->num_output;
+	fann_type *batch = fann_context_batch(ctx, num_data);
+	fann_type *values;
+	const fann_type *prev_values;
+	unsigned int i, j, r, width, prev_width;
+
+	/* make crash if used improperly */
+	assert(ann->can_use_sse);
+
+	if(batch == NULL)
+	{
+		/* without the memory for the batch one input after the other */
+		for(r = 0; r != num_data; r++)
+			memcpy(output + r * num_output, fann_run_sse_context(ann, ctx, input + r * input_stride), 
+				num_output * sizeof(fann_type));
+		return;
+	}
+
+	/* the input layer with its bias neuron, one row per input */
+	prev_width = (unsigned int)(ann->first_layer->last_neuron - ann->first_layer->first_neuron);
+	values = batch;
+	for(r = 0; r != num_data; r++)
+	{
+		memcpy(values + r * prev_width, input + r * input_stride, ann->num_input * sizeof(fann_type));
+		values[r * prev_width + prev_width - 1] = 1;
+	}
+	prev_values = values;
+
+	for(layer_it = ann->first_layer + 1; layer_it != ann->last_layer; layer_it++)
+	{
+		fann_activationfunc_enum activation_function = layer_it->activation_function;
+		fann_type steepness = layer_it->activation_steepness;
+		width = (unsigned int)(layer_it->last_neuron - layer_it->first_neuron);
+		values = batch + num_data * (unsigned int)(layer_it->first_neuron - first_neuron);
+
+		/* the sums of all the neurons but the bias one */
+		fann_batch_sums_sse(ann->weights, layer_it->first_neuron, width - 1, prev_values, prev_width, 
+			values, width, num_data);
+
+		if(layer_it != ann->last_layer - 1)
+		{
+			/* the activation as in the hidden layers of fann_run_sse */
+			__m128 steepness_v = _mm_load_ps1(&steepness);
+			__m128 max_sum = _mm_div_ps(pos_limit.ps, steepness_v); // 150/steepness
+			__m128 min_sum = _mm_div_ps(neg_limit.ps, steepness_v); //-150/steepness
+			for(r = 0; r != num_data; r++)
+			{
+				fann_type *row = values + r * width;
+				row[width - 1] = 0;
+				for(i = 0; i < width; i += 4)
+				{
+					__m128 neuron_sum = _mm_mul_ps(steepness_v, _mm_load_ps(row + i));
+					neuron_sum = _mm_min_ps(max_sum, _mm_max_ps(min_sum, neuron_sum));
+					__m128 activationResult;
+					fann_activation_switch_ps(activation_function, neuron_sum, activationResult);
+					_mm_store_ps(row + i, activationResult);
+				}
+				//bias
+				row[width - 1] = 1;
+			}
+		}
+		else
+		{
+			/* the outputs as in fann_run_sse */
+			fann_type max_sum = 150/steepness;
+			for(r = 0; r != num_data; r++)
+				for(j = 0; j != num_output; j++)
+				{
+					fann_type neuron_sum = steepness * values[r * width + j];
+					if(neuron_sum > max_sum)
+						neuron_sum = max_sum;
+					else if(neuron_sum < -max_sum)
+						neuron_sum = -max_sum;
+					fann_activation_switch(activation_function, neuron_sum, output[r * num_output + j]);
+				}
+		}
+
+		prev_values = values;
+		prev_width = width;
 	}
-	return ann->output;
 }
 #elif defined DOUBLEFANN && FANN_USE_SSE >= 0x20
 static const union {
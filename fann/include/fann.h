@@ -210,6 +210,140 @@ FANN_EXTERNAL void FANN_API fann_destroy(struct fann *ann);
 */ 
 FANN_EXTERNAL fann_type * FANN_API fann_run(struct fann *ann, const fann_type * input);
 
+/* Struct: struct fann_context
+	What a run writes: the sums and values of all the neurons and the outputs.
+	<fann_run> uses the buffers inside the network; the runs that take a
+	context only read the network, so threads with a context each can run
+	one set of weights at the same time.
+*/
+struct fann_context
+{
+	unsigned int total_neurons;
+	unsigned int num_output;
+	fann_type *sum;
+	fann_type *value;
+	fann_type *output;
+	/* the values of all the neurons for up to batch_size inputs, layer by
+	   layer and in every layer input by input; grown by the batch runs */
+	fann_type *batch;
+	unsigned int batch_size;
+	/* the integer values and sums of the quantized runs, quant_size values
+	   and total_neurons sums; grown by <fann_run_quant> */
+	short *quant_values;
+	int *quant_sums;
+	unsigned int quant_size;
+};
+
+/* Function: fann_create_context
+	Creates the buffers of a run of *ann*, or NULL without memory.
+*/
+FANN_EXTERNAL struct fann_context *FANN_API fann_create_context(const struct fann *ann);
+
+/* Function: fann_destroy_context
+*/
+FANN_EXTERNAL void FANN_API fann_destroy_context(struct fann_context *ctx);
+
+/* Function: fann_run_context
+	Does the same as <fann_run> but leaves the network untouched, the
+	outputs returned belong to *ctx*.
+*/
+FANN_EXTERNAL fann_type * FANN_API fann_run_context(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type * input);
+
+/* Function: fann_run_batch
+	Runs *num_data* inputs, one every *input_stride* values from *input*, and
+	writes their outputs one after another to *output*. Here the inputs are
+	run one by one with <fann_run_context>; <fann_run_batch_sse> and
+	<fann_run_batch_avx> run every layer as one matrix product and give the
+	outputs of <fann_run_sse> and <fann_run_avx>.
+*/
+FANN_EXTERNAL void FANN_API fann_run_batch(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type *input, unsigned int num_data, unsigned int input_stride, fann_type *output);
+
+/* Struct: struct fann_incremental
+	The base of <fann_run_incremental>: the inputs of the first run and the
+	sums of the hidden neurons they gave.
+*/
+struct fann_incremental
+{
+	unsigned int num_input;
+	unsigned int num_hidden;
+	int saved;
+	fann_type *input;
+	fann_type *sum;
+	fann_type *diff;
+	unsigned int *changed;
+	/* the neurons of the runs */
+	struct fann_context *ctx;
+};
+
+/* Function: fann_create_incremental
+	Creates an empty base for <fann_run_incremental> with *ann*.
+*/
+FANN_EXTERNAL struct fann_incremental *FANN_API fann_create_incremental(const struct fann *ann);
+
+/* Function: fann_destroy_incremental
+*/
+FANN_EXTERNAL void FANN_API fann_destroy_incremental(struct fann_incremental *inc);
+
+/* Function: fann_run_incremental
+	Does the same as fann_run for inputs that differ in a few values, e.g.
+	the positions after the moves of one roll. The first run after
+	<fann_create_incremental> computes the hidden sums in full and saves
+	them, the following ones only add the weights of the changed inputs.
+	Only networks with one fully connected hidden layer are run that way,
+	other ones fall back to fann_run_context. The network is only read, the
+	outputs belong to *inc*.
+*/
+FANN_EXTERNAL fann_type * FANN_API fann_run_incremental(const struct fann *ann, const fann_type * input, 
+	struct fann_incremental *inc);
+
+/* Struct: struct fann_sparse
+	The weights of the first layer after the input, input by input, for
+	<fann_run_sparse>: row i holds what input i adds to each neuron of the
+	layer, the last row the bias.
+	Board encodings set a few dozen of their inputs, a run adds the rows of
+	those and skips the rest.
+*/
+struct fann_sparse
+{
+	unsigned int num_input;
+	/* without the bias neuron, 0 when the network is run densely */
+	unsigned int num_neurons;
+	/* the layer rounded up to 8 values, the rest of a row is 0 */
+	unsigned int stride;
+	fann_type *weights;
+};
+
+/* Function: fann_create_sparse
+	Copies the first layer of *ann* for <fann_run_sparse>, or returns NULL
+	without memory. It takes networks of two layers and of three whose first
+	layer after the input is fully connected to it, the copy of other ones
+	is empty.
+*/
+FANN_EXTERNAL struct fann_sparse *FANN_API fann_create_sparse(const struct fann *ann);
+
+/* Function: fann_update_sparse
+	Copies the first layer again after the weights of *ann* changed.
+*/
+FANN_EXTERNAL void FANN_API fann_update_sparse(const struct fann *ann, struct fann_sparse *sparse);
+
+/* Function: fann_destroy_sparse
+*/
+FANN_EXTERNAL void FANN_API fann_destroy_sparse(struct fann_sparse *sparse);
+
+/* Function: fann_run_sparse
+	Does the same as <fann_run_context> for the input that has *value[i]*
+	at *index[i]* for the *count* values given and 0 everywhere else; the
+	indices are below num_input. The sums of the first layer start from the
+	bias and add the rows of the given inputs only, inputs of 1 without the
+	multiplication. The sums add up in
+	another order than the dense runs, the outputs may differ in the last
+	bits. An empty *sparse* runs the dense input.
+*/
+FANN_EXTERNAL fann_type *FANN_API fann_run_sparse(const struct fann *ann, const struct fann_sparse *sparse, 
+	struct fann_context *ctx, const unsigned int *index, const fann_type *value, unsigned int count);
+
 /* Function: fann_randomize_weights
 	Give each connection a random weight between *min_weight* and *max_weight*
    
@@ -36,6 +36,30 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */ 
 FANN_EXTERNAL fann_type * FANN_API fann_run_avx(struct fann *ann, const fann_type * input);
 
+#if defined FLOATFANN
+/* Function: fann_run_avx_context
+	Does the same as fann_run_avx but writes into *ctx*, see <fann_run_context>.
+	The buffers of *ctx* have to be aligned as <fann_create_context> does.
+*/
+FANN_EXTERNAL fann_type * FANN_API fann_run_avx_context(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type * input);
+
+/* Function: fann_run_batch_avx
+	<fann_run_batch> with AVX instructions; every layer of the batch is one
+	cache blocked matrix product and the outputs are those of fann_run_avx.
+*/
+FANN_EXTERNAL void FANN_API fann_run_batch_avx(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type *input, unsigned int num_data, unsigned int input_stride, fann_type *output);
+
+/* Function: fann_run_sparse_avx
+	<fann_run_sparse> adding the rows 8 hidden neurons at a time; the other
+	layers run as in fann_run_avx. Networks without a hidden layer run
+	fann_run_sparse.
+*/
+FANN_EXTERNAL fann_type * FANN_API fann_run_sparse_avx(const struct fann *ann, const struct fann_sparse *sparse, 
+	struct fann_context *ctx, const unsigned int *index, const fann_type *value, unsigned int count);
+#endif
+
 /* Function: fann_test_avx
    Test with a set of inputs, and a set of desired outputs.
    This operation updates the mean square error, but does not
@@ -56,6 +80,35 @@ __inline __m256 __fastcall fann256_activation_derived_ps(fann_activationfunc_enu
 
 void fann_update_weights_avx(struct fann *ann);
 
+#if defined FLOATFANN
+/* steepness, the sum limits and the activation of the num_neurons sums of a
+   hidden layer, a multiple of 8, as fann_run_avx does them; the limited sums
+   go back to sums and the activations to values, which may be sums. The
+   kernels of the other 8 and 16 wide instruction sets share it. */
+void fann_activate_avx(const struct fann_layer *layer, fann_type *sums, fann_type *values, 
+	unsigned int num_neurons);
+
+/* the sums of num_neurons neurons over the values of the previous layer,
+   of a single input and of num_data inputs in rows in_width and out_width
+   values apart */
+typedef void (*fann_layer_sums_fn)(const fann_type *weights, const struct fann_neuron *neurons, 
+	unsigned int num_neurons, const fann_type *prev_values, fann_type *sums);
+typedef void (*fann_batch_sums_fn)(const fann_type *weights, const struct fann_neuron *neurons, 
+	unsigned int num_neurons, const fann_type *in, unsigned int in_width, fann_type *out, 
+	unsigned int out_width, unsigned int num_data);
+typedef fann_type *(FANN_API *fann_run_context_fn)(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type *input);
+
+/* fann_run_avx_context and fann_run_batch_avx around the sums of another
+   instruction set on layers of multiples of 8 neurons; batches fall back on
+   run_context without the memory */
+fann_type *fann_run_layers_avx(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type *input, fann_layer_sums_fn layer_sums);
+void fann_run_batch_layers_avx(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type *input, unsigned int num_data, unsigned int input_stride, fann_type *output, 
+	fann_batch_sums_fn batch_sums, fann_run_context_fn run_context);
+#endif
+
 
 
 #endif
@@ -0,0 +1,59 @@
+/*
+Fast Artificial Neural Network Library (fann)
+Copyright (C) 2003 Steffen Nissen (lukesky@diku.dk)
+Copyright (C) 2011 Alex Koshterek (koshterek@gmail.com)
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/  
+
+
+#ifndef __fann_avx512_h__
+#define __fann_avx512_h__
+#include "fann.h"
+
+#if defined FLOATFANN && defined FANN_USE_AVX && defined FANN_USE_AVX512
+
+/* Function: fann_run_avx512_context
+	<fann_run_avx_context> with the 16 wide fused multiply adds of AVX-512F,
+	the odd 8 connections of a neuron in a masked half. Takes the networks of
+	<fann_can_use_avx>, on a CPU with AVX-512F.
+
+	See also:
+		<fann_cpu_isa>, <fann_run_dispatch>
+*/
+FANN_EXTERNAL fann_type * FANN_API fann_run_avx512_context(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type * input);
+
+/* Function: fann_run_avx512
+	<fann_run_avx512_context> in the buffers of the network.
+*/
+FANN_EXTERNAL fann_type * FANN_API fann_run_avx512(struct fann *ann, const fann_type * input);
+
+/* Function: fann_run_batch_avx512
+	<fann_run_batch_avx> with AVX-512F, the outputs are those of
+	<fann_run_avx512_context>.
+*/
+FANN_EXTERNAL void FANN_API fann_run_batch_avx512(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type *input, unsigned int num_data, unsigned int input_stride, fann_type *output);
+
+/* Function: fann_train_avx512
+	<fann_train_avx> after the forward pass of <fann_run_avx512>.
+*/
+FANN_EXTERNAL void FANN_API fann_train_avx512(struct fann *ann, const fann_type * input, 
+	const fann_type * desired_output);
+
+#endif
+
+#endif	/* __fann_avx512_h__ */
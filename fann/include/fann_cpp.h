@@ -91,6 +91,8 @@
 #include "fann.h"
 #include "fann_sse.h"
 #include "fann_avx.h"
+#include "fann_cpu.h"
+#include "fann_quant.h"
 
 /* Namespace: FANN
     The FANN namespace groups the C++ wrapper definitions */
@@ -880,6 +882,110 @@ public:
             return fann_run(ann, input);
         }
 
+        /* Method: run
+
+	        Runs input with the buffers of ctx and leaves the network untouched,
+	        see <fann_run_context>.
+        */ 
+        fann_type* run(const fann_type *input, struct fann_context *ctx) const
+        {
+            if (ann == NULL)
+            {
+                return NULL;
+            }
+            return fann_run_context(ann, ctx, input);
+        }
+
+        /* Method: create_context
+
+	        The buffers of a run that does not write into the network, see <fann_create_context>.
+        */ 
+        struct fann_context *create_context() const
+        {
+            if (ann == NULL)
+            {
+                return NULL;
+            }
+            return fann_create_context(ann);
+        }
+
+        /* Method: run_incremental
+
+	        Runs input from the base saved in inc, see <fann_run_incremental>.
+        */ 
+        fann_type* run_incremental(const fann_type *input, struct fann_incremental *inc) const
+        {
+            if (ann == NULL)
+            {
+                return NULL;
+            }
+            return fann_run_incremental(ann, input, inc);
+        }
+
+        struct fann_incremental *create_incremental() const
+        {
+            if (ann == NULL)
+            {
+                return NULL;
+            }
+            return fann_create_incremental(ann);
+        }
+
+        /* Method: run_sparse
+
+	        Runs the input given by its count non-zero values, value[i] at index[i],
+	        from the first layer copied in sparse, see <fann_run_sparse_dispatch>.
+        */ 
+        fann_type* run_sparse(const unsigned int *index, const fann_type *value, unsigned int count, 
+            const struct fann_sparse *sparse, struct fann_context *ctx) const
+        {
+            if (ann == NULL)
+            {
+                return NULL;
+            }
+            return fann_run_sparse_dispatch(ann, sparse, ctx, index, value, count);
+        }
+
+        struct fann_sparse *create_sparse() const
+        {
+            if (ann == NULL)
+            {
+                return NULL;
+            }
+            return fann_create_sparse(ann);
+        }
+
+        void update_sparse(struct fann_sparse *sparse) const
+        {
+            if (ann != NULL)
+            {
+                fann_update_sparse(ann, sparse);
+            }
+        }
+
+        /* Method: run_quant
+
+	        Runs input through the integer copy quant of the network, see <fann_run_quant>.
+        */ 
+        fann_type* run_quant(const fann_type *input, const struct fann_quant *quant, 
+            struct fann_context *ctx) const
+        {
+            if (ann == NULL)
+            {
+                return NULL;
+            }
+            return fann_run_quant(ann, quant, ctx, input);
+        }
+
+        struct fann_quant *create_quant(unsigned int weight_bits, fann_type max_input) const
+        {
+            if (ann == NULL)
+            {
+                return NULL;
+            }
+            return fann_create_quant(ann, weight_bits, max_input);
+        }
+
 #if defined FANN_USE_SSE
         /* Method: run_sse
 
@@ -900,6 +1006,19 @@ public:
             }
             return fann_run_sse(ann, input);
         }
+
+        /* Method: run_sse
+
+	        run_sse with the buffers of ctx, see <fann_run_sse_context>.
+        */ 
+        fann_type* run_sse(const fann_type *input, struct fann_context *ctx) const
+        {
+            if (ann == NULL)
+            {
+                return NULL;
+            }
+            return fann_run_sse_context(ann, ctx, input);
+        }
 #endif
 
 #if defined FANN_USE_AVX
@@ -922,8 +1041,51 @@ public:
             }
             return fann_run_avx(ann, input);
         }
+
+        /* Method: run_avx
+
+	        run_avx with the buffers of ctx, see <fann_run_avx_context>.
+        */ 
+        fann_type* run_avx(const fann_type *input, struct fann_context *ctx) const
+        {
+            if (ann == NULL)
+            {
+                return NULL;
+            }
+            return fann_run_avx_context(ann, ctx, input);
+        }
 #endif
 
+        /* Method: run_batch
+
+	        Runs num_data inputs, input_stride values apart, with the buffers of ctx
+	        and writes num_output values per input to output, with the kernel of
+	        the instruction set of the network, see <fann_run_batch_dispatch>.
+        */ 
+        void run_batch(const fann_type *input, unsigned int num_data, unsigned int input_stride, 
+            fann_type *output, struct fann_context *ctx) const
+        {
+            if (ann == NULL)
+            {
+                return;
+            }
+            fann_run_batch_dispatch(ann, ctx, input, num_data, input_stride, output);
+        }
+
+        /* Method: run_dispatch
+
+	        run with the buffers of ctx and the kernel of the instruction set of
+	        the network, see <fann_run_dispatch>.
+        */ 
+        fann_type* run_dispatch(const fann_type *input, struct fann_context *ctx) const
+        {
+            if (ann == NULL)
+            {
+                return NULL;
+            }
+            return fann_run_dispatch(ann, ctx, input);
+        }
+
         /* Method: randomize_weights
 
 	        Give each connection a random weight between *min_weight* and *max_weight*
@@ -1132,6 +1294,21 @@ public:
             }
         }
 #endif
+
+        /* Method: train_dispatch
+
+           train with the kernel of the instruction set of the network.
+
+   	        See also:
+   		        <train>, <fann_train_dispatch>
+         */ 
+        void train_dispatch(const fann_type *input, const fann_type *desired_output)
+        {
+            if (ann != NULL)
+            {
+                fann_train_dispatch(ann, input, desired_output);
+            }
+        }
 		/* Method: train_epoch
             Train one epoch with a set of training data.
            
@@ -2672,15 +2849,44 @@ public:
 				fann_disable_avx(ann);
 		}
 
-		bool isAvxOk()
+		bool isAvxOk() const
 		{
 			return ann == NULL ? false : ann->can_use_avx;
 		}
-		bool isSseOk()
+		bool isSseOk() const
 		{
 			return ann == NULL ? false : ann->can_use_sse;
 		}
 
+		/* Method: select_isa
+
+		   Picks the fastest instruction set of the CPU the network allows.
+
+		   See also:
+				<fann_select_isa>
+		*/
+		fann_isa_enum select_isa()
+		{
+			return ann == NULL ? FANN_ISA_GENERIC : fann_select_isa(ann);
+		}
+
+		/* Method: set_isa
+
+		   Takes isa or the fastest allowed one below it.
+
+		   See also:
+				<fann_set_isa>
+		*/
+		fann_isa_enum set_isa(fann_isa_enum isa)
+		{
+			return ann == NULL ? FANN_ISA_GENERIC : fann_set_isa(ann, isa);
+		}
+
+		fann_isa_enum get_isa() const
+		{
+			return ann == NULL ? FANN_ISA_GENERIC : ann->isa;
+		}
+
         /*********************************************************************/
 
     private:
@@ -0,0 +1,92 @@
+/*
+Fast Artificial Neural Network Library (fann)
+Copyright (C) 2003 Steffen Nissen (lukesky@diku.dk)
+Copyright (C) 2011 Alex Koshterek (koshterek@gmail.com)
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/  
+
+#ifndef __fann_cpu_h__
+#define __fann_cpu_h__
+#include "fann.h"
+
+/* Function: fann_cpu_isa
+	The fastest instruction set of <fann_isa_enum> both this CPU, with the
+	support of the operating system, and the build offer. Asks cpuid once.
+
+	See also:
+		<fann_select_isa>
+*/
+FANN_EXTERNAL enum fann_isa_enum FANN_API fann_cpu_isa(void);
+
+/* Function: fann_cpu_has_isa
+	Nonzero when both the CPU and the build offer *isa*.
+*/
+FANN_EXTERNAL int FANN_API fann_cpu_has_isa(enum fann_isa_enum isa);
+
+/* Function: fann_set_isa_limit
+	The fastest instruction set <fann_select_isa> may pick, <FANN_ISA_AVX512>
+	at first. Lower it to compare kernels or to reproduce the results of a
+	slower machine; it does not change the networks selected before.
+*/
+FANN_EXTERNAL void FANN_API fann_set_isa_limit(enum fann_isa_enum isa);
+FANN_EXTERNAL enum fann_isa_enum FANN_API fann_get_isa_limit(void);
+
+/* Function: fann_select_isa
+	Checks the network with <fann_can_use_sse> and <fann_can_use_avx> and
+	takes the fastest instruction set both it and <fann_cpu_isa> allow, up to
+	<fann_set_isa_limit>. Call it after the network is created or loaded.
+
+	Returns:
+		The instruction set of the network.
+*/
+FANN_EXTERNAL enum fann_isa_enum FANN_API fann_select_isa(struct fann *ann);
+
+/* Function: fann_set_isa
+	Takes isa, or the fastest allowed one below it, for the network. Needs
+	<fann_select_isa> first.
+
+	Returns:
+		The instruction set of the network.
+*/
+FANN_EXTERNAL enum fann_isa_enum FANN_API fann_set_isa(struct fann *ann, enum fann_isa_enum isa);
+
+/* Function: fann_run_dispatch
+	<fann_run_context> with the kernel of the instruction set of the network.
+*/
+FANN_EXTERNAL fann_type * FANN_API fann_run_dispatch(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type * input);
+
+/* Function: fann_run_batch_dispatch
+	<fann_run_batch> with the kernel of the instruction set of the network.
+*/
+FANN_EXTERNAL void FANN_API fann_run_batch_dispatch(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type *input, unsigned int num_data, unsigned int input_stride, fann_type *output);
+
+/* Function: fann_run_sparse_dispatch
+	<fann_run_sparse> with the AVX kernel for the instruction sets from AVX
+	on; the first layer is added up the same way by all of them.
+*/
+FANN_EXTERNAL fann_type * FANN_API fann_run_sparse_dispatch(const struct fann *ann, 
+	const struct fann_sparse *sparse, struct fann_context *ctx, const unsigned int *index, 
+	const fann_type *value, unsigned int count);
+
+/* Function: fann_train_dispatch
+	<fann_train> with the kernel of the instruction set of the network.
+*/
+FANN_EXTERNAL void FANN_API fann_train_dispatch(struct fann *ann, const fann_type * input, 
+	const fann_type * desired_output);
+
+#endif	/* __fann_cpu_h__ */
@@ -327,6 +327,51 @@ static char const *const FANN_STOPFUNC_NAMES[] = {
 	"FANN_STOPFUNC_BIT"
 };
 
+/* Enum: fann_isa_enum
+	The instruction sets of the kernels that run and train a network, from the
+	slowest to the fastest.
+
+	FANN_ISA_GENERIC - <fann_run> and <fann_train>, any CPU and any network.
+	FANN_ISA_SSE - 4 wide SSE, layers of multiples of 4 neurons.
+	FANN_ISA_AVX - 8 wide AVX, layers of multiples of 8 neurons.
+	FANN_ISA_FMA - 8 wide fused multiply adds of AVX2 and FMA, layers as FANN_ISA_AVX.
+	FANN_ISA_AVX512 - 16 wide AVX-512F, layers as FANN_ISA_AVX.
+
+	The vector kernels add up in other orders than the generic ones and the
+	fused ones round once per multiply add, so the outputs of two instruction
+	sets agree to the last bits rather than bit for bit.
+
+	See also:
+		<fann_select_isa>, <fann_set_isa>, <fann_cpu_isa>
+*/
+enum fann_isa_enum
+{
+	FANN_ISA_GENERIC = 0,
+	FANN_ISA_SSE,
+	FANN_ISA_AVX,
+	FANN_ISA_FMA,
+	FANN_ISA_AVX512
+};
+
+/* Constant: FANN_ISA_NAMES
+   
+   Constant array consisting of the short names for the instruction sets, so that the name of an
+   instruction set can be received by:
+   (code)
+   char *name = FANN_ISA_NAMES[isa];
+   (end)
+
+   See Also:
+      <fann_isa_enum>
+*/
+static char const *const FANN_ISA_NAMES[] = {
+	"generic",
+	"sse",
+	"avx",
+	"fma",
+	"avx512"
+};
+
 /* forward declarations for use with the callback */
 struct fann;
 struct fann_train_data;
@@ -647,6 +692,14 @@ struct fann
            <fann_can_use_avx>, <fann_disable_avx>
 	 */
 	bool can_use_avx;
+
+	/* The instruction set <fann_run_dispatch>, <fann_run_batch_dispatch> and
+	   <fann_train_dispatch> take, the generic one until <fann_select_isa>
+
+       See also:
+           <fann_select_isa>, <fann_set_isa>
+	 */
+	enum fann_isa_enum isa;
 };
 
 /* Type: fann_connection
@@ -0,0 +1,58 @@
+/*
+Fast Artificial Neural Network Library (fann)
+Copyright (C) 2003 Steffen Nissen (lukesky@diku.dk)
+Copyright (C) 2011 Alex Koshterek (koshterek@gmail.com)
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/  
+
+
+#ifndef __fann_fma_h__
+#define __fann_fma_h__
+#include "fann.h"
+
+#if defined FLOATFANN && defined FANN_USE_AVX && defined FANN_USE_FMA
+
+/* Function: fann_run_fma_context
+	<fann_run_avx_context> with the fused multiply adds of AVX2 and FMA. Takes
+	the networks of <fann_can_use_avx>, on a CPU with both instruction sets.
+
+	See also:
+		<fann_cpu_isa>, <fann_run_dispatch>
+*/
+FANN_EXTERNAL fann_type * FANN_API fann_run_fma_context(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type * input);
+
+/* Function: fann_run_fma
+	<fann_run_fma_context> in the buffers of the network.
+*/
+FANN_EXTERNAL fann_type * FANN_API fann_run_fma(struct fann *ann, const fann_type * input);
+
+/* Function: fann_run_batch_fma
+	<fann_run_batch_avx> with fused multiply adds, the outputs are those of
+	<fann_run_fma_context>.
+*/
+FANN_EXTERNAL void FANN_API fann_run_batch_fma(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type *input, unsigned int num_data, unsigned int input_stride, fann_type *output);
+
+/* Function: fann_train_fma
+	<fann_train_avx> after the forward pass of <fann_run_fma>.
+*/
+FANN_EXTERNAL void FANN_API fann_train_fma(struct fann *ann, const fann_type * input, 
+	const fann_type * desired_output);
+
+#endif
+
+#endif	/* __fann_fma_h__ */
@@ -55,9 +55,12 @@ FANN_SET(type, name)
 
 
 struct fann_train_data;
+struct fann_context;
 
 struct fann *fann_allocate_structure(unsigned int num_layers);
 void fann_allocate_neurons(struct fann *ann);
+void fann_own_context(struct fann *ann, struct fann_context *ctx);
+fann_type *fann_context_batch(struct fann_context *ctx, unsigned int num_data);
 
 void fann_allocate_connections(struct fann *ann);
 
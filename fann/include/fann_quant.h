@@ -0,0 +1,164 @@
+/*
+Fast Artificial Neural Network Library (fann)
+Copyright (C) 2003 Steffen Nissen (lukesky@diku.dk)
+Copyright (C) 2011 Alex Koshterek (koshterek@gmail.com)
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef __fann_quant_h__
+#define __fann_quant_h__
+#include "fann.h"
+
+#if defined FLOATFANN
+
+/* Constant: FANN_QUANT_RANGE
+	The largest magnitude of a quantized value. With it the integer sum of
+	a neuron cannot overflow 32 bits: the weights of every layer are scaled
+	so that their magnitudes add up to at most 2^31 / FANN_QUANT_RANGE.
+*/
+#define FANN_QUANT_RANGE 4096
+
+/* Constant: FANN_QUANT_ALIGN
+	The rows of quantized weights and values are padded with zeros to a
+	multiple of it, the width of the integer kernels.
+*/
+#define FANN_QUANT_ALIGN 16
+
+/* Function: fann_quant_matrix
+	Quantizes *num_rows* rows of *num_cols* weights to *weight_bits* (8 or
+	16) bit integers with one scale for all of them, the largest one that
+	fits the weights in the bits and keeps every row sum of a product with
+	values up to <FANN_QUANT_RANGE> in 32 bits. Weight (r, c) is read at
+	*weights[r * row_step + c * col_step]*, so both neuron and input major
+	layouts go, and written to row r of *out* padded to *out_cols*.
+
+	Returns:
+		The scale, a quantized weight is the weight times it.
+*/
+FANN_EXTERNAL fann_type FANN_API fann_quant_matrix(const fann_type *weights, unsigned int num_rows,
+	unsigned int num_cols, unsigned int row_step, unsigned int col_step, unsigned int weight_bits,
+	void *out, unsigned int out_cols);
+
+/* Function: fann_quant_values
+	Writes *count* values times *scale*, clamped to <FANN_QUANT_RANGE> and
+	rounded half away from zero, to *out* and zeros up to *padded*; every
+	kernel rounds alike.
+*/
+FANN_EXTERNAL void FANN_API fann_quant_values(enum fann_isa_enum isa, const fann_type *values,
+	unsigned int count, unsigned int padded, fann_type scale, short *out);
+
+/* Function: fann_quant_isa
+	The kernel <fann_quant_values> and <fann_quant_dot> take by default:
+	<FANN_ISA_FMA> for the AVX2 integer instructions every CPU with FMA has,
+	when it and <fann_set_isa_limit> allow, and <FANN_ISA_GENERIC> otherwise.
+*/
+FANN_EXTERNAL enum fann_isa_enum FANN_API fann_quant_isa(void);
+
+/* Function: fann_quant_dot
+	The 32 bit sums of the products of *num_rows* rows of *num_cols*
+	quantized weights, as <fann_quant_matrix> writes them, with *values*.
+	*num_cols* is a multiple of <FANN_QUANT_ALIGN>. The AVX2 kernel
+	multiplies and adds pairs of 16 bit integers with pmaddwd, 8 bit weights
+	are widened on the load; all kernels give the same sums.
+*/
+FANN_EXTERNAL void FANN_API fann_quant_dot(enum fann_isa_enum isa, unsigned int weight_bits,
+	const void *weights, unsigned int num_rows, unsigned int num_cols, const short *values, int *sums);
+
+/* Function: fann_quant_dot_batch
+	<fann_quant_dot> for *num_data* rows of values, one every *values_stride*
+	from *values*; the sums of row i go to *sums + i * num_rows*. The AVX2
+	kernel loads every weight once for 4 rows of values.
+*/
+FANN_EXTERNAL void FANN_API fann_quant_dot_batch(enum fann_isa_enum isa, unsigned int weight_bits,
+	const void *weights, unsigned int num_rows, unsigned int num_cols, const short *values,
+	unsigned int values_stride, unsigned int num_data, int *sums);
+
+/* Struct: struct fann_quant_layer
+	The weights of one layer of a <fann_quant>, neuron by neuron.
+*/
+struct fann_quant_layer
+{
+	/* the values of the layer before without its bias, padded */
+	unsigned int num_cols;
+	/* without the bias neuron */
+	unsigned int num_neurons;
+	void *weights;
+	/* the bias weights, added as floats */
+	fann_type *bias;
+	/* an integer sum times step is the sum of the floats */
+	fann_type step;
+	fann_type weight_scale;
+};
+
+/* Struct: struct fann_quant
+	An integer copy of a network of two layers or of three, each fully
+	connected to the one before, for <fann_run_quant>. The inputs and the
+	hidden values are 16 bit integers with one scale each, the weights 16
+	or 8 bit ones with one scale per layer; the sums are 32 bit integers and
+	the activations floats. Quantizing a network takes no training and no
+	data besides the range of its inputs.
+*/
+struct fann_quant
+{
+	unsigned int weight_bits;
+	/* the kernel of the runs, see <fann_quant_isa> */
+	enum fann_isa_enum isa;
+	/* the inputs are scaled by input_scale, see <fann_create_quant> */
+	fann_type max_input;
+	fann_type input_scale;
+	fann_type hidden_scale;
+	unsigned int num_layers;
+	struct fann_quant_layer layers[2];
+};
+
+/* Function: fann_create_quant
+	Quantizes *ann* with *weight_bits* (8 or 16) bit weights for inputs of
+	magnitudes up to *max_input*; the input scale is the power of 2 that
+	takes max_input closest to <FANN_QUANT_RANGE>, so that the 1s and halves
+	of the board encodings stay exact. Returns NULL for other networks than
+	the ones <struct fann_quant> describes, for hidden activations beyond
+	[-1, 1] and without memory. The copy has to be made again after the
+	weights change.
+*/
+FANN_EXTERNAL struct fann_quant *FANN_API fann_create_quant(const struct fann *ann,
+	unsigned int weight_bits, fann_type max_input);
+
+/* Function: fann_destroy_quant
+*/
+FANN_EXTERNAL void FANN_API fann_destroy_quant(struct fann_quant *quant);
+
+/* Function: fann_set_quant_isa
+	Takes the kernel isa, <FANN_ISA_FMA> or <FANN_ISA_GENERIC>, when the
+	CPU has it.
+
+	Returns:
+		The kernel of *quant*.
+*/
+FANN_EXTERNAL enum fann_isa_enum FANN_API fann_set_quant_isa(struct fann_quant *quant,
+	enum fann_isa_enum isa);
+
+/* Function: fann_run_quant
+	Does what <fann_run_context> does with the integer copy *quant* of
+	*ann*; the network gives the activation functions. The outputs differ
+	from those of the floats by the rounding of the weights and values, they
+	do not depend on the kernel.
+*/
+FANN_EXTERNAL fann_type * FANN_API fann_run_quant(const struct fann *ann, const struct fann_quant *quant,
+	struct fann_context *ctx, const fann_type * input);
+
+#endif
+
+#endif	/* __fann_quant_h__ */
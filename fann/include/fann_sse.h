@@ -35,6 +35,22 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */ 
 FANN_EXTERNAL fann_type * FANN_API fann_run_sse(struct fann *ann, const fann_type * input);
 
+#if defined FLOATFANN
+/* Function: fann_run_sse_context
+	Does the same as fann_run_sse but writes into *ctx*, see <fann_run_context>.
+	The buffers of *ctx* have to be aligned as <fann_create_context> does.
+*/
+FANN_EXTERNAL fann_type * FANN_API fann_run_sse_context(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type * input);
+
+/* Function: fann_run_batch_sse
+	<fann_run_batch> with SSE instructions; every layer of the batch is one
+	cache blocked matrix product and the outputs are those of fann_run_sse.
+*/
+FANN_EXTERNAL void FANN_API fann_run_batch_sse(const struct fann *ann, struct fann_context *ctx, 
+	const fann_type *input, unsigned int num_data, unsigned int input_stride, fann_type *output);
+#endif
+
 /* Function: fann_test_sse
    Test with a set of inputs, and a set of desired outputs.
    This operation updates the mean square error, but does not
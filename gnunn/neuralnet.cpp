@@ -31,42 +31,6 @@
 #include "sse.h"
 #include "sigmoid.h"
 
-/* separate context for race, crashed, contact
-   -1: regular eval
-    0: save base
-    1: from base
- */
-
-static inline NNEvalType NNevalAction(NNState *pnState)
-{
-	if (!pnState)
-		return NNEVAL_NONE;
-
-	switch(pnState->state)
-	{
-    case NNSTATE_NONE:
-    {
-      /* incremental evaluation not useful */
-      return NNEVAL_NONE;
-    }
-    case NNSTATE_INCREMENTAL:
-    {
-      /* next call should return FROMBASE */
-		pnState->state = NNSTATE_DONE;
-      
-      /* starting a new context; save base in the hope it will be useful */
-      return NNEVAL_SAVE;
-    }
-    case NNSTATE_DONE:
-    {
-      /* context hit!  use the previously computed base */
-      return NNEVAL_FROMBASE;
-    }
-	}
-	/* never reached */
-	return NNEVAL_NONE;   /* for the picky compiler */
-}
-
 extern int NeuralNetCreate( neuralnet *pnn, unsigned int cInput, unsigned int cHidden,
 			    unsigned int cOutput, float rBetaHidden,
 			    float rBetaOutput )
@@ -132,6 +96,8 @@ extern void NeuralNetDestroy( neuralnet *pnn )
   }
 }
 
+static void EvaluateOutputs( const neuralnet *pnn, float ar[], float arOutput[] );
+
 static void Evaluate( const neuralnet *pnn, const float arInput[], float ar[],
                         float arOutput[], float *saveAr )
 {
@@ -164,6 +130,16 @@ static void Evaluate( const neuralnet *pnn, const float arInput[], float ar[],
     if( saveAr)
       memcpy( saveAr, ar, cHidden * sizeof( *saveAr));
 
+    EvaluateOutputs( pnn, ar, arOutput );
+}
+
+/* Squashes the hidden sums in ar and calculates the output nodes */
+static void EvaluateOutputs( const neuralnet *pnn, float ar[], float arOutput[] )
+{
+    const unsigned int cHidden = pnn->cHidden;
+    unsigned int i, j;
+    const float *prWeight;
+
     for( i = 0; i < cHidden; i++ )
 		ar[ i ] = sigmoid( -pnn->rBetaHidden * ar[ i ] );
 
@@ -270,6 +246,53 @@ extern int NeuralNetEvaluate( const neuralnet *pnn, float arInput[],
     return 0;
 }
 
+/* Scalar counterpart of NeuralNetEvaluateBatchSSE: cPositions input rows
+ * of cInput floats in, rows of cOutput floats out, the hidden layer of a
+ * block of positions accumulated in one pass over the weights */
+extern int NeuralNetEvaluateBatch( const neuralnet *pnn, const float arInput[],
+			      float arOutput[], unsigned int cPositions )
+{
+    const unsigned int cHidden = pnn->cHidden;
+    const unsigned int cInput = pnn->cInput;
+    float *ar = (float*) alloca(NN_BATCH_BLOCK * cHidden * sizeof(float));
+    unsigned int iFirst, i, j, k;
+
+    for( iFirst = 0; iFirst < cPositions; iFirst += NN_BATCH_BLOCK )
+	{
+        const unsigned int cBlock = cPositions - iFirst < NN_BATCH_BLOCK ? cPositions - iFirst : NN_BATCH_BLOCK;
+        const float *arBlockInput = arInput + iFirst * cInput;
+        const float *prWeight = pnn->arHiddenWeight;
+
+        for( k = 0; k < cBlock; k++ )
+            memcpy( ar + k * cHidden, pnn->arHiddenThreshold, cHidden * sizeof( *ar ) );
+
+        for( i = 0; i < cInput; i++, prWeight += cHidden )
+		{
+            for( k = 0; k < cBlock; k++ )
+			{
+                float const ari = arBlockInput[ k * cInput + i ];
+                float *pr = ar + k * cHidden;
+                const float *pw = prWeight;
+
+                if( !ari )
+                    continue;
+
+                if( ari == 1.0f )
+                    for( j = cHidden; j; j-- )
+                        *pr++ += *pw++;
+                else
+                    for( j = cHidden; j; j-- )
+                        *pr++ += *pw++ * ari;
+            }
+        }
+
+        for( k = 0; k < cBlock; k++ )
+            EvaluateOutputs( pnn, ar + k * cHidden, arOutput + ( iFirst + k ) * pnn->cOutput );
+    }
+
+    return 0;
+}
+
 extern int NeuralNetResize( neuralnet *pnn, unsigned int cInput, unsigned int cHidden,
 			    unsigned int cOutput )
 {
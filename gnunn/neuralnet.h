@@ -39,6 +39,36 @@ struct neuralnet
 	float *arOutputThreshold;
 } ;
 
+/* An integer copy of a network for NeuralNetEvaluateQuant: the inputs and
+   the hidden values are 16 bit integers, the weights 16 or 8 bit ones with
+   one scale per layer, the sums 32 bit integers; see fann_quant.h */
+struct neuralnetquant
+{
+	unsigned int cInput;
+	unsigned int cHidden;
+	unsigned int cOutput;
+	/* the rows of the weights, padded with zeros */
+	unsigned int cInputPadded;
+	unsigned int cHiddenPadded;
+	unsigned int nBits;
+	/* the kernel, an fann_isa_enum */
+	int isa;
+	float rInputScale;
+	float rHiddenScale;
+	/* an integer sum times the step is the sum of the floats */
+	float rHiddenStep;
+	float rOutputStep;
+	float rBetaHidden;
+	float rBetaOutput;
+	void *aHiddenWeight;
+	void *aOutputWeight;
+	float *arHiddenThreshold;
+	float *arOutputThreshold;
+} ;
+
+/* positions whose hidden layers are accumulated together by the batch evaluators */
+#define NN_BATCH_BLOCK 8
+
 enum NNEvalType
 {
 	NNEVAL_NONE,
@@ -60,10 +90,44 @@ struct NNState
 	float *savedIBase;
 };
 
+/* Incremental evaluation of positions that differ in a few inputs, e.g.
+   the candidates of one roll: the first evaluation of a context saves its
+   inputs and hidden sums, the following ones only apply the differences.
+   The state is NNSTATE_INCREMENTAL for a new context, NNSTATE_NONE turns
+   it off. A FROMBASE evaluation overwrites arInput with the differences */
+static inline NNEvalType NNevalAction(NNState *pnState)
+{
+	if (!pnState)
+		return NNEVAL_NONE;
+
+	switch(pnState->state)
+	{
+	case NNSTATE_NONE:
+		/* incremental evaluation not useful */
+		return NNEVAL_NONE;
+	case NNSTATE_INCREMENTAL:
+		/* starting a new context; save base in the hope it will be useful,
+		   the next call should return FROMBASE */
+		pnState->state = NNSTATE_DONE;
+		return NNEVAL_SAVE;
+	case NNSTATE_DONE:
+		/* context hit!  use the previously computed base */
+		return NNEVAL_FROMBASE;
+	}
+	/* never reached */
+	return NNEVAL_NONE;   /* for the picky compiler */
+}
+
 extern int NeuralNetCreate(neuralnet *pnn, unsigned int cInput, unsigned int cHidden, unsigned int cOutput, float rBetaHidden, float rBetaOutput);
 extern void NeuralNetDestroy(neuralnet *pnn);
 extern int NeuralNetEvaluate(const neuralnet *pnn, float arInput[], float arOutput[], NNState *pnState);
 extern int NeuralNetEvaluateSSE(const neuralnet *pnn, float arInput[], float arOutput[], NNState *pnState);
+extern int NeuralNetEvaluateBatch(const neuralnet *pnn, const float arInput[], float arOutput[], unsigned int cPositions);
+extern int NeuralNetEvaluateBatchSSE(const neuralnet *pnn, const float arInput[], float arOutput[], unsigned int cPositions);
+extern int NeuralNetQuantize(const neuralnet *pnn, neuralnetquant *pnq, unsigned int nBits, float rMaxInput);
+extern void NeuralNetQuantDestroy(neuralnetquant *pnq);
+extern int NeuralNetEvaluateQuant(const neuralnetquant *pnq, const float arInput[], float arOutput[]);
+extern int NeuralNetEvaluateBatchQuant(const neuralnetquant *pnq, const float arInput[], float arOutput[], unsigned int cPositions);
 extern int NeuralNetResize(neuralnet *pnn, unsigned int cInput, unsigned int cHidden, unsigned int cOutput);
 extern int NeuralNetLoad(neuralnet *pnn, FILE *pf);
 extern int NeuralNetLoadBinary(neuralnet *pnn, FILE *pf);
@@ -0,0 +1,144 @@
+/*
+ * neuralnetquant.cpp
+ *
+ * Integer evaluation of the networks with the kernels of fann_quant.h
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of version 3 or later of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "BgCommon.h"
+#include <string.h>
+#include <stdlib.h>
+#include <malloc.h>
+
+#include "neuralnet.h"
+#include "sigmoid.h"
+#include "fann_quant.h"
+
+static unsigned int QuantPadded( unsigned int c )
+{
+    return ( c + FANN_QUANT_ALIGN - 1 ) / FANN_QUANT_ALIGN * FANN_QUANT_ALIGN;
+}
+
+/* Quantizes pnn with nBits (8 or 16) bit weights for inputs of magnitudes
+ * up to rMaxInput, larger ones are clamped. Returns 0, or -1 for other bits
+ * and without memory */
+extern int NeuralNetQuantize( const neuralnet *pnn, neuralnetquant *pnq, unsigned int nBits,
+			      float rMaxInput )
+{
+    const size_t cbWeight = nBits / 8;
+
+    memset( pnq, 0, sizeof( *pnq ) );
+    if( ( nBits != 8 && nBits != 16 ) || rMaxInput <= 0.0f )
+		return -1;
+
+    pnq->cInput = pnn->cInput;
+    pnq->cHidden = pnn->cHidden;
+    pnq->cOutput = pnn->cOutput;
+    pnq->cInputPadded = QuantPadded( pnn->cInput );
+    pnq->cHiddenPadded = QuantPadded( pnn->cHidden );
+    pnq->nBits = nBits;
+    pnq->isa = fann_quant_isa();
+    pnq->rBetaHidden = pnn->rBetaHidden;
+    pnq->rBetaOutput = pnn->rBetaOutput;
+
+    /* a power of 2, the 1s and halves of the inputs stay exact */
+    pnq->rInputScale = 1.0f;
+    while( rMaxInput * pnq->rInputScale * 2 <= FANN_QUANT_RANGE )
+		pnq->rInputScale *= 2;
+    while( rMaxInput * pnq->rInputScale > FANN_QUANT_RANGE )
+		pnq->rInputScale /= 2;
+    /* the hidden values are within [0, 1] */
+    pnq->rHiddenScale = FANN_QUANT_RANGE;
+
+    pnq->aHiddenWeight = calloc( (size_t)pnq->cHidden * pnq->cInputPadded, cbWeight );
+    pnq->aOutputWeight = calloc( (size_t)pnq->cOutput * pnq->cHiddenPadded, cbWeight );
+    pnq->arHiddenThreshold = (float *)malloc( pnq->cHidden * sizeof( float ) );
+    pnq->arOutputThreshold = (float *)malloc( pnq->cOutput * sizeof( float ) );
+    if( !pnq->aHiddenWeight || !pnq->aOutputWeight || !pnq->arHiddenThreshold || !pnq->arOutputThreshold )
+	{
+		NeuralNetQuantDestroy( pnq );
+		return -1;
+    }
+
+    /* the hidden weights are stored input by input, the output ones output
+       by output */
+    pnq->rHiddenStep = 1.0f / ( pnq->rInputScale * fann_quant_matrix( pnn->arHiddenWeight, pnn->cHidden,
+		pnn->cInput, 1, pnn->cHidden, nBits, pnq->aHiddenWeight, pnq->cInputPadded ) );
+    pnq->rOutputStep = 1.0f / ( pnq->rHiddenScale * fann_quant_matrix( pnn->arOutputWeight, pnn->cOutput,
+		pnn->cHidden, pnn->cHidden, 1, nBits, pnq->aOutputWeight, pnq->cHiddenPadded ) );
+    memcpy( pnq->arHiddenThreshold, pnn->arHiddenThreshold, pnq->cHidden * sizeof( float ) );
+    memcpy( pnq->arOutputThreshold, pnn->arOutputThreshold, pnq->cOutput * sizeof( float ) );
+
+    return 0;
+}
+
+extern void NeuralNetQuantDestroy( neuralnetquant *pnq )
+{
+    free( pnq->aHiddenWeight ); pnq->aHiddenWeight = 0;
+    free( pnq->aOutputWeight ); pnq->aOutputWeight = 0;
+    free( pnq->arHiddenThreshold ); pnq->arHiddenThreshold = 0;
+    free( pnq->arOutputThreshold ); pnq->arOutputThreshold = 0;
+}
+
+/* NeuralNetEvaluate with the integer copy; the outputs differ from those of
+ * the floats by the rounding of the weights and values only */
+extern int NeuralNetEvaluateQuant( const neuralnetquant *pnq, const float arInput[], float arOutput[] )
+{
+    return NeuralNetEvaluateBatchQuant( pnq, arInput, arOutput, 1 );
+}
+
+/* NeuralNetEvaluateBatch with the integer copy, the positions of a block
+ * share the loads of the weights */
+extern int NeuralNetEvaluateBatchQuant( const neuralnetquant *pnq, const float arInput[],
+				   float arOutput[], unsigned int cPositions )
+{
+    const unsigned int cHidden = pnq->cHidden;
+    const unsigned int cInput = pnq->cInput;
+    const unsigned int cOutput = pnq->cOutput;
+    const enum fann_isa_enum isa = (enum fann_isa_enum)pnq->isa;
+    short *anInput = (short*) alloca( NN_BATCH_BLOCK * pnq->cInputPadded * sizeof( short ) );
+    short *anHidden = (short*) alloca( NN_BATCH_BLOCK * pnq->cHiddenPadded * sizeof( short ) );
+    int *anSum = (int*) alloca( NN_BATCH_BLOCK * ( cHidden > cOutput ? cHidden : cOutput ) * sizeof( int ) );
+    float *ar = (float*) alloca( cHidden * sizeof( float ) );
+    unsigned int iFirst, i, k;
+
+    for( iFirst = 0; iFirst < cPositions; iFirst += NN_BATCH_BLOCK )
+	{
+        const unsigned int cBlock = cPositions - iFirst < NN_BATCH_BLOCK ? cPositions - iFirst : NN_BATCH_BLOCK;
+
+        for( k = 0; k < cBlock; k++ )
+            fann_quant_values( isa, arInput + ( iFirst + k ) * cInput, cInput, pnq->cInputPadded,
+				pnq->rInputScale, anInput + k * pnq->cInputPadded );
+        fann_quant_dot_batch( isa, pnq->nBits, pnq->aHiddenWeight, cHidden, pnq->cInputPadded,
+			anInput, pnq->cInputPadded, cBlock, anSum );
+
+        for( k = 0; k < cBlock; k++ )
+		{
+            const int *anHiddenSum = anSum + k * cHidden;
+            for( i = 0; i < cHidden; i++ )
+                ar[ i ] = sigmoid( -pnq->rBetaHidden * ( pnq->arHiddenThreshold[ i ] + pnq->rHiddenStep * anHiddenSum[ i ] ) );
+            fann_quant_values( isa, ar, cHidden, pnq->cHiddenPadded, pnq->rHiddenScale, anHidden + k * pnq->cHiddenPadded );
+        }
+        fann_quant_dot_batch( isa, pnq->nBits, pnq->aOutputWeight, cOutput, pnq->cHiddenPadded,
+			anHidden, pnq->cHiddenPadded, cBlock, anSum );
+
+        for( k = 0; k < cBlock; k++ )
+            for( i = 0; i < cOutput; i++ )
+                arOutput[ ( iFirst + k ) * cOutput + i ] = sigmoid( -pnq->rBetaOutput *
+					( pnq->arOutputThreshold[ i ] + pnq->rOutputStep * anSum[ k * cOutput + i ] ) );
+    }
+
+    return 0;
+}
@@ -31,6 +31,7 @@
 #include <emmintrin.h> 
 
 #include "sigmoid.h"
+#include "../BgCommon.h"
 
 
 float *sse_malloc(size_t size)
@@ -43,6 +44,36 @@ void sse_free(float* ptr)
 	_mm_free(ptr);
 }
 
+/* Activation scratch of the evaluations, one set per thread. The buffers
+ * only grow, so once a thread has evaluated its largest net it does not
+ * allocate any more */
+static BG_THREAD_LOCAL float *s_arHidden;
+static BG_THREAD_LOCAL unsigned int s_cHidden;
+static BG_THREAD_LOCAL unsigned int *s_aiNonZero;
+static BG_THREAD_LOCAL unsigned int s_cNonZero;
+
+static float *HiddenScratch(unsigned int c)
+{
+    if (c > s_cHidden)
+    {
+        sse_free(s_arHidden);
+        s_arHidden = sse_malloc(c * sizeof(float));
+        s_cHidden = c;
+    }
+    return s_arHidden;
+}
+
+static unsigned int *NonZeroScratch(unsigned int c)
+{
+    if (c > s_cNonZero)
+    {
+        free(s_aiNonZero);
+        s_aiNonZero = (unsigned int *)malloc(c * sizeof(unsigned int));
+        s_cNonZero = c;
+    }
+    return s_aiNonZero;
+}
+
 #include <stdint.h>
 
 static const union {
@@ -92,6 +123,9 @@ static inline __m128 sigmoid_ps( __m128 xin )
 	return _mm_or_ps( _mm_and_ps(  mask, c ) , _mm_andnot_ps ( mask , _mm_sub_ps( ones.ps, c )));
 }
 
+static void
+EvaluateOutputsSSE( const neuralnet *pnn, float ar[], float arOutput[] );
+
 static void
 EvaluateSSE( const neuralnet *pnn, const float arInput[], float ar[],
                         float arOutput[], float *saveAr ) {
@@ -99,7 +133,6 @@ EvaluateSSE( const neuralnet *pnn, const float arInput[], float ar[],
     const unsigned int cHidden = pnn->cHidden;
     unsigned int i, j;
     float *prWeight;
-    float *par;
     __m128 vec0, vec1, vec3, scalevec, sum;
     
     /* Calculate activity at hidden nodes */
@@ -143,7 +176,20 @@ EvaluateSSE( const neuralnet *pnn, const float arInput[], float ar[],
 
     if( saveAr)
       memcpy( saveAr, ar, cHidden * sizeof( *saveAr));
-    
+
+    EvaluateOutputsSSE( pnn, ar, arOutput );
+}
+
+/* Squashes the hidden sums in ar and calculates the output nodes */
+static void
+EvaluateOutputsSSE( const neuralnet *pnn, float ar[], float arOutput[] ) {
+
+    const unsigned int cHidden = pnn->cHidden;
+    unsigned int i, j;
+    float *prWeight;
+    float *par;
+    __m128 vec0, vec1, vec3, scalevec, sum;
+
 	scalevec = _mm_set1_ps(pnn->rBetaHidden);
 	for (par = ar, i = (cHidden >> 2); i; i--, par += 4) {
 		__m128 vec = _mm_load_ps(par);
@@ -179,10 +225,64 @@ EvaluateSSE( const neuralnet *pnn, const float arInput[], float ar[],
 }
 
 
+/* Adds the weights of the cChanged inputs listed in aiChanged, times
+ * their differences in arInputDif, to the saved hidden sums in ar and
+ * calculates the outputs. The sums of a panel of 16 hidden nodes stay in
+ * registers while all changed inputs are applied */
+static void
+EvaluateFromBaseSSE( const neuralnet *pnn, const float arInputDif[], const unsigned int aiChanged[],
+		     unsigned int cChanged, float ar[], float arOutput[] ) {
+
+    const unsigned int cHidden = pnn->cHidden;
+    unsigned int j, l, n;
+
+    for (j = 0; j < cHidden; j += 16)
+    {
+        const float *prWeight = pnn->arHiddenWeight + j;
+        float *pr = ar + j;
+
+        if (cHidden - j >= 16)
+        {
+            __m128 sum0 = _mm_load_ps(pr);
+            __m128 sum1 = _mm_load_ps(pr + 4);
+            __m128 sum2 = _mm_load_ps(pr + 8);
+            __m128 sum3 = _mm_load_ps(pr + 12);
+
+            for (n = 0; n < cChanged; n++)
+            {
+                const float *pw = prWeight + aiChanged[n] * cHidden;
+                __m128 scalevec = _mm_set1_ps(arInputDif[aiChanged[n]]);
+                sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_load_ps(pw), scalevec));
+                sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_load_ps(pw + 4), scalevec));
+                sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_load_ps(pw + 8), scalevec));
+                sum3 = _mm_add_ps(sum3, _mm_mul_ps(_mm_load_ps(pw + 12), scalevec));
+            }
+
+            _mm_store_ps(pr, sum0);
+            _mm_store_ps(pr + 4, sum1);
+            _mm_store_ps(pr + 8, sum2);
+            _mm_store_ps(pr + 12, sum3);
+        }
+        else
+        {
+            /* the last, narrower panel */
+            for (n = 0; n < cChanged; n++)
+            {
+                const float *pw = prWeight + aiChanged[n] * cHidden;
+                __m128 scalevec = _mm_set1_ps(arInputDif[aiChanged[n]]);
+                for (l = 0; l < cHidden - j; l += 4)
+                    _mm_store_ps(pr + l, _mm_add_ps(_mm_load_ps(pr + l), _mm_mul_ps(_mm_load_ps(pw + l), scalevec)));
+            }
+        }
+    }
+
+    EvaluateOutputsSSE( pnn, ar, arOutput );
+}
+
 extern int NeuralNetEvaluateSSE(const neuralnet *pnn, /*lint -e{818}*/ float arInput[],
 			      float arOutput[], NNState *pnState)
 {
-    float *ar = sse_malloc(pnn->cHidden * sizeof(float));
+    float *ar = HiddenScratch(pnn->cHidden);
 
 //#if DEBUG_SSE
 	/* Not 64bit robust (pointer truncation) - causes strange crash */
@@ -190,8 +290,145 @@ extern int NeuralNetEvaluateSSE(const neuralnet *pnn, /*lint -e{818}*/ float arI
     assert(sse_aligned(arInput));
 //#endif
 
-	EvaluateSSE(pnn, arInput, ar, arOutput, 0);
-	sse_free(ar);
+    switch( NNevalAction(pnState) ) 
+	{
+	case NNEVAL_NONE:
+		EvaluateSSE(pnn, arInput, ar, arOutput, 0);
+		break;
+	case NNEVAL_SAVE:
+		memcpy(pnState->savedIBase, arInput, pnn->cInput * sizeof(*ar));
+		EvaluateSSE(pnn, arInput, ar, arOutput, pnState->savedBase);
+		break;
+	case NNEVAL_FROMBASE:
+	{
+		unsigned int i, n;
+		unsigned int *aiChanged = NonZeroScratch(pnn->cInput);
+		float *r = arInput;
+		const float *s = pnState->savedIBase;
+
+		memcpy(ar, pnState->savedBase, pnn->cHidden * sizeof(*ar));
+		for (i = 0, n = 0; i < pnn->cInput; ++i, ++r, ++s)
+		{
+			if (*r != *s)
+			{
+				*r -= *s;
+				aiChanged[n++] = i;
+			}
+			else
+				*r = 0.0f;
+		}
+		EvaluateFromBaseSSE(pnn, arInput, aiChanged, n, ar, arOutput);
+		break;
+	}
+	}
     return 0;
 }
 
+/* Evaluates cPositions input vectors of cInput floats stored one after
+ * another into rows of cOutput floats, one matrix-matrix pass per block of
+ * positions. The hidden layer is computed in panels of 16 hidden nodes kept
+ * in registers: a panel touches one cache line per weight row, so it stays
+ * in L1 while the nonzero inputs of all positions of the block are applied.
+ * Each sum is formed in the same order as in EvaluateSSE, the outputs are
+ * identical to those of NeuralNetEvaluateSSE */
+extern int NeuralNetEvaluateBatchSSE(const neuralnet *pnn, const float arInput[],
+			      float arOutput[], unsigned int cPositions)
+{
+    const unsigned int cHidden = pnn->cHidden;
+    const unsigned int cInput = pnn->cInput;
+    float *ar = HiddenScratch(NN_BATCH_BLOCK * cHidden);
+    unsigned int *aiNonZero = NonZeroScratch(NN_BATCH_BLOCK * cInput);
+    unsigned int acNonZero[NN_BATCH_BLOCK];
+    unsigned int iFirst, i, j, k, n;
+
+    for (iFirst = 0; iFirst < cPositions; iFirst += NN_BATCH_BLOCK)
+    {
+        const unsigned int cBlock = cPositions - iFirst < NN_BATCH_BLOCK ? cPositions - iFirst : NN_BATCH_BLOCK;
+        const float *arBlockInput = arInput + iFirst * cInput;
+
+        for (k = 0; k < cBlock; k++)
+        {
+            const float *arRow = arBlockInput + k * cInput;
+            unsigned int *ai = aiNonZero + k * cInput;
+
+            for (n = 0, i = 0; i < cInput; i++)
+                if (arRow[i])
+                    ai[n++] = i;
+            acNonZero[k] = n;
+        }
+
+        for (j = 0; j < cHidden; j += 16)
+        {
+            const float *prWeight = pnn->arHiddenWeight + j;
+            const unsigned int cPanel = cHidden - j < 16 ? (cHidden - j) >> 2 : 4;
+
+            for (k = 0; k < cBlock; k++)
+            {
+                const float *arRow = arBlockInput + k * cInput;
+                const unsigned int *ai = aiNonZero + k * cInput;
+                float *pr = ar + k * cHidden + j;
+
+                if (cPanel == 4)
+                {
+                    __m128 sum0 = _mm_load_ps(pnn->arHiddenThreshold + j);
+                    __m128 sum1 = _mm_load_ps(pnn->arHiddenThreshold + j + 4);
+                    __m128 sum2 = _mm_load_ps(pnn->arHiddenThreshold + j + 8);
+                    __m128 sum3 = _mm_load_ps(pnn->arHiddenThreshold + j + 12);
+
+                    for (n = acNonZero[k]; n; n--, ai++)
+                    {
+                        float const ari = arRow[*ai];
+                        const float *pw = prWeight + *ai * cHidden;
+
+                        if (ari == 1.0f)
+                        {
+                            sum0 = _mm_add_ps(sum0, _mm_load_ps(pw));
+                            sum1 = _mm_add_ps(sum1, _mm_load_ps(pw + 4));
+                            sum2 = _mm_add_ps(sum2, _mm_load_ps(pw + 8));
+                            sum3 = _mm_add_ps(sum3, _mm_load_ps(pw + 12));
+                        }
+                        else
+                        {
+                            __m128 scalevec = _mm_set1_ps(ari);
+                            sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_load_ps(pw), scalevec));
+                            sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_load_ps(pw + 4), scalevec));
+                            sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_load_ps(pw + 8), scalevec));
+                            sum3 = _mm_add_ps(sum3, _mm_mul_ps(_mm_load_ps(pw + 12), scalevec));
+                        }
+                    }
+
+                    _mm_store_ps(pr, sum0);
+                    _mm_store_ps(pr + 4, sum1);
+                    _mm_store_ps(pr + 8, sum2);
+                    _mm_store_ps(pr + 12, sum3);
+                }
+                else
+                {
+                    /* the last, narrower panel */
+                    unsigned int l;
+
+                    memcpy(pr, pnn->arHiddenThreshold + j, cPanel * 4 * sizeof(float));
+                    for (n = acNonZero[k]; n; n--, ai++)
+                    {
+                        float const ari = arRow[*ai];
+                        const float *pw = prWeight + *ai * cHidden;
+                        __m128 scalevec = _mm_set1_ps(ari);
+
+                        for (l = 0; l < cPanel * 4; l += 4)
+                        {
+                            if (ari == 1.0f)
+                                _mm_store_ps(pr + l, _mm_add_ps(_mm_load_ps(pr + l), _mm_load_ps(pw + l)));
+                            else
+                                _mm_store_ps(pr + l, _mm_add_ps(_mm_load_ps(pr + l), _mm_mul_ps(_mm_load_ps(pw + l), scalevec)));
+                        }
+                    }
+                }
+            }
+        }
+
+        for (k = 0; k < cBlock; k++)
+            EvaluateOutputsSSE(pnn, ar + k * cHidden, arOutput + (iFirst + k) * pnn->cOutput);
+    }
+
+    return 0;
+}